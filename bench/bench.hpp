@@ -0,0 +1,89 @@
+﻿//  unicode/bench/bench.hpp  -----------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Common benchmark support. Every benchmark is registered with apply_corpora(), and   //
+//  so runs once for each corpus and size, or, if it measures per-call overhead on      //
+//  short strings, with apply_short_corpora(). Each reports, in addition to the usual   //
+//  Google Benchmark time columns:                                                      //
+//                                                                                      //
+//    bytes_per_second   input code units consumed, in bytes                            //
+//    code_points        input code points consumed per second                          //
+//    allocs             heap allocations per iteration                                 //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_BENCH_BENCH_HPP)
+#define BOOST_UNICODE_BENCH_BENCH_HPP
+
+#include "corpus.hpp"
+#include <benchmark/benchmark.h>
+#include <cstddef>
+#include <cstdint>
+
+namespace bench
+{
+  //  number of calls to the global operator new so far; see alloc_counter.cpp
+  std::uint64_t allocations() noexcept;
+
+  //  corpus sizes, in code points
+  constexpr std::size_t short_size = 20;
+  constexpr std::size_t small_size = 64;
+  constexpr std::size_t medium_size = 4 * 1024;
+  constexpr std::size_t large_size = 1024 * 1024;
+
+  inline void apply_corpora(benchmark::internal::Benchmark* b)
+  {
+    b->ArgNames({"corpus", "cps"});
+    for (int m = 0; m <= static_cast<int>(mix::errors); ++m)
+      for (std::size_t size : {small_size, medium_size, large_size})
+        b->Args({m, static_cast<std::int64_t>(size)});
+  }
+
+  //  for benchmarks of per-call overhead, such as allocations, on short strings
+  inline void apply_short_corpora(benchmark::internal::Benchmark* b)
+  {
+    b->ArgNames({"corpus", "cps"});
+    for (int m = 0; m <= static_cast<int>(mix::errors); ++m)
+      for (std::size_t size : {short_size, small_size})
+        b->Args({m, static_cast<std::int64_t>(size)});
+  }
+
+  inline const corpus& get_corpus(const benchmark::State& state)
+  {
+    return get_corpus(static_cast<mix>(state.range(0)),
+      static_cast<std::size_t>(state.range(1)));
+  }
+
+  //  measures allocations over the timing loop; construct immediately before it
+  class reporter
+  {
+  public:
+    explicit reporter(benchmark::State& state)
+      : state_(state), start_(allocations()) {}
+
+    void report(std::size_t bytes, std::size_t code_points)
+    {
+      std::uint64_t allocs = allocations() - start_;
+      auto iterations = static_cast<std::int64_t>(state_.iterations());
+      state_.SetBytesProcessed(iterations * static_cast<std::int64_t>(bytes));
+      state_.counters["code_points"] = benchmark::Counter(
+        static_cast<double>(iterations) * code_points, benchmark::Counter::kIsRate);
+      state_.counters["allocs"] = benchmark::Counter(static_cast<double>(allocs),
+        benchmark::Counter::kAvgIterations);
+      state_.SetLabel(mix_name(static_cast<mix>(state_.range(0))));
+    }
+
+  private:
+    benchmark::State&  state_;
+    std::uint64_t      start_;
+  };
+
+}  // namespace bench
+
+#endif  // BOOST_UNICODE_BENCH_BENCH_HPP
@@ -0,0 +1,305 @@
+﻿//  unicode/bench/corpus.hpp  ----------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Deterministic synthetic corpora for benchmarks and tests.                           //
+//                                                                                      //
+//  A corpus_spec describes the mix of scripts, how many code points in a row are      //
+//  drawn from the same script, and the density and kinds of errors. generate()         //
+//  produces the same text from the same spec on every platform, in all four            //
+//  encodings, so that throughput can be compared per distribution.                     //
+//                                                                                      //
+//  Each error is one ill-formed sequence in every encoding, and so becomes exactly     //
+//  one U+FFFD when recoded. UTF-16 and UTF-32 cannot express every kind of error, so   //
+//  they use the nearest equivalent:                                                    //
+//                                                                                      //
+//    kind           UTF-8             UTF-16                 UTF-32                    //
+//    truncated      missing last      unpaired high          surrogate                 //
+//                   continuation      surrogate                                        //
+//    overlong       C0-C1 or E0 80-9F unpaired high          out of range              //
+//    surrogate      ED A0-BF          unpaired low           surrogate                 //
+//    out_of_range   F4 90-BF          unpaired high          out of range              //
+//                                                                                      //
+//  Two errors are never adjacent, so unpaired surrogates can never pair up.            //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_BENCH_CORPUS_HPP)
+#define BOOST_UNICODE_BENCH_CORPUS_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cwchar>
+#include <map>
+#include <random>
+#include <string>
+#include <utility>
+
+namespace bench
+{
+  enum class script { ascii, latin1, cyrillic, cjk, supplementary };
+  constexpr std::size_t script_count = 5;
+
+  enum class error_kind { truncated, overlong, surrogate, out_of_range };
+  constexpr std::size_t error_kind_count = 4;
+
+  inline const char* script_name(script s)
+  {
+    static const char* const names[]
+      = { "ascii", "latin1", "cyrillic", "cjk", "supplementary" };
+    return names[static_cast<int>(s)];
+  }
+
+  inline const char* error_kind_name(error_kind k)
+  {
+    static const char* const names[]
+      = { "truncated", "overlong", "surrogate", "out_of_range" };
+    return names[static_cast<int>(k)];
+  }
+
+  struct corpus_spec
+  {
+    std::array<unsigned, script_count>      script_weights = {{1, 0, 0, 0, 0}};
+    std::size_t                             code_points = 0;
+    std::size_t                             min_run = 1;   // code points in a row
+    std::size_t                             max_run = 1;   //   from one script
+    double                                  error_rate = 0.0;  // per code point
+    std::array<unsigned, error_kind_count>  error_weights = {{1, 1, 1, 1}};
+    std::uint32_t                           seed = 1;
+  };
+
+  struct corpus
+  {
+    std::string     utf8;
+    std::u16string  utf16;
+    std::u32string  utf32;
+    std::wstring    wide;
+    std::size_t     code_points;  // including errors
+    std::size_t     errors;
+  };
+
+  namespace detail
+  {
+    //  std::uniform_int_distribution differs between standard libraries, so the
+    //  range reduction is done here to keep corpora identical everywhere
+    class random
+    {
+    public:
+      explicit random(std::uint32_t seed) : rng_(seed) {}
+
+      //  returns: a value in [0, n)
+      std::uint32_t below(std::uint32_t n)
+      {
+        return static_cast<std::uint32_t>(
+          (static_cast<std::uint64_t>(rng_()) * n) >> 32);
+      }
+      //  returns: a value in [lo, hi]
+      std::uint32_t between(std::uint32_t lo, std::uint32_t hi)
+      {
+        return lo + below(hi - lo + 1);
+      }
+      //  returns: a value in [0, 1)
+      double fraction() { return rng_() / 4294967296.0; }
+
+      //  returns: an index chosen in proportion to the weights
+      template <std::size_t N>
+      std::size_t weighted(const std::array<unsigned, N>& weights)
+      {
+        std::uint32_t total = 0;
+        for (unsigned w : weights)
+          total += w;
+        std::uint32_t x = below(total);
+        std::size_t i = 0;
+        for (; x >= weights[i]; ++i)
+          x -= weights[i];
+        return i;
+      }
+
+    private:
+      std::mt19937 rng_;
+    };
+
+    inline char32_t pick(random& rng, script s)
+    {
+      switch (s)
+      {
+      case script::ascii:         return rng.between(0x20, 0x7E);
+      case script::latin1:        return rng.between(0xA0, 0xFF);
+      case script::cyrillic:      return rng.between(0x400, 0x4FF);
+      case script::cjk:           return rng.between(0x4E00, 0x9FFF);
+      default:                    return rng.between(0x1F300, 0x1F64F);
+      }
+    }
+
+    inline void append_utf8_error(std::string& s, error_kind k, random& rng)
+    {
+      switch (k)
+      {
+      case error_kind::truncated:
+        {
+          std::string cp = boost::unicode::to_string<boost::unicode::utf8>(
+            std::u32string(1, pick(rng, rng.below(2) ? script::cjk : script::cyrillic)));
+          cp.pop_back();
+          s += cp;
+        }
+        break;
+      case error_kind::overlong:
+        if (rng.below(2))
+        {
+          s += static_cast<char>(rng.between(0xC0, 0xC1));
+          s += static_cast<char>(rng.between(0x80, 0xBF));
+        }
+        else
+        {
+          s += '\xE0';
+          s += static_cast<char>(rng.between(0x80, 0x9F));
+          s += static_cast<char>(rng.between(0x80, 0xBF));
+        }
+        break;
+      case error_kind::surrogate:
+        s += '\xED';
+        s += static_cast<char>(rng.between(0xA0, 0xBF));
+        s += static_cast<char>(rng.between(0x80, 0xBF));
+        break;
+      default:  // out_of_range
+        s += '\xF4';
+        s += static_cast<char>(rng.between(0x90, 0xBF));
+        s += static_cast<char>(rng.between(0x80, 0xBF));
+        s += static_cast<char>(rng.between(0x80, 0xBF));
+        break;
+      }
+    }
+
+    inline char16_t utf16_error(error_kind k, random& rng)
+    {
+      return static_cast<char16_t>(k == error_kind::surrogate
+        ? rng.between(0xDC00, 0xDFFF) : rng.between(0xD800, 0xDBFF));
+    }
+
+    inline char32_t utf32_error(error_kind k, random& rng)
+    {
+      return (k == error_kind::truncated || k == error_kind::surrogate)
+        ? rng.between(0xD800, 0xDFFF) : rng.between(0x110000, 0x1FFFFF);
+    }
+  }  // namespace detail
+
+  inline corpus generate(const corpus_spec& spec)
+  {
+    detail::random rng(spec.seed);
+    corpus c;
+    c.code_points = spec.code_points;
+    c.errors = 0;
+
+    std::u32string valid;  // valid code points not yet appended
+    auto flush = [&]()
+    {
+      c.utf8 += boost::unicode::to_string<boost::unicode::utf8>(valid);
+      c.utf16 += boost::unicode::to_string<boost::unicode::utf16>(valid);
+      c.utf32 += valid;
+      c.wide += boost::unicode::to_string<boost::unicode::wide>(valid);
+      valid.clear();
+    };
+
+    script current = script::ascii;
+    std::size_t run = 0;
+    bool previous_was_error = false;
+
+    for (std::size_t i = 0; i < spec.code_points; ++i)
+    {
+      if (spec.error_rate > 0.0 && !previous_was_error
+        && rng.fraction() < spec.error_rate)
+      {
+        flush();
+        auto k = static_cast<error_kind>(rng.weighted(spec.error_weights));
+        detail::append_utf8_error(c.utf8, k, rng);
+        c.utf16 += detail::utf16_error(k, rng);
+        c.utf32 += detail::utf32_error(k, rng);
+#     if WCHAR_MAX >= 0x1FFFFFFFu
+        c.wide += static_cast<wchar_t>(detail::utf32_error(k, rng));
+#     else
+        c.wide += static_cast<wchar_t>(detail::utf16_error(k, rng));
+#     endif
+        ++c.errors;
+        previous_was_error = true;
+        continue;
+      }
+      previous_was_error = false;
+      if (run == 0)
+      {
+        current = static_cast<script>(rng.weighted(spec.script_weights));
+        run = rng.between(static_cast<std::uint32_t>(spec.min_run),
+          static_cast<std::uint32_t>(spec.max_run));
+      }
+      --run;
+      valid += detail::pick(rng, current);
+    }
+    flush();
+    return c;
+  }
+
+  //  benchmark presets  ---------------------------------------------------------------//
+
+  enum class mix { ascii, latin, cjk, emoji, mixed, errors };
+
+  inline const char* mix_name(mix m)
+  {
+    static const char* const names[]
+      = { "ascii", "latin", "cjk", "emoji", "mixed", "errors" };
+    return names[static_cast<int>(m)];
+  }
+
+  inline corpus_spec preset(mix m, std::size_t code_points)
+  {
+    corpus_spec spec;
+    spec.code_points = code_points;
+    spec.seed = static_cast<std::uint32_t>(m) * 7919u + 1u;
+    switch (m)
+    {
+    case mix::ascii:  spec.script_weights = {{1, 0, 0, 0, 0}}; break;
+    case mix::latin:  spec.script_weights = {{80, 20, 0, 0, 0}}; break;
+    case mix::cjk:    spec.script_weights = {{10, 0, 0, 90, 0}}; break;
+    case mix::emoji:  spec.script_weights = {{50, 0, 0, 0, 50}}; break;
+    default:  // mixed and errors: short runs of several scripts, like real text
+      spec.script_weights = {{40, 5, 15, 25, 15}};
+      spec.min_run = 1;
+      spec.max_run = 12;
+      if (m == mix::errors)
+        spec.error_rate = 0.01;
+      break;
+    }
+    return spec;
+  }
+
+  inline corpus make_corpus(mix m, std::size_t code_points)
+  {
+    return generate(preset(m, code_points));
+  }
+
+  //  corpora are expensive to generate, so are cached for the life of the program
+  inline const corpus& get_corpus(mix m, std::size_t code_points)
+  {
+    static std::map<std::pair<mix, std::size_t>, corpus> cache;
+    auto key = std::make_pair(m, code_points);
+    auto it = cache.find(key);
+    if (it == cache.end())
+      it = cache.emplace(key, make_corpus(m, code_points)).first;
+    return it->second;
+  }
+
+  //  the corpus text in a given encoding
+  inline const std::string&    text(const corpus& c, boost::unicode::utf8)  { return c.utf8; }
+  inline const std::string&    text(const corpus& c, boost::unicode::narrow){ return c.utf8; }
+  inline const std::u16string& text(const corpus& c, boost::unicode::utf16) { return c.utf16; }
+  inline const std::u32string& text(const corpus& c, boost::unicode::utf32) { return c.utf32; }
+  inline const std::wstring&   text(const corpus& c, boost::unicode::wide)  { return c.wide; }
+
+}  // namespace bench
+
+#endif  // BOOST_UNICODE_BENCH_CORPUS_HPP
@@ -0,0 +1,181 @@
+﻿//  unicode/bench/corpus_gen.cpp  ------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Writes a synthetic corpus to a file, so that other tools can be measured against
+//  exactly the text the benchmarks use. UTF-16, UTF-32, and wide output is in native
+//  byte order, without a BOM.
+
+#include "corpus.hpp"
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <boost/detail/lightweight_main.hpp>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace
+{
+  const char* const usage =
+    "Invoke: corpus_gen [options] <output-path>\n"
+    "Options:\n"
+    "  --encoding=utf8|utf16|utf32|wide   default utf8\n"
+    "  --preset=ascii|latin|cjk|emoji|mixed|errors\n"
+    "                                     start from a benchmark corpus\n"
+    "  --code-points=<n>                  default 1048576\n"
+    "  --scripts=<script>:<weight>,...    ascii, latin1, cyrillic, cjk, supplementary\n"
+    "  --run=<min>-<max>                  code points in a row from one script\n"
+    "  --errors=<rate>                    errors per code point, e.g. 0.01\n"
+    "  --error-kinds=<kind>:<weight>,...  truncated, overlong, surrogate, out_of_range\n"
+    "  --seed=<n>\n";
+
+  //  parses "name:weight,name:weight,..." into weights, indexed by position in names
+  template <std::size_t N>
+  bool parse_weights(const string& arg, const char* (*name)(int),
+    std::array<unsigned, N>& weights)
+  {
+    weights.fill(0);
+    for (std::size_t pos = 0; pos < arg.size();)
+    {
+      std::size_t comma = arg.find(',', pos);
+      if (comma == string::npos)
+        comma = arg.size();
+      string item = arg.substr(pos, comma - pos);
+      std::size_t colon = item.find(':');
+      string key = item.substr(0, colon);
+      unsigned weight = colon == string::npos
+        ? 1 : static_cast<unsigned>(std::strtoul(item.c_str() + colon + 1, nullptr, 10));
+
+      std::size_t i = 0;
+      for (; i < N && key != name(static_cast<int>(i)); ++i) {}
+      if (i == N)
+      {
+        cerr << "Unknown name: " << key << endl;
+        return false;
+      }
+      weights[i] = weight;
+      pos = comma + 1;
+    }
+    for (unsigned w : weights)
+      if (w)
+        return true;
+    cerr << "At least one weight must be non-zero: " << arg << endl;
+    return false;
+  }
+
+  const char* script_at(int i)  { return bench::script_name(static_cast<bench::script>(i)); }
+  const char* kind_at(int i)    { return bench::error_kind_name(static_cast<bench::error_kind>(i)); }
+
+  template <class String>
+  bool write(const string& path, const String& s)
+  {
+    std::ofstream out(path, std::ios_base::binary);
+    out.write(reinterpret_cast<const char*>(s.data()), s.size() * sizeof(s[0]));
+    return out.good();
+  }
+}
+
+int cpp_main(int argc, char* argv[])
+{
+  bench::corpus_spec spec;
+  spec.code_points = 1024 * 1024;
+  string encoding("utf8");
+  string output_path;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    string arg(argv[i]);
+    std::size_t eq = arg.find('=');
+    string option = arg.substr(0, eq);
+    string value = eq == string::npos ? string() : arg.substr(eq + 1);
+
+    if (option == "--encoding")
+      encoding = value;
+    else if (option == "--preset")
+    {
+      int m = 0;
+      for (; m <= static_cast<int>(bench::mix::errors)
+        && value != bench::mix_name(static_cast<bench::mix>(m)); ++m) {}
+      if (m > static_cast<int>(bench::mix::errors))
+      {
+        cerr << "Unknown preset: " << value << endl;
+        return 1;
+      }
+      spec = bench::preset(static_cast<bench::mix>(m), spec.code_points);
+    }
+    else if (option == "--code-points")
+      spec.code_points = std::strtoull(value.c_str(), nullptr, 10);
+    else if (option == "--scripts")
+    {
+      if (!parse_weights(value, script_at, spec.script_weights))
+        return 1;
+    }
+    else if (option == "--run")
+    {
+      char* end;
+      spec.min_run = std::strtoull(value.c_str(), &end, 10);
+      spec.max_run = *end == '-' ? std::strtoull(end + 1, nullptr, 10) : spec.min_run;
+      if (spec.min_run == 0 || spec.max_run < spec.min_run)
+      {
+        cerr << "Invalid run: " << value << endl;
+        return 1;
+      }
+    }
+    else if (option == "--errors")
+      spec.error_rate = std::strtod(value.c_str(), nullptr);
+    else if (option == "--error-kinds")
+    {
+      if (!parse_weights(value, kind_at, spec.error_weights))
+        return 1;
+    }
+    else if (option == "--seed")
+      spec.seed = static_cast<std::uint32_t>(std::strtoul(value.c_str(), nullptr, 10));
+    else if (arg.compare(0, 2, "--") != 0 && output_path.empty())
+      output_path = arg;
+    else
+    {
+      cerr << "Unknown option: " << arg << '\n' << usage;
+      return 1;
+    }
+  }
+
+  if (output_path.empty())
+  {
+    cerr << usage;
+    return 1;
+  }
+
+  bench::corpus c = bench::generate(spec);
+
+  bool ok;
+  if (encoding == "utf8")
+    ok = write(output_path, c.utf8);
+  else if (encoding == "utf16")
+    ok = write(output_path, c.utf16);
+  else if (encoding == "utf32")
+    ok = write(output_path, c.utf32);
+  else if (encoding == "wide")
+    ok = write(output_path, c.wide);
+  else
+  {
+    cerr << "Unknown encoding: " << encoding << endl;
+    return 1;
+  }
+  if (!ok)
+  {
+    cerr << "Could not write " << output_path << endl;
+    return 1;
+  }
+
+  cout << output_path << ": " << c.code_points << " code points, " << c.errors
+       << " errors" << endl;
+  return 0;
+}
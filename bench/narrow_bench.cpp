@@ -0,0 +1,389 @@
+﻿//  unicode/bench/narrow_bench.cpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Narrow conversions through codecvt facets and through recoder (iconv), plus the
+//  std::wstring_convert and raw iconv baselines they should be compared against. UTF-8
+//  is used as the narrow encoding so that every corpus is representable, except by the
+//  East Asian encodings, which are compared with iconv() on the same octets.
+
+#include "bench.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/recoder.hpp>
+#include <boost/unicode/codecvt_registry.hpp>
+#include <boost/unicode/cjk_encoding.hpp>
+#include <boost/unicode/iconv_codecvt.hpp>
+#include <boost/unicode/utf8_codecvt.hpp>
+#include <boost/unicode/detail/utf8_codecvt_facet.hpp>
+#include <codecvt>
+#include <iconv.h>
+#include <iterator>
+#include <locale>
+#include <string>
+#include <vector>
+
+using namespace boost::unicode;
+
+namespace
+{
+  using wccvt_type = std::codecvt<wchar_t, char, std::mbstate_t>;
+
+  //  the library's own UTF-8 facet
+  const wccvt_type& test_ccvt()
+  {
+    static const detail::utf8_codecvt_facet ccvt(1);
+    return ccvt;
+  }
+
+  //  the library's production UTF-8 facet
+  const wccvt_type& fast_ccvt()
+  {
+    static const utf8_codecvt<wchar_t> ccvt(1);
+    return ccvt;
+  }
+
+  //  UTF-8 by way of iconv(), to compare with recoder
+  const wccvt_type& iconv_ccvt()
+  {
+    static const iconv_codecvt<wchar_t> ccvt("UTF-8", 1);
+    return ccvt;
+  }
+
+  //  the standard library's UTF-8 facet; null if no UTF-8 locale is installed
+  const wccvt_type* locale_ccvt()
+  {
+    static const std::locale* loc = []() -> const std::locale*
+    {
+      for (const char* name : {"C.UTF-8", "en_US.UTF-8"})
+      {
+        try { return new std::locale(name); }  // never deleted; facet must outlive use
+        catch (const std::runtime_error&) {}
+      }
+      return nullptr;
+    }();
+    return loc ? &std::use_facet<wccvt_type>(*loc) : nullptr;
+  }
+
+  template <class From, class To, class Codecvt>
+  void codecvt_bench(benchmark::State& state, const Codecvt* ccvt)
+  {
+    if (!ccvt)
+    {
+      state.SkipWithError("codecvt facet not available");
+      return;
+    }
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+    std::basic_string<typename To::value_type> out;
+    out.reserve(4 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      recode<From, To>(in.data(), in.data() + in.size(), std::back_inserter(out), *ccvt);
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  void recoder_bench(benchmark::State& state)
+  {
+    static recoder<char, char16_t> rcdr("UTF-8", "UTF-16LE");
+    const bench::corpus& c = bench::get_corpus(state);
+    std::u16string out;
+    out.reserve(2 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      rcdr.recode(c.utf8.data(), c.utf8.data() + c.utf8.size(), std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(c.utf8.size(), c.code_points);
+  }
+
+  //  facet lookup by locale name, per call and through the registry; a short string,
+  //  so that the lookup dominates
+  const char* utf8_locale_name()
+  {
+    for (const char* name : {"C.UTF-8", "en_US.UTF-8"})
+    {
+      try { std::locale loc(name); return name; }
+      catch (const std::runtime_error&) {}
+    }
+    return nullptr;
+  }
+
+  void locale_lookup_bench(benchmark::State& state)
+  {
+    const char* name = utf8_locale_name();
+    if (!name)
+    {
+      state.SkipWithError("UTF-8 locale not available");
+      return;
+    }
+    const std::wstring in(L"short string");
+    for (auto _ : state)
+    {
+      std::string out = to_string<narrow>(in, std::use_facet<wccvt_type>(
+        std::locale(name)));
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+
+  void registry_lookup_bench(benchmark::State& state)
+  {
+    const char* name = utf8_locale_name();
+    if (!name)
+    {
+      state.SkipWithError("UTF-8 locale not available");
+      return;
+    }
+    const std::wstring in(L"short string");
+    for (auto _ : state)
+    {
+      std::string out = to_string<narrow>(in, name);
+      benchmark::DoNotOptimize(out.data());
+    }
+  }
+
+  //  baselines  -----------------------------------------------------------------------//
+
+  template <class Codecvt>
+  void wstring_convert_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    std::wstring_convert<Codecvt, char16_t> cvt("\xEF\xBF\xBD", u"\uFFFD");
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      try
+      {
+        auto out = cvt.from_bytes(c.utf8);
+        benchmark::DoNotOptimize(out.data());
+      }
+      catch (const std::range_error&) {}  // wstring_convert gives up on the first error
+    }
+    r.report(c.utf8.size(), c.code_points);
+  }
+
+  void iconv_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    iconv_t cd = iconv_open("UTF-16LE", "UTF-8");
+    std::vector<char> out(4 * c.code_points + 4);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      iconv(cd, nullptr, nullptr, nullptr, nullptr);
+      char* inbuf = const_cast<char*>(c.utf8.data());
+      std::size_t inbytesleft = c.utf8.size();
+      char* outbuf = out.data();
+      std::size_t outbytesleft = out.size();
+      while (iconv(cd, &inbuf, &inbytesleft, &outbuf, &outbytesleft) == std::size_t(-1)
+        && inbytesleft != 0)
+      {
+        ++inbuf;  // skip an ill-formed octet
+        --inbytesleft;
+      }
+      benchmark::DoNotOptimize(outbuf);
+    }
+    r.report(c.utf8.size(), c.code_points);
+    iconv_close(cd);
+  }
+
+  //  codecvt conversions  -------------------------------------------------------------//
+
+  void utf8_to_narrow(benchmark::State& state, const wccvt_type* ccvt)
+  {
+    codecvt_bench<utf8, narrow>(state, ccvt);
+  }
+
+  void wide_to_narrow(benchmark::State& state, const wccvt_type* ccvt)
+  {
+    codecvt_bench<wide, narrow>(state, ccvt);
+  }
+
+  void narrow_to_utf16(benchmark::State& state, const wccvt_type* ccvt)
+  {
+    codecvt_bench<narrow, utf16>(state, ccvt);
+  }
+
+  void narrow_to_wide(benchmark::State& state, const wccvt_type* ccvt)
+  {
+    codecvt_bench<narrow, wide>(state, ccvt);
+  }
+
+  //  East Asian encodings  ------------------------------------------------------------//
+
+  //  The built-in tables against iconv_codecvt, each given the corpus as the tables
+  //  encode it, with '?' for the code points the encoding cannot represent.
+
+  const char* iconv_name(gb18030)   { return "GB18030"; }
+  const char* iconv_name(shift_jis) { return "CP932"; }
+  const char* iconv_name(big5)      { return "BIG5"; }
+  const char* iconv_name(euc_kr)    { return "EUC-KR"; }
+
+  template <class Encoding>
+  const wccvt_type& cjk_iconv_ccvt()
+  {
+    static const iconv_codecvt<wchar_t> ccvt(iconv_name(Encoding()), 1);
+    return ccvt;
+  }
+
+  template <class Encoding>
+  void cjk_to_utf16(benchmark::State& state, bool use_iconv)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const std::string in = to_string<Encoding>(c.utf16);
+    std::u16string out;
+    out.reserve(2 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      if (use_iconv)
+        recode<narrow, utf16>(in.data(), in.data() + in.size(), std::back_inserter(out),
+          cjk_iconv_ccvt<Encoding>());
+      else
+        recode<Encoding, utf16>(in.data(), in.data() + in.size(),
+          std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size(), c.code_points);
+  }
+
+  template <class Encoding>
+  void utf16_to_cjk(benchmark::State& state, bool use_iconv)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const std::string encoded = to_string<Encoding>(c.utf16);
+    std::u16string in;  // what Encoding can represent
+    recode<Encoding, utf16>(encoded.cbegin(), encoded.cend(), std::back_inserter(in));
+    std::string out;
+    out.reserve(4 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      if (use_iconv)
+        recode<utf16, narrow>(in.data(), in.data() + in.size(), std::back_inserter(out),
+          cjk_iconv_ccvt<Encoding>());
+      else
+        recode<utf16, Encoding>(in.data(), in.data() + in.size(),
+          std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(char16_t), c.code_points);
+  }
+
+  void gb18030_to_utf16(benchmark::State& state, bool use_iconv)
+  {
+    cjk_to_utf16<gb18030>(state, use_iconv);
+  }
+
+  void shift_jis_to_utf16(benchmark::State& state, bool use_iconv)
+  {
+    cjk_to_utf16<shift_jis>(state, use_iconv);
+  }
+
+  void big5_to_utf16(benchmark::State& state, bool use_iconv)
+  {
+    cjk_to_utf16<big5>(state, use_iconv);
+  }
+
+  void euc_kr_to_utf16(benchmark::State& state, bool use_iconv)
+  {
+    cjk_to_utf16<euc_kr>(state, use_iconv);
+  }
+
+  void utf16_to_gb18030(benchmark::State& state, bool use_iconv)
+  {
+    utf16_to_cjk<gb18030>(state, use_iconv);
+  }
+
+  void utf16_to_shift_jis(benchmark::State& state, bool use_iconv)
+  {
+    utf16_to_cjk<shift_jis>(state, use_iconv);
+  }
+
+  void utf16_to_big5(benchmark::State& state, bool use_iconv)
+  {
+    utf16_to_cjk<big5>(state, use_iconv);
+  }
+
+  void utf16_to_euc_kr(benchmark::State& state, bool use_iconv)
+  {
+    utf16_to_cjk<euc_kr>(state, use_iconv);
+  }
+}
+
+BENCHMARK_CAPTURE(utf8_to_narrow, test_facet, &test_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf8_to_narrow, locale_facet, locale_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf8_to_narrow, fast_facet, &fast_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf8_to_narrow, iconv_facet, &iconv_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(wide_to_narrow, test_facet, &test_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(wide_to_narrow, locale_facet, locale_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(wide_to_narrow, fast_facet, &fast_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(wide_to_narrow, iconv_facet, &iconv_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_utf16, test_facet, &test_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_utf16, locale_facet, locale_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_utf16, fast_facet, &fast_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_utf16, iconv_facet, &iconv_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_wide, test_facet, &test_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_wide, locale_facet, locale_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_wide, fast_facet, &fast_ccvt())
+  ->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(narrow_to_wide, iconv_facet, &iconv_ccvt())
+  ->Apply(bench::apply_corpora);
+
+BENCHMARK_CAPTURE(gb18030_to_utf16, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(gb18030_to_utf16, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(shift_jis_to_utf16, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(shift_jis_to_utf16, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(big5_to_utf16, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(big5_to_utf16, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(euc_kr_to_utf16, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(euc_kr_to_utf16, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_gb18030, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_gb18030, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_shift_jis, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_shift_jis, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_big5, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_big5, iconv_facet, true)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_euc_kr, table, false)->Apply(bench::apply_corpora);
+BENCHMARK_CAPTURE(utf16_to_euc_kr, iconv_facet, true)->Apply(bench::apply_corpora);
+
+BENCHMARK(recoder_bench)->Apply(bench::apply_corpora);
+
+BENCHMARK(locale_lookup_bench);
+BENCHMARK(registry_lookup_bench);
+
+BENCHMARK_TEMPLATE(wstring_convert_bench, std::codecvt_utf8_utf16<char16_t>)
+  ->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(wstring_convert_bench, utf8_codecvt<char16_t>)
+  ->Apply(bench::apply_corpora);
+BENCHMARK(iconv_bench)->Apply(bench::apply_corpora);
@@ -0,0 +1,418 @@
+﻿//  unicode/bench/utf_bench.cpp  -------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  UTF to UTF conversions: every recode_utf_to_utf pair, to_string, first_ill_formed,
+//  and the stream inserters; the two UTF-8 decoding backends, side by side; and UTF-16
+//  to and from the UTF-8 variants, alongside utf16 and utf8 in recode_bench; and
+//  to_string of a validated_view, alongside to_string_bench; and recode_to_sink,
+//  alongside recode_bench; and to_inline_string, alongside to_string_bench on short
+//  strings, for their allocations per call.
+
+#include "bench.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/inline_string.hpp>
+#include <boost/unicode/sink.hpp>
+#include <boost/unicode/stream.hpp>
+#include <boost/unicode/utf8_variants.hpp>
+#include <boost/unicode/validated_view.hpp>
+#include <iterator>
+#include <sstream>
+#include <string>
+
+using namespace boost::unicode;
+
+namespace
+{
+  //  recode into a string whose capacity is reused, so only the conversion is timed
+  template <class From, class To>
+  void recode_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+    std::basic_string<typename To::value_type> out;
+    out.reserve(4 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      recode<From, To>(in.data(), in.data() + in.size(), std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  as recode_bench, but to a string_sink
+  template <class From, class To>
+  void sink_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+    std::basic_string<typename To::value_type> out;
+    out.reserve(4 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      auto sink = make_sink(out);
+      recode_to_sink<From, To>(in.data(), in.data() + in.size(), sink);
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  to_string, including its allocations
+  template <class From, class To>
+  void to_string_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      auto out = to_string<To>(in);
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  to_string, but to an inline_basic_string that holds 24 code units
+  template <class From, class To>
+  void to_inline_string_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      auto out = to_inline_string<To, 24>(in);
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  to_string of input already known to be well-formed
+  template <class From, class To>
+  void validated_to_string_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+    const validated_view<From> v = validate(in);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      auto out = to_string<To>(v);
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(v.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  validate the entire input, resuming after each error
+  template <class Encoding>
+  void first_ill_formed_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, Encoding());
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      std::size_t errors = 0;
+      const auto* last = in.data() + in.size();
+      for (auto first = in.data(); first != last; ++errors)
+        first = first_ill_formed(first, last).second;
+      benchmark::DoNotOptimize(errors);
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  the UTF-8 backends, called directly whatever BOOST_UNICODE_UTF8_DFA selects
+  struct branchy
+  {
+    static bool decode(const char*& first, const char* last, char32_t& u32)
+      { return detail::utf8_decode_branchy(first, last, u32); }
+    static const char* first_ill_formed(const char* first, const char* last)
+      { return detail::utf8_first_ill_formed_branchy(first, last).second; }
+  };
+
+  struct dfa
+  {
+    static bool decode(const char*& first, const char* last, char32_t& u32)
+      { return detail::utf8_dfa_decode(first, last, u32); }
+    static const char* first_ill_formed(const char* first, const char* last)
+      { return detail::utf8_dfa_first_ill_formed(first, last).second; }
+  };
+
+  template <class Backend>
+  void utf8_decode_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char* first = c.utf8.data();
+    const char* last = first + c.utf8.size();
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      char32_t sum = 0;
+      for (const char* p = first; p != last;)
+      {
+        char32_t u32 = 0;
+        if (Backend::decode(p, last, u32))
+          sum += u32;
+      }
+      benchmark::DoNotOptimize(sum);
+    }
+    r.report(c.utf8.size(), c.code_points);
+  }
+
+  template <class Backend>
+  void utf8_validate_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char* first = c.utf8.data();
+    const char* last = first + c.utf8.size();
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      std::size_t errors = 0;
+      for (const char* p = first; p != last; ++errors)
+        p = Backend::first_ill_formed(p, last);
+      benchmark::DoNotOptimize(errors);
+    }
+    r.report(c.utf8.size(), c.code_points);
+  }
+
+  //  the UTF-32 encoders and decoders: a block at a time, as recode() uses for
+  //  contiguous input, and a code point at a time
+  struct blocks
+  {
+    template <class ToCharT, class InputCharT, class OutputIterator>
+    static OutputIterator from_utf8(const InputCharT* first, const InputCharT* last,
+      OutputIterator result)
+      { return detail::utf8_to_utf32<ToCharT>(first, last, result, ufffd<ToCharT>()); }
+    template <class ToCharT, class InputCharT, class OutputIterator>
+    static OutputIterator from_utf16(const InputCharT* first, const InputCharT* last,
+      OutputIterator result)
+      { return detail::utf16_to_utf32<ToCharT>(first, last, result, ufffd<ToCharT>()); }
+    template <class ToCharT, class OutputIterator>
+    static OutputIterator to_utf16(const char32_t* first, const char32_t* last,
+      OutputIterator result)
+      { return detail::utf32_to_utf16<ToCharT>(first, last, result, ufffd<ToCharT>()); }
+  };
+
+  struct scalar
+  {
+    template <class ToCharT, class InputCharT, class OutputIterator>
+    static OutputIterator from_utf8(const InputCharT* first, const InputCharT* last,
+      OutputIterator result)
+    {
+      return detail::utf8_to_char32_t<ToCharT>(first, last, result,
+        detail::u32_err_pass_thru(), ufffd<ToCharT>());
+    }
+    template <class ToCharT, class InputCharT, class OutputIterator>
+    static OutputIterator from_utf16(const InputCharT* first, const InputCharT* last,
+      OutputIterator result)
+    {
+      return detail::utf16_to_char32_t<ToCharT>(first, last, result,
+        detail::u32_err_pass_thru(), ufffd<ToCharT>());
+    }
+    template <class ToCharT, class OutputIterator>
+    static OutputIterator to_utf16(const char32_t* first, const char32_t* last,
+      OutputIterator result)
+    {
+      return detail::utf32_to_utf16_scalar<ToCharT>(first, last, result,
+        ufffd<ToCharT>());
+    }
+  };
+
+  template <class Backend>
+  void utf32_to_utf16_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char32_t* first = c.utf32.data();
+    const char32_t* last = first + c.utf32.size();
+    std::u16string out(2 * c.utf32.size(), u'\0');
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      char16_t* end = Backend::template to_utf16<char16_t>(first, last, &out[0]);
+      benchmark::DoNotOptimize(end);
+    }
+    r.report(c.utf32.size() * sizeof(char32_t), c.code_points);
+  }
+
+  template <class Backend>
+  void utf8_to_utf32_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char* first = c.utf8.data();
+    const char* last = first + c.utf8.size();
+    std::u32string out(c.utf8.size(), U'\0');
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      char32_t* end = Backend::template from_utf8<char32_t>(first, last, &out[0]);
+      benchmark::DoNotOptimize(end);
+    }
+    r.report(c.utf8.size(), c.code_points);
+  }
+
+  template <class Backend>
+  void utf16_to_utf32_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char16_t* first = c.utf16.data();
+    const char16_t* last = first + c.utf16.size();
+    std::u32string out(c.utf16.size(), U'\0');
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      char32_t* end = Backend::template from_utf16<char32_t>(first, last, &out[0]);
+      benchmark::DoNotOptimize(end);
+    }
+    r.report(c.utf16.size() * sizeof(char16_t), c.code_points);
+  }
+
+  template <class From>
+  void inserter_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const auto& in = bench::text(c, From());
+    std::ostringstream os;
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      os.str(std::string());
+      os << in;
+      benchmark::DoNotOptimize(os);
+    }
+    r.report(in.size() * sizeof(in[0]), c.code_points);
+  }
+
+  //  contiguous UTF-16 to a UTF-8 variant, as to_string() from a u16string_view
+  template <class Variant>
+  void utf16_to_variant_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const char16_t* first = c.utf16.data();
+    const char16_t* last = first + c.utf16.size();
+    std::string out;
+    out.reserve(6 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      recode<utf16, Variant>(first, last, std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(c.utf16.size() * sizeof(char16_t), c.code_points);
+  }
+
+  template <class Variant>
+  void variant_to_utf16_bench(benchmark::State& state)
+  {
+    const bench::corpus& c = bench::get_corpus(state);
+    const std::string in = to_string<Variant>(c.utf16);
+    std::u16string out;
+    out.reserve(2 * c.code_points);
+
+    bench::reporter r(state);
+    for (auto _ : state)
+    {
+      out.clear();
+      recode<Variant, utf16>(in.data(), in.data() + in.size(), std::back_inserter(out));
+      benchmark::DoNotOptimize(out.data());
+    }
+    r.report(in.size(), c.code_points);
+  }
+}
+
+#define BOOST_UNICODE_RECODE_BENCH(From, To) \
+  BENCHMARK_TEMPLATE(recode_bench, From, To)->Apply(bench::apply_corpora)
+
+BOOST_UNICODE_RECODE_BENCH(utf8, utf8);
+BOOST_UNICODE_RECODE_BENCH(utf8, utf16);
+BOOST_UNICODE_RECODE_BENCH(utf8, utf32);
+BOOST_UNICODE_RECODE_BENCH(utf8, wide);
+BOOST_UNICODE_RECODE_BENCH(utf16, utf8);
+BOOST_UNICODE_RECODE_BENCH(utf16, utf16);
+BOOST_UNICODE_RECODE_BENCH(utf16, utf32);
+BOOST_UNICODE_RECODE_BENCH(utf16, wide);
+BOOST_UNICODE_RECODE_BENCH(utf32, utf8);
+BOOST_UNICODE_RECODE_BENCH(utf32, utf16);
+BOOST_UNICODE_RECODE_BENCH(utf32, utf32);
+BOOST_UNICODE_RECODE_BENCH(utf32, wide);
+BOOST_UNICODE_RECODE_BENCH(wide, utf8);
+BOOST_UNICODE_RECODE_BENCH(wide, utf16);
+BOOST_UNICODE_RECODE_BENCH(wide, utf32);
+BOOST_UNICODE_RECODE_BENCH(wide, wide);
+
+BENCHMARK_TEMPLATE(sink_bench, utf8, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(sink_bench, utf8, utf16)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(sink_bench, utf8, utf32)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(sink_bench, utf16, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(sink_bench, utf32, utf8)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(to_string_bench, utf8, utf16)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(to_string_bench, utf16, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(to_string_bench, utf8, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(to_string_bench, utf8, utf32)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(to_string_bench, utf32, wide)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(validated_to_string_bench, utf8, utf16)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(validated_to_string_bench, utf16, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(validated_to_string_bench, utf8, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(validated_to_string_bench, utf8, utf32)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(validated_to_string_bench, utf32, wide)->Apply(bench::apply_corpora);
+
+#define BOOST_UNICODE_SHORT_BENCH(From, To) \
+  BENCHMARK_TEMPLATE(to_string_bench, From, To)->Apply(bench::apply_short_corpora); \
+  BENCHMARK_TEMPLATE(to_inline_string_bench, From, To) \
+    ->Apply(bench::apply_short_corpora)
+
+BOOST_UNICODE_SHORT_BENCH(utf8, utf8);
+BOOST_UNICODE_SHORT_BENCH(utf8, utf16);
+BOOST_UNICODE_SHORT_BENCH(utf8, utf32);
+BOOST_UNICODE_SHORT_BENCH(utf16, utf8);
+BOOST_UNICODE_SHORT_BENCH(utf32, utf8);
+
+BENCHMARK_TEMPLATE(first_ill_formed_bench, utf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(first_ill_formed_bench, utf16)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(first_ill_formed_bench, utf32)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(utf8_decode_bench, branchy)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf8_decode_bench, dfa)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf8_validate_bench, branchy)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf8_validate_bench, dfa)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(utf32_to_utf16_bench, blocks)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf32_to_utf16_bench, scalar)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(utf8_to_utf32_bench, blocks)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf8_to_utf32_bench, scalar)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf16_to_utf32_bench, blocks)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf16_to_utf32_bench, scalar)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(inserter_bench, utf16)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(inserter_bench, utf32)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(inserter_bench, wide)->Apply(bench::apply_corpora);
+
+BENCHMARK_TEMPLATE(utf16_to_variant_bench, wtf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf16_to_variant_bench, cesu8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(utf16_to_variant_bench, mutf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(variant_to_utf16_bench, wtf8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(variant_to_utf16_bench, cesu8)->Apply(bench::apply_corpora);
+BENCHMARK_TEMPLATE(variant_to_utf16_bench, mutf8)->Apply(bench::apply_corpora);
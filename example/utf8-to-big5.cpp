@@ -6,15 +6,24 @@
 //  See http://www.boost.org/LICENSE_1_0.txt
 
 #include <iostream>
+#include <iterator>
 #include <string>
 #include <boost/unicode/string_encoding.hpp>     // needed for example 1
+#include <boost/unicode/cjk_encoding.hpp>        // needed for the built-in big5
 #include <locale>                                // needed for example 2
 #include <codecvt>                               // needed for example 2
 #include <boost/unicode/detail/hex_string.hpp>
 #define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
 #include <boost/detail/lightweight_main.hpp>
 #include <boost/core/lightweight_test.hpp>
-#include <cvt/big5>
+
+//  the vendor supplied Big-5 facets, where available
+#if defined(__has_include)
+# if __has_include(<cvt/big5>)
+#   include <cvt/big5>
+#   define BOOST_UNICODE_HAS_CVT_BIG5
+# endif
+#endif
 
 using namespace boost::unicode;
 
@@ -24,16 +33,16 @@ namespace
   const std::u16string u16str(u"ⅠⅡⅢⅣⅤⅥⅦⅧⅨⅩ");
   const std::u32string u32str(U"ⅠⅡⅢⅣⅤⅥⅦⅧⅨⅩ");
   const std::wstring uwstr(L"ⅠⅡⅢⅣⅤⅥⅦⅧⅨⅩ");
-  const std::string big5str("\u00A2\u00B9"  // big-5 encoded roman Ⅰ-Ⅹ  
-                            "\u00A2\u00BA"
-                            "\u00A2\u00BB"
-                            "\u00A2\u00BC"
-                            "\u00A2\u00BD"
-                            "\u00A2\u00BE"
-                            "\u00A2\u00BF"
-                            "\u00A2\u00C0"
-                            "\u00A2\u00C1"
-                            "\u00A2\u00C2");
+  const std::string big5str("\xA2\xB9"  // big-5 encoded roman Ⅰ-Ⅹ
+                            "\xA2\xBA"
+                            "\xA2\xBB"
+                            "\xA2\xBC"
+                            "\xA2\xBD"
+                            "\xA2\xBE"
+                            "\xA2\xBF"
+                            "\xA2\xC0"
+                            "\xA2\xC1"
+                            "\xA2\xC2");
   std::string str;
   std::wstring wstr;
   std::string str8;
@@ -42,6 +51,32 @@ namespace
 
 }
 
+void big5_tests()
+{
+  //  The built-in big5 encoding needs no codecvt facet
+
+  // Convert UTF-8, UTF-16, UTF-32, and wide strings directly to Big-5 strings
+  BOOST_TEST_EQ(to_string<big5>(u8str), big5str);
+  BOOST_TEST_EQ(to_string<big5>(u16str), big5str);
+  BOOST_TEST_EQ(to_string<big5>(u32str), big5str);
+  BOOST_TEST_EQ(to_string<big5>(uwstr), big5str);
+
+  // Convert Big-5 string directly to UTF-8, UTF-16, UTF-32, and wide strings
+  str8.clear();
+  recode<big5, utf8>(big5str.cbegin(), big5str.cend(), std::back_inserter(str8));
+  BOOST_TEST_EQ(str8, u8str);
+  str16.clear();
+  recode<big5, utf16>(big5str.cbegin(), big5str.cend(), std::back_inserter(str16));
+  BOOST_TEST(str16 == u16str);
+  str32.clear();
+  recode<big5, utf32>(big5str.cbegin(), big5str.cend(), std::back_inserter(str32));
+  BOOST_TEST(str32 == u32str);
+  wstr.clear();
+  recode<big5, wide>(big5str.cbegin(), big5str.cend(), std::back_inserter(wstr));
+  BOOST_TEST(wstr == uwstr);
+}
+
+#if defined(BOOST_UNICODE_HAS_CVT_BIG5)
 void wchar_t_tests()
 {
   stdext::cvt::codecvt_big5<wchar_t> big5ccvt;
@@ -161,12 +196,16 @@ void uint_least32_t_tests()
   wstr = to_string<wide>(big5str, big5ccvt);
   BOOST_TEST(wstr == uwstr);
 }
+#endif
 
 int cpp_main(int, char*[])
 {
 
+  big5_tests();
+#if defined(BOOST_UNICODE_HAS_CVT_BIG5)
   wchar_t_tests();
   uint_least32_t_tests();
+#endif
 
   return ::boost::report_errors();
 }
@@ -0,0 +1,242 @@
+﻿//  boost/unicode/batch.hpp  -----------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  recode_batch converts many small strings at once, writing all of the results        //
+//  contiguously into a single buffer with an offsets array (as Apache Arrow does for   //
+//  variable length columns) instead of allocating a string for each result.            //
+//                                                                                      //
+//  For UTF to UTF conversions with the default error handler the total size is         //
+//  computed first, so the buffer is allocated exactly once and the conversion writes   //
+//  through a raw pointer. Narrow conversions, whose output size is only known to the   //
+//  codecvt facet, and conversions given an error handler, which might not replace      //
+//  the same way twice, append to the buffer instead.                                   //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_BATCH_HPP)
+#define BOOST_UNICODE_BATCH_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/assert.hpp>
+#include <cstddef>
+#include <iterator>
+#include <string>
+#include <vector>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  template <class CharT>
+  class recoded_batch
+  {
+  public:
+    using value_type = CharT;
+    using view_type = boost::basic_string_view<CharT>;
+
+    recoded_batch() : offsets_(1, 0) {}
+
+    std::size_t size() const noexcept        { return offsets_.size() - 1; }
+    bool        empty() const noexcept       { return size() == 0; }
+
+    //  Requires: i < size()
+    view_type   operator[](std::size_t i) const noexcept;
+
+    //  all results, contiguously; result i is [offsets()[i], offsets()[i+1])
+    const std::basic_string<CharT>&  data() const noexcept    { return data_; }
+    const std::vector<std::size_t>&  offsets() const noexcept { return offsets_; }
+
+  private:  // exposition only
+
+    template <class FromEncoding, class ToEncoding, class ForwardIterator, class ... T>
+    friend recoded_batch<typename ToEncoding::value_type>
+      recode_batch(ForwardIterator first, ForwardIterator last, const T& ... args);
+
+    std::basic_string<CharT>  data_;     // all results, contiguously
+    std::vector<std::size_t>  offsets_;  // size() + 1 offsets into data_
+  };
+
+  //  ForwardIterator value_type must be convertible to
+  //  boost::basic_string_view<typename FromEncoding::value_type>. Arguments args are
+  //  as for recode(), and are applied to each string.
+  template <class FromEncoding, class ToEncoding, class ForwardIterator, class ... T>
+  recoded_batch<typename ToEncoding::value_type>
+    recode_batch(ForwardIterator first, ForwardIterator last, const T& ... args);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  counting_output_iterator: an output iterator that only counts what is written
+  class counting_output_iterator
+  {
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    explicit counting_output_iterator(std::size_t n = 0) noexcept : n_(n) {}
+
+    std::size_t count() const noexcept { return n_; }
+
+    struct proxy { template <class T> void operator=(const T&) const noexcept {} };
+    proxy operator*() const noexcept { return proxy(); }
+    counting_output_iterator& operator++() noexcept { ++n_; return *this; }
+    counting_output_iterator operator++(int) noexcept
+      { counting_output_iterator tmp(*this); ++n_; return tmp; }
+
+  private:
+    std::size_t n_;
+  };
+
+  //  output_length: the number of code units recode<From, To>(v) produces with the
+  //  default error handler; overloads use the fast UTF length queries
+  template <class FromEncoding, class ToEncoding, class View>
+  inline std::size_t output_length(FromEncoding, ToEncoding, View v)
+  {
+    return recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
+      counting_output_iterator()).count();
+  }
+  inline std::size_t output_length(utf8, utf16, boost::string_view v)
+  {
+    return unicode::utf16_length_of_utf8(v);
+  }
+  inline std::size_t output_length(utf8, utf32, boost::string_view v)
+  {
+    return unicode::count_code_points(v);
+  }
+# if WCHAR_MAX >= 0x1FFFFFFFu
+  inline std::size_t output_length(utf8, wide, boost::string_view v)
+  {
+    return unicode::count_code_points(v);
+  }
+# endif
+
+  //  UTF to UTF with the default error handler. An error handler passed might not give
+  //  the same replacement when called again, so the output could outgrow the sizing
+  //  pass; conversions with one append instead.
+  template <class FromEncoding, class ToEncoding, class CharT, class ForwardIterator>
+  void recode_batch(utf_tag, utf_tag, std::basic_string<CharT>& data,
+    std::vector<std::size_t>& offsets, ForwardIterator first, ForwardIterator last)
+  {
+    using from_view = boost::basic_string_view<typename FromEncoding::value_type>;
+
+    //  size the entire result first, so it is allocated once
+    std::size_t total = 0;
+    for (ForwardIterator it = first; it != last; ++it)
+    {
+      total += output_length(FromEncoding(), ToEncoding(), from_view(*it));
+      offsets.push_back(total);
+    }
+    data.resize(total);
+
+    CharT* out = &data[0];
+    for (; first != last; ++first)
+    {
+      from_view v(*first);
+      out = recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(), out);
+    }
+    BOOST_ASSERT(out == data.data() + total);
+  }
+
+  template <class FromEncoding, class ToEncoding, class FromTag, class ToTag,
+    class CharT, class ForwardIterator, class ... T>
+  void recode_batch(FromTag, ToTag, std::basic_string<CharT>& data,
+    std::vector<std::size_t>& offsets, ForwardIterator first, ForwardIterator last,
+    const T& ... args)
+  {
+    using from_view = boost::basic_string_view<typename FromEncoding::value_type>;
+
+    for (; first != last; ++first)
+    {
+      from_view v(*first);
+      recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
+        std::back_inserter(data), args ...);
+      offsets.push_back(data.size());
+    }
+  }
+
+  template <class FromEncoding, class ToEncoding, class CharT, class ForwardIterator,
+    class ... T>
+  inline void recode_batch_untraced(std::basic_string<CharT>& data,
+    std::vector<std::size_t>& offsets, ForwardIterator first, ForwardIterator last,
+    const T& ... args)
+  {
+    recode_batch<FromEncoding, ToEncoding>(typename dispatch<FromEncoding>::tag(),
+      typename dispatch<ToEncoding>::tag(), data, offsets, first, last, args ...);
+  }
+
+  //  the whole batch is one event; kept out of line from recode_batch() so that the
+  //  untraced path stays small
+  template <class FromEncoding, class ToEncoding, class CharT, class ForwardIterator,
+    class ... T>
+  void traced_recode_batch(conversion_observer* observer, std::basic_string<CharT>& data,
+    std::vector<std::size_t>& offsets, ForwardIterator first, ForwardIterator last,
+    const T& ... args)
+  {
+    using from_view = boost::basic_string_view<typename FromEncoding::value_type>;
+
+    std::size_t input_bytes = 0;
+    for (ForwardIterator it = first; it != last; ++it)
+      input_bytes += from_view(*it).size() * sizeof(typename FromEncoding::value_type);
+    trace_scope trace(observer, conversion::recode_batch, encoding_name(FromEncoding()),
+      encoding_name(ToEncoding()), input_bytes);
+    recode_batch_untraced<FromEncoding, ToEncoding>(data, offsets, first, last,
+      args ...);
+    trace.finish(data.size() * sizeof(CharT));
+  }
+}  // namespace detail
+
+  template <class CharT>
+  inline typename recoded_batch<CharT>::view_type
+    recoded_batch<CharT>::operator[](std::size_t i) const noexcept
+  {
+    BOOST_ASSERT(i < size());
+    return view_type(data_.data() + offsets_[i], offsets_[i+1] - offsets_[i]);
+  }
+
+  template <class FromEncoding, class ToEncoding, class ForwardIterator, class ... T>
+  recoded_batch<typename ToEncoding::value_type>
+    recode_batch(ForwardIterator first, ForwardIterator last, const T& ... args)
+  {
+    static_assert(is_encoding<FromEncoding>::value,
+      "FromEncoding must be utf8, utf16, utf32, narrow, or wide");
+    static_assert(is_encoding<ToEncoding>::value,
+      "ToEncoding must be utf8, utf16, utf32, narrow, or wide");
+
+    recoded_batch<typename ToEncoding::value_type> batch;
+    batch.offsets_.reserve(static_cast<std::size_t>(std::distance(first, last)) + 1);
+    if (conversion_observer* observer = get_conversion_observer())
+      detail::traced_recode_batch<FromEncoding, ToEncoding>(observer, batch.data_,
+        batch.offsets_, first, last, args ...);
+    else
+      detail::recode_batch_untraced<FromEncoding, ToEncoding>(batch.data_,
+        batch.offsets_, first, last, args ...);
+    return batch;
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_BATCH_HPP
@@ -0,0 +1,195 @@
+﻿//  boost/unicode/boundary.hpp  --------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Code point boundary queries, for splitting UTF sequences into pieces without        //
+//  cutting a multi-code-unit sequence in half and so creating ill-formed fragments.    //
+//                                                                                      //
+//  floor_boundary and ceil_boundary are O(1): they examine at most 3 octets of UTF-8   //
+//  or 1 code unit of UTF-16 around the offset. UTF-32 offsets are always boundaries.   //
+//                                                                                      //
+//  Ill-formed input is never made worse: an offset inside a run of stray continuation  //
+//  octets is already a boundary, since each is an error on its own.                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_BOUNDARY_HPP)
+#define BOOST_UNICODE_BOUNDARY_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/utility/string_view.hpp>
+#include <cstddef>
+#include <vector>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  //  returns: the greatest code point boundary <= min(pos, v.size())
+  template <class CharT, class Traits>
+    std::size_t floor_boundary(boost::basic_string_view<CharT, Traits> v,
+      std::size_t pos) BOOST_NOEXCEPT;
+
+  //  returns: the least code point boundary >= min(pos, v.size())
+  template <class CharT, class Traits>
+    std::size_t ceil_boundary(boost::basic_string_view<CharT, Traits> v,
+      std::size_t pos) BOOST_NOEXCEPT;
+
+  //  returns: the longest prefix of v no longer than max_units code units that ends
+  //  on a code point boundary
+  template <class CharT, class Traits>
+    boost::basic_string_view<CharT, Traits>
+      truncate_to_units(boost::basic_string_view<CharT, Traits> v,
+        std::size_t max_units) BOOST_NOEXCEPT;
+
+  //  returns: consecutive pieces of v, each beginning and ending on a code point
+  //  boundary and no longer than target_size code units unless a single code point is
+  //  longer than that
+  template <class CharT, class Traits>
+    std::vector<boost::basic_string_view<CharT, Traits>>
+      split_into_chunks(boost::basic_string_view<CharT, Traits> v,
+        std::size_t target_size);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  Requires for all boundary() overloads: 0 < pos < size
+
+  template <class CharT>
+  inline std::size_t floor_boundary(const CharT* p, std::size_t size, std::size_t pos,
+    utf8) BOOST_NOEXCEPT
+  {
+    BOOST_ASSERT(pos > 0 && pos < size);
+    (void)size;
+    std::size_t i = pos;
+    for (std::size_t n = 0; n < 3 && i > 0
+      && (static_cast<unsigned char>(p[i]) & 0xC0u) == 0x80u; ++n)
+      --i;
+    unsigned lead = static_cast<unsigned char>(p[i]);
+    std::size_t length = lead >= 0xF0u ? 4 : lead >= 0xE0u ? 3 : lead >= 0xC0u ? 2 : 1;
+    return i + length > pos ? i : pos;  // otherwise pos is a stray continuation octet
+  }
+
+  template <class CharT>
+  inline std::size_t floor_boundary(const CharT* p, std::size_t, std::size_t pos,
+    utf16) BOOST_NOEXCEPT
+  {
+    return (static_cast<char16_t>(p[pos]) & 0xFC00u) == 0xDC00u
+        && (static_cast<char16_t>(p[pos-1]) & 0xFC00u) == 0xD800u
+      ? pos - 1 : pos;
+  }
+
+  template <class CharT>
+  inline std::size_t floor_boundary(const CharT*, std::size_t, std::size_t pos,
+    utf32) BOOST_NOEXCEPT
+  {
+    return pos;
+  }
+
+  template <class CharT>
+  inline std::size_t ceil_boundary(const CharT* p, std::size_t size, std::size_t pos,
+    utf8) BOOST_NOEXCEPT
+  {
+    std::size_t i = floor_boundary(p, size, pos, utf8());
+    if (i == pos)
+      return pos;
+    unsigned lead = static_cast<unsigned char>(p[i]);
+    std::size_t end = i + (lead >= 0xF0u ? 4 : lead >= 0xE0u ? 3 : 2);
+    //  a truncated sequence ends at its first missing continuation octet
+    for (i = pos; i < size && i < end
+      && (static_cast<unsigned char>(p[i]) & 0xC0u) == 0x80u; ++i) {}
+    return i;
+  }
+
+  template <class CharT>
+  inline std::size_t ceil_boundary(const CharT* p, std::size_t size, std::size_t pos,
+    utf16) BOOST_NOEXCEPT
+  {
+    return floor_boundary(p, size, pos, utf16()) == pos ? pos : pos + 1;
+  }
+
+  template <class CharT>
+  inline std::size_t ceil_boundary(const CharT*, std::size_t, std::size_t pos,
+    utf32) BOOST_NOEXCEPT
+  {
+    return pos;
+  }
+}  // namespace detail
+
+  template <class CharT, class Traits>
+  inline std::size_t floor_boundary(boost::basic_string_view<CharT, Traits> v,
+    std::size_t pos) BOOST_NOEXCEPT
+  {
+    static_assert(is_encoded_character<CharT>::value,
+      "CharT must be char, char16_t, char32_t, or wchar_t");
+    if (pos >= v.size())
+      return v.size();
+    if (pos == 0)
+      return 0;
+    return detail::floor_boundary(v.data(), v.size(), pos,
+      typename detail::utf_encoding<CharT>::tag());
+  }
+
+  template <class CharT, class Traits>
+  inline std::size_t ceil_boundary(boost::basic_string_view<CharT, Traits> v,
+    std::size_t pos) BOOST_NOEXCEPT
+  {
+    static_assert(is_encoded_character<CharT>::value,
+      "CharT must be char, char16_t, char32_t, or wchar_t");
+    if (pos >= v.size())
+      return v.size();
+    if (pos == 0)
+      return 0;
+    return detail::ceil_boundary(v.data(), v.size(), pos,
+      typename detail::utf_encoding<CharT>::tag());
+  }
+
+  template <class CharT, class Traits>
+  inline boost::basic_string_view<CharT, Traits>
+    truncate_to_units(boost::basic_string_view<CharT, Traits> v,
+      std::size_t max_units) BOOST_NOEXCEPT
+  {
+    return v.substr(0, floor_boundary(v, max_units));
+  }
+
+  template <class CharT, class Traits>
+  std::vector<boost::basic_string_view<CharT, Traits>>
+    split_into_chunks(boost::basic_string_view<CharT, Traits> v,
+      std::size_t target_size)
+  {
+    BOOST_ASSERT(target_size > 0);
+    std::vector<boost::basic_string_view<CharT, Traits>> chunks;
+    chunks.reserve(v.size() / target_size + 1);
+    while (!v.empty())
+    {
+      std::size_t n = floor_boundary(v, target_size);
+      if (n == 0)  // a single code point is longer than target_size
+        n = ceil_boundary(v, target_size);
+      chunks.push_back(v.substr(0, n));
+      v.remove_prefix(n);
+    }
+    return chunks;
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_BOUNDARY_HPP
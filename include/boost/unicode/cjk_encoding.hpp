@@ -0,0 +1,464 @@
+﻿//  boost/unicode/cjk_encoding.hpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  gb18030, shift_jis, big5, and euc_kr are encodings for recode() and to_string(),    //
+//  like utf8 or utf16, so that the common East Asian encodings need no codecvt facet,  //
+//  vendor supplied or iconv_codecvt:                                                   //
+//                                                                                      //
+//    recode<big5, utf8>(first, last, std::back_inserter(u8s));                         //
+//    std::string b5 = to_string<big5>(u16s);                                           //
+//                                                                                      //
+//  Each is decoded by table lookup: an octet table gives the code point of a single    //
+//  octet or marks it a lead octet, whose row of a two-octet table gives the code       //
+//  point of each trail octet. The tables, in detail/cjk_tables.hpp, are generated by   //
+//  tools/cjk_tables_gen.cpp from the iconv() of the machine running it, so that each   //
+//  encoding here decodes and encodes exactly as iconv() does; shift_jis is Microsoft's //
+//  code page 932, as Shift-JIS text almost always is. The encoder, a table of 256      //
+//  code point pages, is built from the decoder's tables when first used, with the      //
+//  few code points that encode otherwise listed in the tables.                         //
+//                                                                                      //
+//  An ill-formed or unmapped sequence decodes to one replacement, passed to the error  //
+//  handler as recode() from UTF passes one; a trail octet that is ASCII is not part    //
+//  of the sequence, and is decoded again by itself. A code point the encoding cannot   //
+//  represent is encoded as the error handler's string, octets written as they are.     //
+//  The default error handler writes the encoding's own U+FFFD for gb18030, and '?'     //
+//  for the others, which have none.                                                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_CJK_ENCODING_HPP)
+#define BOOST_UNICODE_CJK_ENCODING_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/detail/cjk_tables.hpp>
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  namespace detail { struct cjk_encoding {}; }
+
+  //  encoding types
+  struct gb18030   : detail::cjk_encoding { using value_type = char; };  // GB 18030-2005
+  struct shift_jis : detail::cjk_encoding { using value_type = char; };  // code page 932
+  struct big5      : detail::cjk_encoding { using value_type = char; };  // Big5
+  struct euc_kr    : detail::cjk_encoding { using value_type = char; };  // KS X 1001
+
+  template<> struct is_encoding<gb18030>   : std::true_type {};
+  template<> struct is_encoding<shift_jis> : std::true_type {};
+  template<> struct is_encoding<big5>      : std::true_type {};
+  template<> struct is_encoding<euc_kr>    : std::true_type {};
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  inline const char* encoding_name(gb18030) BOOST_NOEXCEPT   { return "gb18030"; }
+  inline const char* encoding_name(shift_jis) BOOST_NOEXCEPT { return "shift_jis"; }
+  inline const char* encoding_name(big5) BOOST_NOEXCEPT      { return "big5"; }
+  inline const char* encoding_name(euc_kr) BOOST_NOEXCEPT    { return "euc_kr"; }
+
+  template <class Encoding> struct cjk_traits;
+  template<> struct cjk_traits<gb18030>
+  {
+    static const cjk_table& table() BOOST_NOEXCEPT { return gb18030_table(); }
+    static constexpr bool four = true;  // has four-octet sequences
+    static const char* replacement() BOOST_NOEXCEPT { return "\x84\x31\xA4\x37"; }
+  };
+  template<> struct cjk_traits<shift_jis>
+  {
+    static const cjk_table& table() BOOST_NOEXCEPT { return shift_jis_table(); }
+    static constexpr bool four = false;
+    static const char* replacement() BOOST_NOEXCEPT { return "?"; }
+  };
+  template<> struct cjk_traits<big5>
+  {
+    static const cjk_table& table() BOOST_NOEXCEPT { return big5_table(); }
+    static constexpr bool four = false;
+    static const char* replacement() BOOST_NOEXCEPT { return "?"; }
+  };
+  template<> struct cjk_traits<euc_kr>
+  {
+    static const cjk_table& table() BOOST_NOEXCEPT { return euc_kr_table(); }
+    static constexpr bool four = false;
+    static const char* replacement() BOOST_NOEXCEPT { return "?"; }
+  };
+
+  //  the default error handler for output in Encoding
+  template <class Encoding>
+  struct cjk_ufffd
+  {
+    const char* operator()() const BOOST_NOEXCEPT
+    {
+      return cjk_traits<Encoding>::replacement();
+    }
+  };
+
+  //  GB18030 four-octet sequences: the index of the first supplementary one, 0x90308130
+  const std::uint32_t gb18030_supplementary_index = 189000;
+  const std::uint32_t gb18030_bmp_indexes = 39420;
+
+  //  cjk_decode
+  //
+  //  Decodes the sequence at first, advancing first past it. Returns true with its code
+  //  point in u32 if it is well-formed and mapped, otherwise false.
+
+  template <class InputIterator>
+  inline bool gb18030_decode_four(const cjk_table& t, unsigned char lead,
+    InputIterator& first, InputIterator last, char32_t& u32)
+  {
+    //  first is at the second octet, already known to be a digit; a malformed sequence
+    //  is the lead octet alone, while a truncated one is all that remains
+    InputIterator it = first;
+    const unsigned char b2 = static_cast<unsigned char>(*it++);
+    if (it == last)
+      return first = last, false;
+    const unsigned char b3 = static_cast<unsigned char>(*it++);
+    if (b3 < 0x81 || b3 > 0xFE)
+      return false;
+    if (it == last)
+      return first = last, false;
+    const unsigned char b4 = static_cast<unsigned char>(*it++);
+    if (b4 < 0x30 || b4 > 0x39)
+      return false;
+    first = it;
+
+    const std::uint32_t index
+      = (((lead - 0x81u) * 10 + (b2 - 0x30u)) * 126 + (b3 - 0x81u)) * 10 + (b4 - 0x30u);
+    if (index < gb18030_bmp_indexes)
+    {
+      const cjk_run* run = std::upper_bound(t.runs, t.runs + t.runs_size, index,
+        [](std::uint32_t i, const cjk_run& r) { return i < r.index; });
+      if (run == t.runs || index - (run - 1)->index >= (run - 1)->length)
+        return false;
+      --run;
+      u32 = static_cast<char32_t>(run->cp + (index - run->index));
+      return true;
+    }
+    if (index >= gb18030_supplementary_index
+      && index - gb18030_supplementary_index <= 0xFFFFFu)
+    {
+      u32 = 0x10000u + (index - gb18030_supplementary_index);
+      return true;
+    }
+    return false;
+  }
+
+  template <class InputIterator>
+  inline bool cjk_decode(const cjk_table& t, bool four, InputIterator& first,
+    InputIterator last, char32_t& u32)
+  {
+    const unsigned char lead = static_cast<unsigned char>(*first++);
+    const char16_t single = t.single[lead];
+    if (single < cjk_more)
+    {
+      u32 = single;
+      return true;
+    }
+    if (single == cjk_none || first == last)  // not mapped, or truncated
+      return false;
+
+    const unsigned char trail = static_cast<unsigned char>(*first);
+    if (four && trail >= 0x30 && trail <= 0x39)
+      return gb18030_decode_four(t, lead, first, last, u32);
+    const unsigned char row = t.row_of[lead];
+    if (row != 0xFF && trail >= t.trail_first && trail <= t.trail_last)
+    {
+      const char16_t c = t.rows[row * (t.trail_last - t.trail_first + 1u)
+        + (trail - t.trail_first)];
+      if (c < cjk_more)
+      {
+        ++first;
+        u32 = c;
+        return true;
+      }
+      if (c == cjk_more)
+      {
+        ++first;
+        const char16_t code = static_cast<char16_t>(lead << 8 | trail);
+        const cjk_pair* p = std::find_if(t.wide, t.wide + t.wide_size,
+          [code](const cjk_pair& w) { return w.code == code; });
+        u32 = p->cp;
+        return true;
+      }
+    }
+    if (trail >= 0x80)  // an ASCII trail octet is decoded again, by itself
+      ++first;
+    return false;
+  }
+
+  //  cjk_encoder
+  //
+  //  The inverse of a cjk_table: the one- or two-octet code of each BMP code point, as
+  //  pages of 256 codes, with the pages that have none sharing one empty page.
+
+  class cjk_encoder
+  {
+  public:
+    explicit cjk_encoder(const cjk_table& t)
+      : table_(t), runs_(t.runs, t.runs + t.runs_size)
+    {
+      page_of_.fill(0);
+      pages_.assign(256, cjk_none);
+      for (int b = 0; b < 256; ++b)
+        if (t.single[b] < cjk_more)
+          add(t.single[b], static_cast<char16_t>(b), false);
+      const unsigned columns = t.trail_last - t.trail_first + 1u;
+      for (int b = 0; b < 256; ++b)
+        if (t.row_of[b] != 0xFF)
+          for (unsigned column = 0; column < columns; ++column)
+          {
+            const char16_t cp = t.rows[t.row_of[b] * columns + column];
+            if (cp < cjk_more)
+              add(cp, static_cast<char16_t>(b << 8 | (t.trail_first + column)), false);
+          }
+      for (std::size_t i = 0; i < t.overrides_size; ++i)
+        add(static_cast<char16_t>(t.overrides[i].cp), t.overrides[i].code, true);
+      std::sort(runs_.begin(), runs_.end(),
+        [](const cjk_run& x, const cjk_run& y) { return x.cp < y.cp; });
+    }
+
+    //  the code of BMP code point cp, cjk_none if it has no one- or two-octet code, or
+    //  cjk_unmapped if it has no code at all
+    char16_t code(char32_t cp) const BOOST_NOEXCEPT
+    {
+      return pages_[page_of_[cp >> 8] * 256u + (cp & 0xFFu)];
+    }
+
+    //  the two-octet code of supplementary code point cp, or cjk_none
+    char16_t wide_code(char32_t cp) const BOOST_NOEXCEPT
+    {
+      for (std::size_t i = 0; i < table_.wide_size; ++i)
+        if (table_.wide[i].cp == cp)
+          return table_.wide[i].code;
+      return cjk_none;
+    }
+
+    //  the GB18030 four-octet index of BMP code point cp, or gb18030_bmp_indexes
+    std::uint32_t four_index(char32_t cp) const BOOST_NOEXCEPT
+    {
+      auto run = std::upper_bound(runs_.begin(), runs_.end(), cp,
+        [](char32_t c, const cjk_run& r) { return c < r.cp; });
+      if (run == runs_.begin() || cp - (run - 1)->cp >= (run - 1)->length)
+        return gb18030_bmp_indexes;
+      --run;
+      return run->index + (cp - run->cp);
+    }
+
+  private:
+    void add(char16_t cp, char16_t code, bool replace)
+    {
+      std::uint16_t& page = page_of_[cp >> 8];
+      if (page == 0)
+      {
+        page = static_cast<std::uint16_t>(pages_.size() / 256);
+        pages_.resize(pages_.size() + 256, cjk_none);
+      }
+      char16_t& entry = pages_[page * 256u + (cp & 0xFFu)];
+      if (replace || entry == cjk_none)
+        entry = code;
+    }
+
+    const cjk_table&              table_;
+    std::array<std::uint16_t, 256> page_of_;  // page 0 is empty
+    std::vector<char16_t>         pages_;
+    std::vector<cjk_run>          runs_;     // by code point
+  };
+
+  //  built on first use; thread-safe, as a function local static
+  template <class Encoding>
+  inline const cjk_encoder& cjk_encoder_of()
+  {
+    static const cjk_encoder encoder(cjk_traits<Encoding>::table());
+    return encoder;
+  }
+
+  //  cjk_encode
+  //
+  //  Outputs u32 in Encoding, or the error handler's string if it is not a code point or
+  //  Encoding has no code for it.
+
+  template <class Encoding, class OutputIterator, class Error>
+  inline OutputIterator cjk_encode(const cjk_encoder& encoder, char32_t u32,
+    OutputIterator result, Error eh)
+  {
+    char16_t code = cjk_unmapped;
+    std::uint32_t index = gb18030_bmp_indexes;
+    if (u32 <= 0xFFFFu)
+    {
+      code = encoder.code(u32);
+      if (code == cjk_none && cjk_traits<Encoding>::four)
+        index = encoder.four_index(u32);
+    }
+    else if (u32 <= 0x10FFFFu)
+    {
+      code = encoder.wide_code(u32);
+      if (code == cjk_none && cjk_traits<Encoding>::four)
+        index = gb18030_supplementary_index + (u32 - 0x10000u);
+    }
+
+    if (code < 0x100u)
+      *result++ = static_cast<char>(code);
+    else if (code < cjk_unmapped)
+    {
+      *result++ = static_cast<char>(code >> 8);
+      *result++ = static_cast<char>(code & 0xFFu);
+    }
+    else if (index != gb18030_bmp_indexes)
+    {
+      *result++ = static_cast<char>(0x81u + index / 12600);
+      *result++ = static_cast<char>(0x30u + index / 1260 % 10);
+      *result++ = static_cast<char>(0x81u + index / 10 % 126);
+      *result++ = static_cast<char>(0x30u + index % 10);
+    }
+    else
+      for (auto it = eh(); *it; ++it)
+        *result++ = *it;
+    return result;
+  }
+
+  //  UTF input, decoded as the UTF-to-UTF conversions decode it
+
+  template <class InputIterator>
+  inline bool cjk_utf_decode(utf8, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    return utf8_decode(first, last, u32);
+  }
+  template <class InputIterator>
+  inline bool cjk_utf_decode(utf16, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    return utf16_decode(first, last, u32);
+  }
+  template <class InputIterator>
+  inline bool cjk_utf_decode(utf32, InputIterator& first, InputIterator,
+    char32_t& u32)
+  {
+    u32 = static_cast<char32_t>(*first++);
+    return u32 < 0xD800u || (u32 >= 0xE000u && u32 <= 0x10FFFFu);
+  }
+  template <class InputIterator>
+  inline bool cjk_utf_decode(wide, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    return cjk_utf_decode(BOOST_UNICODE_WIDE_UTF(), first, last, u32);
+  }
+
+  //  the conversions  ---------------------------------------------------------------//
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = ufffd<typename ToEncoding::value_type>>
+  inline OutputIterator cjk_to_utf(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    using to_char = typename ToEncoding::value_type;
+    using to_tag = typename utf_encoding<to_char>::tag;
+    const cjk_table& table = cjk_traits<FromEncoding>::table();
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!cjk_decode(table, cjk_traits<FromEncoding>::four, first, last, u32))
+        u32 = 0x110000u;  // passes the error to eh, as u32_err_pass_thru does
+      result = u32_outputer<to_char>(to_tag(), u32, result, eh);
+    }
+    return result;
+  }
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = cjk_ufffd<ToEncoding>>
+  inline OutputIterator utf_to_cjk(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    const cjk_encoder& encoder = cjk_encoder_of<ToEncoding>();
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!cjk_utf_decode(FromEncoding(), first, last, u32))
+        u32 = 0x110000u;
+      result = cjk_encode<ToEncoding>(encoder, u32, result, eh);
+    }
+    return result;
+  }
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = cjk_ufffd<ToEncoding>>
+  inline OutputIterator cjk_to_cjk(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    const cjk_table& table = cjk_traits<FromEncoding>::table();
+    const cjk_encoder& encoder = cjk_encoder_of<ToEncoding>();
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!cjk_decode(table, cjk_traits<FromEncoding>::four, first, last, u32))
+        u32 = 0x110000u;
+      result = cjk_encode<ToEncoding>(encoder, u32, result, eh);
+    }
+    return result;
+  }
+
+  //  recode_dispatch overloads, found by argument dependent lookup  -----------------//
+
+  struct cjk_tag {};
+
+  template<> struct dispatch<gb18030>   { using tag = cjk_tag; };
+  template<> struct dispatch<shift_jis> { using tag = cjk_tag; };
+  template<> struct dispatch<big5>      { using tag = cjk_tag; };
+  template<> struct dispatch<euc_kr>    { using tag = cjk_tag; };
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(cjk_tag, utf_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return cjk_to_utf<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(utf_tag, cjk_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return utf_to_cjk<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(cjk_tag, cjk_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return cjk_to_cjk<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_CJK_ENCODING_HPP
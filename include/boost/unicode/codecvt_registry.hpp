@@ -0,0 +1,232 @@
+﻿//  boost/unicode/codecvt_registry.hpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  A cache of named locales and their codecvt facets. Constructing a std::locale from  //
+//  a name reads the system's locale data and costs far more than most conversions, so  //
+//  code that names its narrow encoding per call should look the locale up here once.   //
+//                                                                                      //
+//  Lookups may happen on any number of threads. Names are spread over sixteen shards,  //
+//  each with its own reader-writer lock, so lookups of cached names take only a        //
+//  shared lock and do not contend with each other. Entries are never removed; the      //
+//  returned references remain valid for the lifetime of the registry.                  //
+//                                                                                      //
+//  The to_string() overloads below take a locale name in place of a codecvt argument,  //
+//  and look it up in codecvt_registry::global():                                       //
+//                                                                                      //
+//    std::string sjis = to_string<narrow>(u16s, "ja_JP.SJIS");                         //
+//    std::u16string u16 = to_string<utf16>(boost::string_view(sjis), "ja_JP.SJIS");    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_CODECVT_REGISTRY_HPP)
+#define BOOST_UNICODE_CODECVT_REGISTRY_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <locale>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  class codecvt_registry
+  {
+  public:
+    using wide_codecvt_type = std::codecvt<wchar_t, char, std::mbstate_t>;
+
+    codecvt_registry() = default;
+    codecvt_registry(const codecvt_registry&) = delete;
+    codecvt_registry& operator=(const codecvt_registry&) = delete;
+
+    //  Returns: the locale named name, constructed by the first lookup of name.
+    //  Throws: std::runtime_error if name is not a valid locale name, as std::locale
+    //  does. Failed lookups are not cached.
+    const std::locale& locale(boost::string_view name);
+
+    //  Returns: std::use_facet<wide_codecvt_type>(locale(name))
+    const wide_codecvt_type& wide_codecvt(boost::string_view name);
+
+    //  Returns: the number of locales cached
+    std::size_t size() const;
+
+    //  Returns: the registry used by the to_string() overloads taking a locale name. It
+    //  is never destroyed, so its references remain valid during static destruction.
+    static codecvt_registry& global();
+
+  private:  // exposition only
+    struct entry
+    {
+      explicit entry(const std::string& name);
+      std::locale              loc;
+      const wide_codecvt_type* ccvt;
+    };
+
+    struct shard
+    {
+      mutable std::shared_timed_mutex                               mutex;
+      std::map<std::string, std::unique_ptr<entry>, std::less<>>  entries;
+    };
+
+    static constexpr std::size_t shard_count = 16;
+
+    const entry& find(boost::string_view name);
+    shard& shard_of(boost::string_view name);
+
+    std::array<shard, shard_count> shards_;
+  };
+
+  //  [uni.to_string] string encoding conversion, codecvt looked up by locale name
+  //
+  //  Effects: as the to_string() overloads of string_encoding.hpp, with
+  //  codecvt_registry::global().wide_codecvt(locale_name) in place of locale_name.
+  template <class ToEncoding = utf8, class ...Pack>
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::string_view v, const char* locale_name, const Pack& ... args);
+  template <class ToEncoding = utf8, class ...Pack>
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::string_view v, const char* from_locale_name,
+        const char* to_locale_name, const Pack& ... args);
+  template <class ToEncoding = utf8, class ...Pack>
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::u16string_view v, const char* locale_name, const Pack& ... args);
+  template <class ToEncoding = utf8, class ...Pack>
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::u32string_view v, const char* locale_name, const Pack& ... args);
+  template <class ToEncoding = utf8, class ...Pack>
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::wstring_view v, const char* locale_name, const Pack& ... args);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  //  codecvt_registry  ----------------------------------------------------------------//
+
+  inline codecvt_registry::entry::entry(const std::string& name)
+    : loc(name), ccvt(&std::use_facet<wide_codecvt_type>(loc))
+  {}
+
+  inline codecvt_registry::shard& codecvt_registry::shard_of(boost::string_view name)
+  {
+    std::size_t h = 2166136261u;  // FNV-1a
+    for (char c : name)
+      h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+    return shards_[h % shard_count];
+  }
+
+  inline const codecvt_registry::entry& codecvt_registry::find(boost::string_view name)
+  {
+    shard& s = shard_of(name);
+    {
+      std::shared_lock<std::shared_timed_mutex> lock(s.mutex);
+      auto it = s.entries.find(name);
+      if (it != s.entries.end())
+        return *it->second;
+    }
+
+    //  construct the locale without holding the lock; if another thread got there
+    //  first, its entry is kept and this one discarded
+    std::string key(name.data(), name.size());
+    std::unique_ptr<entry> e(new entry(key));
+    std::lock_guard<std::shared_timed_mutex> lock(s.mutex);
+    return *s.entries.emplace(std::move(key), std::move(e)).first->second;
+  }
+
+  inline const std::locale& codecvt_registry::locale(boost::string_view name)
+  {
+    return find(name).loc;
+  }
+
+  inline const codecvt_registry::wide_codecvt_type&
+    codecvt_registry::wide_codecvt(boost::string_view name)
+  {
+    return *find(name).ccvt;
+  }
+
+  inline std::size_t codecvt_registry::size() const
+  {
+    std::size_t n = 0;
+    for (const shard& s : shards_)
+    {
+      std::shared_lock<std::shared_timed_mutex> lock(s.mutex);
+      n += s.entries.size();
+    }
+    return n;
+  }
+
+  inline codecvt_registry& codecvt_registry::global()
+  {
+    static codecvt_registry* registry = new codecvt_registry;
+    return *registry;
+  }
+
+  //  to_string  -----------------------------------------------------------------------//
+
+  template <class ToEncoding, class ...Pack> inline
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::string_view v, const char* locale_name, const Pack& ... args)
+  {
+    return to_string<ToEncoding>(v,
+      codecvt_registry::global().wide_codecvt(locale_name), args ...);
+  }
+
+  template <class ToEncoding, class ...Pack> inline
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::string_view v, const char* from_locale_name,
+        const char* to_locale_name, const Pack& ... args)
+  {
+    codecvt_registry& registry = codecvt_registry::global();
+    return to_string<ToEncoding>(v, registry.wide_codecvt(from_locale_name),
+      registry.wide_codecvt(to_locale_name), args ...);
+  }
+
+  template <class ToEncoding, class ...Pack> inline
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::u16string_view v, const char* locale_name, const Pack& ... args)
+  {
+    return to_string<ToEncoding>(v,
+      codecvt_registry::global().wide_codecvt(locale_name), args ...);
+  }
+
+  template <class ToEncoding, class ...Pack> inline
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::u32string_view v, const char* locale_name, const Pack& ... args)
+  {
+    return to_string<ToEncoding>(v,
+      codecvt_registry::global().wide_codecvt(locale_name), args ...);
+  }
+
+  template <class ToEncoding, class ...Pack> inline
+    std::basic_string<typename ToEncoding::value_type>
+      to_string(boost::wstring_view v, const char* locale_name, const Pack& ... args)
+  {
+    return to_string<ToEncoding>(v,
+      codecvt_registry::global().wide_codecvt(locale_name), args ...);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_CODECVT_REGISTRY_HPP
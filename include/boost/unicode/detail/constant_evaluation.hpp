@@ -0,0 +1,56 @@
+﻿//  boost/unicode/detail/constant_evaluation.hpp  --------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  in_constant_evaluation() lets the constexpr UTF paths step around the parts that    //
+//  cannot run at compile time: the instrumentation counters, the SWAR loops, which     //
+//  load through memcpy, and the SSE2 loops. Where the compiler gives no way to tell,   //
+//  it returns false, and those paths remain constexpr only for inputs that never      //
+//  reach such code, such as non-pointer iterators with instrumentation disabled.       //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_DETAIL_CONSTANT_EVALUATION_HPP)
+#define BOOST_UNICODE_DETAIL_CONSTANT_EVALUATION_HPP
+
+#include <type_traits>
+#include <boost/config.hpp>
+
+#if defined(__cpp_lib_is_constant_evaluated)
+# define BOOST_UNICODE_IS_CONSTANT_EVALUATED() std::is_constant_evaluated()
+#elif defined(__clang__)
+# if defined(__has_builtin)
+#   if __has_builtin(__builtin_is_constant_evaluated)
+#     define BOOST_UNICODE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#   endif
+# endif
+#elif defined(__GNUC__) && __GNUC__ >= 9
+# define BOOST_UNICODE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#elif defined(_MSC_VER) && _MSC_VER >= 1925
+# define BOOST_UNICODE_IS_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#endif
+
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  constexpr bool in_constant_evaluation() noexcept
+  {
+#  if defined(BOOST_UNICODE_IS_CONSTANT_EVALUATED)
+    return BOOST_UNICODE_IS_CONSTANT_EVALUATED();
+#  else
+    return false;
+#  endif
+  }
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_DETAIL_CONSTANT_EVALUATION_HPP
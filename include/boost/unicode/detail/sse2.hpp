@@ -0,0 +1,158 @@
+﻿//  boost/unicode/detail/sse2.hpp  -----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  SSE2 helpers for contiguous UTF input, sixteen code units per step. SSE2 is part    //
+//  of every x86-64 target, so no run time dispatch is needed; elsewhere, or if         //
+//  BOOST_UNICODE_NO_SIMD is defined, BOOST_UNICODE_SSE2 is left undefined and callers  //
+//  use their code unit at a time loops.                                                //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_DETAIL_SSE2_HPP)
+#define BOOST_UNICODE_DETAIL_SSE2_HPP
+
+#if !defined(BOOST_UNICODE_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) \
+  || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+# define BOOST_UNICODE_SSE2
+#endif
+
+#if defined(BOOST_UNICODE_SSE2)
+
+#include <cstddef>
+#include <cstdint>
+#include <emmintrin.h>
+
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  constexpr std::size_t sse2_block_size = 16;
+
+  //  SSE2 has only signed 32-bit compares; flipping the sign bit of both operands gives
+  //  the unsigned comparison
+  inline __m128i sse2_u32_greater(__m128i a, __m128i b) noexcept
+  {
+    const __m128i sign = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    return _mm_cmpgt_epi32(_mm_xor_si128(a, sign), _mm_xor_si128(b, sign));
+  }
+
+  //  p points to sixteen 32-bit code units
+  //  returns: the bitwise or of the code points, or 0xFFFFFFFF if any is a surrogate or
+  //  above U+10FFFF
+  inline char32_t sse2_utf32_block_bits(const void* p) noexcept
+  {
+    const __m128i* v = static_cast<const __m128i*>(p);
+    const __m128i surrogate_first = _mm_set1_epi32(0xD800);
+    const __m128i surrogate_count = _mm_set1_epi32(0x800);
+    const __m128i max_code_point = _mm_set1_epi32(0x10FFFF);
+
+    __m128i bits = _mm_setzero_si128();
+    __m128i ill_formed = _mm_setzero_si128();
+    for (std::size_t i = 0; i < sse2_block_size / 4; ++i)
+    {
+      __m128i u32 = _mm_loadu_si128(v + i);
+      bits = _mm_or_si128(bits, u32);
+      ill_formed = _mm_or_si128(ill_formed, sse2_u32_greater(u32, max_code_point));
+      //  u32 - 0xD800 < 0x800 for surrogates
+      ill_formed = _mm_or_si128(ill_formed, sse2_u32_greater(surrogate_count,
+        _mm_sub_epi32(u32, surrogate_first)));
+    }
+    if (_mm_movemask_epi8(ill_formed))
+      return 0xFFFFFFFFu;
+    bits = _mm_or_si128(bits, _mm_shuffle_epi32(bits, _MM_SHUFFLE(1, 0, 3, 2)));
+    bits = _mm_or_si128(bits, _mm_shuffle_epi32(bits, _MM_SHUFFLE(2, 3, 0, 1)));
+    return static_cast<char32_t>(_mm_cvtsi128_si32(bits));
+  }
+
+  //  p points to sixteen code points below U+10000
+  inline void sse2_utf32_to_utf16(const void* p, std::uint16_t* out) noexcept
+  {
+    //  the pack saturates signed values, so the range is shifted down and back
+    const __m128i* v = static_cast<const __m128i*>(p);
+    const __m128i bias32 = _mm_set1_epi32(0x8000);
+    const __m128i bias16 = _mm_set1_epi16(static_cast<short>(0x8000));
+    for (std::size_t i = 0; i < sse2_block_size / 8; ++i)
+    {
+      __m128i low = _mm_sub_epi32(_mm_loadu_si128(v + 2 * i), bias32);
+      __m128i high = _mm_sub_epi32(_mm_loadu_si128(v + 2 * i + 1), bias32);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 8 * i),
+        _mm_xor_si128(_mm_packs_epi32(low, high), bias16));
+    }
+  }
+
+  //  p points to sixteen UTF-8 octets
+  //  Effects: stores each octet, zero extended, in out
+  //  returns: a mask with bit i set if octet i is not ASCII
+  inline unsigned sse2_widen_octets(const void* p, std::uint32_t* out) noexcept
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i octets = _mm_loadu_si128(static_cast<const __m128i*>(p));
+    __m128i low = _mm_unpacklo_epi8(octets, zero);
+    __m128i high = _mm_unpackhi_epi8(octets, zero);
+    __m128i* v = reinterpret_cast<__m128i*>(out);
+    _mm_storeu_si128(v, _mm_unpacklo_epi16(low, zero));
+    _mm_storeu_si128(v + 1, _mm_unpackhi_epi16(low, zero));
+    _mm_storeu_si128(v + 2, _mm_unpacklo_epi16(high, zero));
+    _mm_storeu_si128(v + 3, _mm_unpackhi_epi16(high, zero));
+    return static_cast<unsigned>(_mm_movemask_epi8(octets));
+  }
+
+  //  p points to sixteen UTF-16 code units
+  //  Effects: stores each code unit, zero extended, in out
+  //  returns: a mask with bit i set if code unit i is a surrogate
+  inline unsigned sse2_widen_utf16(const void* p, std::uint32_t* out) noexcept
+  {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i surrogate_bits = _mm_set1_epi16(static_cast<short>(0xD800));
+    const __m128i* in = static_cast<const __m128i*>(p);
+    __m128i* v = reinterpret_cast<__m128i*>(out);
+    __m128i surrogates[2];
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+      __m128i units = _mm_loadu_si128(in + i);
+      _mm_storeu_si128(v + 2 * i, _mm_unpacklo_epi16(units, zero));
+      _mm_storeu_si128(v + 2 * i + 1, _mm_unpackhi_epi16(units, zero));
+      surrogates[i] = _mm_cmpeq_epi16(_mm_and_si128(units, surrogate_mask),
+        surrogate_bits);
+    }
+    //  the compare results are 0 or -1, so a signed pack keeps one byte per unit
+    return static_cast<unsigned>(_mm_movemask_epi8(
+      _mm_packs_epi16(surrogates[0], surrogates[1])));
+  }
+
+  //  p points to sixteen UTF-16 code units
+  //  returns: a mask with bit i set if code unit i is a surrogate, or if nul is true and
+  //  code unit i is zero
+  inline unsigned sse2_utf16_surrogate_bits(const void* p, bool nul) noexcept
+  {
+    const __m128i surrogate_mask = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i surrogate_bits = _mm_set1_epi16(static_cast<short>(0xD800));
+    const __m128i zero = nul ? _mm_setzero_si128() : surrogate_bits;
+    const __m128i* in = static_cast<const __m128i*>(p);
+    __m128i found[2];
+    for (std::size_t i = 0; i < 2; ++i)
+    {
+      __m128i units = _mm_loadu_si128(in + i);
+      found[i] = _mm_or_si128(
+        _mm_cmpeq_epi16(_mm_and_si128(units, surrogate_mask), surrogate_bits),
+        _mm_cmpeq_epi16(units, zero));
+    }
+    return static_cast<unsigned>(_mm_movemask_epi8(_mm_packs_epi16(found[0], found[1])));
+  }
+
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_SSE2
+
+#endif  // BOOST_UNICODE_DETAIL_SSE2_HPP
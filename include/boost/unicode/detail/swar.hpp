@@ -0,0 +1,146 @@
+﻿//  boost/unicode/detail/swar.hpp  -----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  SIMD-within-a-register (SWAR) helpers for contiguous UTF-8 sequences. Eight octets  //
+//  are examined per step using only portable 64-bit integer arithmetic, so there are   //
+//  no instruction set or alignment requirements. Callers are responsible for only      //
+//  trusting the counts below on sequences already known to be well-formed.             //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_DETAIL_SWAR_HPP)
+#define BOOST_UNICODE_DETAIL_SWAR_HPP
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <boost/unicode/instrumentation.hpp>
+#include <boost/unicode/detail/constant_evaluation.hpp>
+
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  using swar_word = std::uint64_t;
+
+  constexpr std::size_t swar_size = sizeof(swar_word);
+  constexpr swar_word swar_high_bits = 0x8080808080808080u;
+  constexpr swar_word swar_low_bits = 0x0101010101010101u;
+
+  //  memcpy is the portable way to do an unaligned load; compilers turn it into a
+  //  single move instruction
+  inline swar_word swar_load(const char* p) noexcept
+  {
+    swar_word w;
+    std::memcpy(&w, p, swar_size);
+    return w;
+  }
+
+  //  number of octets with the high bit set; x must have only high bits set
+  inline std::size_t swar_count_high_bits(swar_word x) noexcept
+  {
+    return static_cast<std::size_t>((((x >> 7) * swar_low_bits) >> 56) & 0xFFu);
+  }
+
+  //  UTF-8 continuation octets are 10xxxxxx
+  inline swar_word swar_continuation_bits(swar_word w) noexcept
+  {
+    return w & ~(w << 1) & swar_high_bits;
+  }
+
+  //  UTF-8 lead octets of four octet sequences are 11110xxx; F8-FF never appear in
+  //  well-formed UTF-8, so testing the top four bits is sufficient
+  inline swar_word swar_four_octet_lead_bits(swar_word w) noexcept
+  {
+    return w & (w << 1) & (w << 2) & (w << 3) & swar_high_bits;
+  }
+
+  //  zero octets have their high bit set; an octet above a zero octet may be marked too,
+  //  so the result is exact only as to whether there is any
+  inline swar_word swar_zero_bits(swar_word w) noexcept
+  {
+    return (w - swar_low_bits) & ~w & swar_high_bits;
+  }
+
+  //  returns: pointer to the first octet in [first, last) that is not 7-bit ASCII, or
+  //  last if there is none
+  inline const char* ascii_end(const char* first, const char* last) noexcept
+  {
+    const char* start = first;
+    for (; static_cast<std::size_t>(last - first) >= swar_size; first += swar_size)
+    {
+      if (swar_load(first) & swar_high_bits)
+        break;
+    }
+    BOOST_UNICODE_COUNT(fast_path_blocks, (first - start) / swar_size);
+    BOOST_UNICODE_COUNT(slow_path_blocks, first != last);
+    for (; first != last && (static_cast<unsigned char>(*first) & 0x80u) == 0; ++first)
+      {}
+    return first;
+  }
+
+  //  skip_ascii: bypass a run of 7-bit ASCII, eight octets at a time when contiguous
+  //  and not in a constant expression
+  template <class ForwardIterator>
+  inline BOOST_CXX14_CONSTEXPR
+  ForwardIterator skip_ascii(ForwardIterator first, ForwardIterator) noexcept
+  {
+    return first;
+  }
+  inline BOOST_CXX14_CONSTEXPR
+  const char* skip_ascii(const char* first, const char* last) noexcept
+  {
+    return in_constant_evaluation() ? first : ascii_end(first, last);
+  }
+
+  //  returns: number of code points in the well-formed UTF-8 sequence [first, last)
+  inline std::size_t swar_utf8_code_points(const char* first, const char* last) noexcept
+  {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    BOOST_UNICODE_COUNT(fast_path_blocks, n / swar_size);
+    BOOST_UNICODE_COUNT(slow_path_blocks, n % swar_size != 0);
+    for (; static_cast<std::size_t>(last - first) >= swar_size; first += swar_size)
+      n -= swar_count_high_bits(swar_continuation_bits(swar_load(first)));
+    for (; first != last; ++first)
+      if ((static_cast<unsigned char>(*first) & 0xC0u) == 0x80u)
+        --n;
+    return n;
+  }
+
+  //  returns: number of UTF-16 code units needed to represent the well-formed UTF-8
+  //  sequence [first, last)
+  inline std::size_t swar_utf8_utf16_length(const char* first, const char* last) noexcept
+  {
+    std::size_t n = static_cast<std::size_t>(last - first);
+    BOOST_UNICODE_COUNT(fast_path_blocks, n / swar_size);
+    BOOST_UNICODE_COUNT(slow_path_blocks, n % swar_size != 0);
+    for (; static_cast<std::size_t>(last - first) >= swar_size; first += swar_size)
+    {
+      swar_word w = swar_load(first);
+      n -= swar_count_high_bits(swar_continuation_bits(w));
+      n += swar_count_high_bits(swar_four_octet_lead_bits(w));
+    }
+    for (; first != last; ++first)
+    {
+      unsigned octet = static_cast<unsigned char>(*first);
+      if ((octet & 0xC0u) == 0x80u)
+        --n;
+      else if (octet >= 0xF0u)
+        ++n;
+    }
+    return n;
+  }
+
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_DETAIL_SWAR_HPP
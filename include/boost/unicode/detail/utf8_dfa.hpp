@@ -0,0 +1,327 @@
+﻿//  boost/unicode/detail/utf8_dfa.hpp  -------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Table-driven UTF-8 decoder and validator, after Bjoern Hoehrmann's "Flexible and    //
+//  Economical UTF-8 Decoder". Each octet is mapped to one of 14 classes, and the       //
+//  class and current state select the next state, so there is one table lookup per     //
+//  octet in place of the cascade of range tests. Both tables are generated at compile  //
+//  time from utf8_dfa_class() and utf8_dfa_transition() below.                         //
+//                                                                                      //
+//  Decoding and validation run the same state machine, so an error range reported by   //
+//  utf8_dfa_first_ill_formed() begins with the octets that utf8_dfa_decode() consumes  //
+//  for the ill-formed sequence, and then, as utf8_first_ill_formed_branchy() does,     //
+//  runs on through any further octets that cannot begin a sequence. The machine        //
+//  splits ill-formed input the way utf8_decode_branchy() does: a lead octet claims as  //
+//  many continuation octets as it calls for, even when an earlier one has already      //
+//  made the sequence ill-formed.                                                       //
+//                                                                                      //
+//  Define BOOST_UNICODE_UTF8_DFA, consistently across the program, to make this the    //
+//  backend for utf8_decode() and first_ill_formed(). Conversions and error ranges are  //
+//  the same either way.                                                                //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_DETAIL_UTF8_DFA_HPP)
+#define BOOST_UNICODE_DETAIL_UTF8_DFA_HPP
+
+#include <array>
+#include <cstddef>
+#include <utility>
+#include <boost/config.hpp>
+#include <boost/unicode/instrumentation.hpp>
+#include <boost/unicode/detail/swar.hpp>
+
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  octet classes
+  enum : unsigned char
+  {
+    dfa_ascii,       // 00-7F
+    dfa_cont_80,     // 80-8F  continuation octets, split where a second octet's
+    dfa_cont_90,     // 90-9F    valid range may begin or end
+    dfa_cont_a0,     // A0-BF
+    dfa_lead_c0,     // C0-C1  always overlong
+    dfa_lead_c2,     // C2-DF
+    dfa_lead_e0,     // E0     second octet A0-BF
+    dfa_lead_e1,     // E1-EC, EE-EF
+    dfa_lead_ed,     // ED     second octet 80-9F
+    dfa_lead_f0,     // F0     second octet 90-BF
+    dfa_lead_f1,     // F1-F3
+    dfa_lead_f4,     // F4     second octet 80-8F
+    dfa_lead_f5,     // F5-F7  always above U+10FFFF
+    dfa_not_lead,    // F8-FF
+    dfa_class_count
+  };
+
+  //  states; those from dfa_invalid on are final, and all but dfa_accept are errors
+  enum : unsigned char
+  {
+    dfa_accept,       // at the start of a sequence, or just past a well-formed one
+    dfa_need_1,       // well-formed so far, needing 1, 2, or 3 more continuation octets
+    dfa_need_2,
+    dfa_need_3,
+    dfa_after_e0,     // lead octets whose second octet is restricted
+    dfa_after_ed,
+    dfa_after_f0,
+    dfa_after_f4,
+    dfa_overlong_1,   // ill-formed, but still consuming 1, 2, or 3 continuation octets
+    dfa_overlong_2,
+    dfa_surrogate_1,
+    dfa_range_1,
+    dfa_range_2,
+    dfa_range_3,
+    dfa_invalid,      // octet that cannot begin a sequence; consumed
+    dfa_truncated,    // continuation octet missing; the offending octet is not consumed
+    dfa_overlong,
+    dfa_surrogate,
+    dfa_out_of_range,
+    dfa_state_count
+  };
+
+  constexpr unsigned char utf8_dfa_class(unsigned octet) BOOST_NOEXCEPT
+  {
+    return octet <= 0x7Fu ? dfa_ascii
+      : octet <= 0x8Fu ? dfa_cont_80
+      : octet <= 0x9Fu ? dfa_cont_90
+      : octet <= 0xBFu ? dfa_cont_a0
+      : octet <= 0xC1u ? dfa_lead_c0
+      : octet <= 0xDFu ? dfa_lead_c2
+      : octet == 0xE0u ? dfa_lead_e0
+      : octet == 0xEDu ? dfa_lead_ed
+      : octet <= 0xEFu ? dfa_lead_e1
+      : octet == 0xF0u ? dfa_lead_f0
+      : octet <= 0xF3u ? dfa_lead_f1
+      : octet == 0xF4u ? dfa_lead_f4
+      : octet <= 0xF7u ? dfa_lead_f5
+      : dfa_not_lead;
+  }
+
+  constexpr unsigned char utf8_dfa_start(unsigned c) BOOST_NOEXCEPT
+  {
+    return c == dfa_ascii ? dfa_accept
+      : c == dfa_lead_c0 ? dfa_overlong_1
+      : c == dfa_lead_c2 ? dfa_need_1
+      : c == dfa_lead_e0 ? dfa_after_e0
+      : c == dfa_lead_e1 ? dfa_need_2
+      : c == dfa_lead_ed ? dfa_after_ed
+      : c == dfa_lead_f0 ? dfa_after_f0
+      : c == dfa_lead_f1 ? dfa_need_3
+      : c == dfa_lead_f4 ? dfa_after_f4
+      : c == dfa_lead_f5 ? dfa_range_3
+      : dfa_invalid;  // continuation octets and F8-FF
+  }
+
+  //  the state after a continuation octet of class c
+  constexpr unsigned char utf8_dfa_continue(unsigned s, unsigned c) BOOST_NOEXCEPT
+  {
+    return s == dfa_need_1 ? dfa_accept
+      : s == dfa_need_2 ? dfa_need_1
+      : s == dfa_need_3 ? dfa_need_2
+      : s == dfa_after_e0 ? (c == dfa_cont_a0 ? dfa_need_1 : dfa_overlong_1)
+      : s == dfa_after_ed ? (c == dfa_cont_a0 ? dfa_surrogate_1 : dfa_need_1)
+      : s == dfa_after_f0 ? (c == dfa_cont_80 ? dfa_overlong_2 : dfa_need_2)
+      : s == dfa_after_f4 ? (c == dfa_cont_80 ? dfa_need_2 : dfa_range_2)
+      : s == dfa_overlong_1 ? dfa_overlong
+      : s == dfa_overlong_2 ? dfa_overlong_1
+      : s == dfa_surrogate_1 ? dfa_surrogate
+      : s == dfa_range_1 ? dfa_out_of_range
+      : s == dfa_range_2 ? dfa_range_1
+      : dfa_range_2;  // dfa_range_3
+  }
+
+  constexpr unsigned char utf8_dfa_transition(unsigned s, unsigned c) BOOST_NOEXCEPT
+  {
+    return s == dfa_accept ? utf8_dfa_start(c)
+      : s >= dfa_invalid ? static_cast<unsigned char>(s)  // final states are never left
+      : c == dfa_cont_80 || c == dfa_cont_90 || c == dfa_cont_a0 ? utf8_dfa_continue(s, c)
+      : static_cast<unsigned char>(dfa_truncated);
+  }
+
+  //  the bits of a lead octet that contribute to the code point
+  constexpr unsigned char utf8_dfa_lead_mask(unsigned c) BOOST_NOEXCEPT
+  {
+    return c == dfa_ascii ? 0x7Fu
+      : c == dfa_lead_c0 || c == dfa_lead_c2 ? 0x1Fu
+      : c == dfa_lead_e0 || c == dfa_lead_e1 || c == dfa_lead_ed ? 0x0Fu
+      : c == dfa_cont_80 || c == dfa_cont_90 || c == dfa_cont_a0 || c == dfa_not_lead
+        ? 0u
+      : 0x07u;  // four octet lead octets
+  }
+
+  template <std::size_t... I>
+  constexpr std::array<unsigned char, sizeof...(I)>
+    make_utf8_dfa_classes(std::index_sequence<I...>) BOOST_NOEXCEPT
+  {
+    return {{ utf8_dfa_class(I)... }};
+  }
+
+  //  States are stored premultiplied by dfa_class_count, so that the next state is
+  //  found with a single addition; the largest, 18 * 14, still fits in an octet.
+  constexpr unsigned dfa_row(unsigned s) BOOST_NOEXCEPT { return s * dfa_class_count; }
+
+  template <std::size_t... I>
+  constexpr std::array<unsigned char, sizeof...(I)>
+    make_utf8_dfa_transitions(std::index_sequence<I...>) BOOST_NOEXCEPT
+  {
+    return {{ static_cast<unsigned char>(
+      dfa_row(utf8_dfa_transition(I / dfa_class_count, I % dfa_class_count)))... }};
+  }
+
+  template <std::size_t... I>
+  constexpr std::array<unsigned char, sizeof...(I)>
+    make_utf8_dfa_lead_masks(std::index_sequence<I...>) BOOST_NOEXCEPT
+  {
+    return {{ utf8_dfa_lead_mask(I)... }};
+  }
+
+  constexpr std::array<unsigned char, 256> utf8_dfa_classes
+    = make_utf8_dfa_classes(std::make_index_sequence<256>());
+  constexpr std::array<unsigned char, dfa_state_count * dfa_class_count>
+    utf8_dfa_transitions = make_utf8_dfa_transitions(
+      std::make_index_sequence<dfa_state_count * dfa_class_count>());
+  constexpr std::array<unsigned char, dfa_class_count> utf8_dfa_lead_masks
+    = make_utf8_dfa_lead_masks(std::make_index_sequence<dfa_class_count>());
+
+  //  row is a premultiplied state, as is the result
+  inline BOOST_CXX14_CONSTEXPR unsigned utf8_dfa_next(unsigned row, unsigned octet)
+    BOOST_NOEXCEPT
+  {
+    return utf8_dfa_transitions[row + utf8_dfa_classes[octet]];
+  }
+
+  //  true for the states within a sequence
+  constexpr bool utf8_dfa_pending(unsigned row) BOOST_NOEXCEPT
+  {
+    return row - 1u < dfa_row(dfa_invalid) - 1u;
+  }
+
+  //  utf8_dfa_decode
+  //
+  //  Same contract as utf8_decode(): decodes the code point beginning at first,
+  //  advancing first past it. Returns true if the sequence is well-formed, otherwise
+  //  false and first has been advanced past the ill-formed sequence. Requires:
+  //  first != last.
+
+  //  the rest of a sequence whose lead octet, of class c, was not ASCII
+  template <class InputIterator>
+  BOOST_NOINLINE BOOST_CXX14_CONSTEXPR
+  bool utf8_dfa_decode_sequence(InputIterator& first, InputIterator last, char32_t& u32,
+    unsigned c)
+  {
+    unsigned row = utf8_dfa_transitions[c];  // from dfa_accept
+    int octets = 1;
+
+    while (utf8_dfa_pending(row))
+    {
+      if (first == last)
+      {
+        row = dfa_row(dfa_truncated);
+        break;
+      }
+      unsigned octet = static_cast<unsigned char>(*first);
+      row = utf8_dfa_next(row, octet);
+      if (row == dfa_row(dfa_truncated))
+        break;
+      ++first;
+      ++octets;
+      u32 = (u32 << 6) + (octet & 0x3Fu);
+    }
+    BOOST_UNICODE_COUNT(bytes_in, octets);
+
+    switch (row / dfa_class_count)
+    {
+      case dfa_accept:
+        return true;
+      case dfa_invalid:
+        BOOST_UNICODE_COUNT(invalid, 1);
+        break;
+      case dfa_truncated:
+        BOOST_UNICODE_COUNT(truncated, 1);
+        break;
+      case dfa_overlong:
+        BOOST_UNICODE_COUNT(overlong, 1);
+        break;
+      case dfa_surrogate:
+        BOOST_UNICODE_COUNT(surrogate, 1);
+        break;
+      default:
+        BOOST_UNICODE_COUNT(out_of_range, 1);
+    }
+    return false;
+  }
+
+  template <class InputIterator>
+  inline BOOST_CXX14_CONSTEXPR
+  bool utf8_dfa_decode(InputIterator& first, InputIterator last, char32_t& u32)
+  {
+    unsigned octet = static_cast<unsigned char>(*first++);
+    if (octet <= 0x7Fu)  // 7-bit ASCII needs no table
+    {
+      BOOST_UNICODE_COUNT(bytes_in, 1);
+      u32 = octet;
+      return true;
+    }
+    unsigned c = utf8_dfa_classes[octet];
+    u32 = octet & utf8_dfa_lead_masks[c];
+    return utf8_dfa_decode_sequence(first, last, u32, c);
+  }
+
+  //  utf8_dfa_first_ill_formed
+  //
+  //  returns: the first ill-formed sequence in [first, last), as utf8_dfa_decode()
+  //  would consume it, together with any following octets that cannot begin a
+  //  sequence, or [last, last) if there is none
+
+  template <class ForwardIterator>
+  inline BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
+    utf8_dfa_first_ill_formed(ForwardIterator first, ForwardIterator last) BOOST_NOEXCEPT
+  {
+    ForwardIterator sequence = first;  // first octet of the current sequence
+    unsigned row = dfa_row(dfa_accept);
+
+    while (first != last)
+    {
+      unsigned octet = static_cast<unsigned char>(*first);
+      row = utf8_dfa_next(row, octet);
+      if (row == dfa_row(dfa_accept))
+      {
+        ++first;
+        if (octet <= 0x7Fu)  // more ASCII is likely
+          first = skip_ascii(first, last);
+        sequence = first;
+      }
+      else if (row < dfa_row(dfa_invalid))
+        ++first;
+      else
+      {
+        if (row != dfa_row(dfa_truncated))
+          ++first;
+        //  as utf8_first_ill_formed_branchy() does, run the error on through octets
+        //  that cannot begin a sequence
+        for (; first != last
+               && (((octet = static_cast<unsigned char>(*first)) >= 0x80u
+                 && octet <= 0xC1u)
+                 || (octet >= 0xF5u && octet <= 0xFEu));
+             ++first) {}
+        return std::make_pair(sequence, first);
+      }
+    }
+    return row == dfa_row(dfa_accept)
+      ? std::make_pair(last, last) : std::make_pair(sequence, last);
+  }
+
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_DETAIL_UTF8_DFA_HPP
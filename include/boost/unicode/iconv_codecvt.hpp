@@ -0,0 +1,308 @@
+﻿//  boost/unicode/iconv_codecvt.hpp  ---------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  iconv_codecvt<InternT> is a codecvt facet between UTF-16 (char16_t, or wchar_t      //
+//  where it is 16 bits) or UTF-32 (char32_t, or wchar_t where it is 32 bits) and any   //
+//  narrow encoding the POSIX iconv() implementation knows by name. It brings Big5,     //
+//  Shift-JIS, GB18030, and the rest to to_string(), batch conversions, and file        //
+//  streams, none of which can use recoder:                                             //
+//                                                                                      //
+//    iconv_codecvt<wchar_t> sjis("SJIS");                                              //
+//    std::string s = to_string<narrow>(u16s, sjis);                                    //
+//    std::wstring ws = to_string<wide>(boost::string_view(s), sjis);                   //
+//                                                                                      //
+//  An iconv descriptor holds conversion state, so no two threads may use one at once,  //
+//  while a facet is shared by every stream and thread using its locale. Each facet     //
+//  keeps a pool of descriptors; each call takes one from the pool, or opens one if the //
+//  pool is empty, and puts it back when done. The pool grows to the number of threads  //
+//  converting at once, and the descriptors are closed when the facet is destroyed.     //
+//                                                                                      //
+//  Each call starts in the initial shift state, and do_out() returns to it before      //
+//  returning, so the facet keeps no state in mbstate_t. For stateful encodings such as //
+//  ISO-2022-JP, input to do_in() must therefore not be split within a shifted run;     //
+//  to_string() passes all of its input to the first call.                              //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_ICONV_CODECVT_HPP)
+#define BOOST_UNICODE_ICONV_CODECVT_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cwchar>
+#include <locale>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <iconv.h>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  template <class InternT>
+  class iconv_codecvt : public std::codecvt<InternT, char, std::mbstate_t>
+  {
+    static_assert(std::is_same<InternT, char16_t>::value
+      || std::is_same<InternT, char32_t>::value || std::is_same<InternT, wchar_t>::value,
+      "InternT must be char16_t, char32_t, or wchar_t");
+  public:
+    using intern_type = InternT;
+    using extern_type = char;
+    using state_type = std::mbstate_t;
+    using result = std::codecvt_base::result;
+
+    //  Effects: opens a descriptor for each direction, so that a name iconv() does
+    //  not know is reported here rather than by the first conversion.
+    //  Throws: std::system_error if iconv_open() fails.
+    explicit iconv_codecvt(const std::string& name, std::size_t refs = 0);
+    ~iconv_codecvt();
+
+    const std::string& name() const noexcept { return name_; }
+
+  protected:
+    result do_in(state_type& state, const char* from, const char* from_end,
+      const char*& from_next, InternT* to, InternT* to_end, InternT*& to_next)
+      const override;
+    result do_out(state_type& state, const InternT* from, const InternT* from_end,
+      const InternT*& from_next, char* to, char* to_end, char*& to_next)
+      const override;
+    result do_unshift(state_type&, char* to, char*, char*& to_next) const override
+    {
+      to_next = to;
+      return std::codecvt_base::noconv;
+    }
+
+    int do_encoding() const BOOST_NOEXCEPT_OR_NOTHROW override { return 0; }
+    bool do_always_noconv() const BOOST_NOEXCEPT_OR_NOTHROW override { return false; }
+    int do_length(state_type&, const char* from, const char* from_end,
+      std::size_t max) const override;
+    int do_max_length() const BOOST_NOEXCEPT_OR_NOTHROW override { return MB_LEN_MAX; }
+
+  private:  // exposition only
+    class descriptor;  // a descriptor taken from a pool, returned on destruction
+
+    iconv_t open(const char* to_name, const char* from_name) const;
+
+    std::string                  name_;
+    const char*                  intern_name_;  // "UTF-16LE", "UTF-32BE", etc.
+    mutable std::mutex           mutex_;
+    mutable std::vector<iconv_t> in_pool_;      // name_ to intern_name_
+    mutable std::vector<iconv_t> out_pool_;     // intern_name_ to name_
+  };
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  the iconv name of the encoding of InternT in native byte order; "UTF-16" and
+  //  "UTF-32" would have iconv() write a BOM
+  template <class InternT>
+  inline const char* iconv_intern_name()
+  {
+    const char16_t probe = 1;
+    const bool little = *reinterpret_cast<const unsigned char*>(&probe) == 1;
+    if (sizeof(InternT) == 2)
+      return little ? "UTF-16LE" : "UTF-16BE";
+    return little ? "UTF-32LE" : "UTF-32BE";
+  }
+
+  //  iconv() with the result reported as a codecvt result
+  inline std::codecvt_base::result iconv_call(iconv_t cd, const char*& from,
+    std::size_t& from_left, char*& to, std::size_t& to_left)
+  {
+    char* inbuf = const_cast<char*>(from);
+    std::size_t iconv_result = ::iconv(cd, &inbuf, &from_left, &to, &to_left);
+    int saved_errno = errno;
+    from = inbuf;
+    BOOST_UNICODE_COUNT(iconv_calls, 1);
+    if (iconv_result != std::size_t(-1))
+      return std::codecvt_base::ok;
+    if (saved_errno == E2BIG || saved_errno == EINVAL)  // no room, or input ends within
+      return std::codecvt_base::partial;                //   a sequence
+    if (saved_errno == EILSEQ)
+      return std::codecvt_base::error;
+    throw std::system_error(saved_errno, std::system_category(), "iconv_codecvt");
+  }
+}  // namespace detail
+
+  template <class InternT>
+  class iconv_codecvt<InternT>::descriptor
+  {
+  public:
+    descriptor(const iconv_codecvt& ccvt, std::vector<iconv_t>& pool, bool in)
+      : ccvt_(ccvt), pool_(pool), cd_(iconv_t(-1))
+    {
+      {
+        std::lock_guard<std::mutex> lock(ccvt_.mutex_);
+        if (!pool_.empty())
+        {
+          cd_ = pool_.back();
+          pool_.pop_back();
+        }
+      }
+      if (cd_ == iconv_t(-1))
+        cd_ = in ? ccvt_.open(ccvt_.intern_name_, ccvt_.name_.c_str())
+          : ccvt_.open(ccvt_.name_.c_str(), ccvt_.intern_name_);
+      else
+        ::iconv(cd_, nullptr, nullptr, nullptr, nullptr);  // to the initial state
+    }
+    ~descriptor()
+    {
+      try
+      {
+        std::lock_guard<std::mutex> lock(ccvt_.mutex_);
+        pool_.push_back(cd_);
+      }
+      catch (...) { ::iconv_close(cd_); }  // the pool could not grow
+    }
+    descriptor(const descriptor&) = delete;
+    descriptor& operator=(const descriptor&) = delete;
+
+    iconv_t get() const noexcept { return cd_; }
+
+  private:
+    const iconv_codecvt&  ccvt_;
+    std::vector<iconv_t>& pool_;
+    iconv_t               cd_;
+  };
+
+  template <class InternT>
+  iconv_codecvt<InternT>::iconv_codecvt(const std::string& name, std::size_t refs)
+    : std::codecvt<InternT, char, std::mbstate_t>(refs), name_(name),
+      intern_name_(detail::iconv_intern_name<InternT>())
+  {
+    in_pool_.push_back(open(intern_name_, name_.c_str()));
+    try { out_pool_.push_back(open(name_.c_str(), intern_name_)); }
+    catch (...)
+    {
+      ::iconv_close(in_pool_.back());
+      throw;
+    }
+  }
+
+  template <class InternT>
+  iconv_codecvt<InternT>::~iconv_codecvt()
+  {
+    for (iconv_t cd : in_pool_)
+      ::iconv_close(cd);
+    for (iconv_t cd : out_pool_)
+      ::iconv_close(cd);
+  }
+
+  template <class InternT>
+  iconv_t iconv_codecvt<InternT>::open(const char* to_name, const char* from_name) const
+  {
+    iconv_t cd = ::iconv_open(to_name, from_name);
+    if (cd == iconv_t(-1))
+      throw std::system_error(errno, std::system_category(),
+        "iconv_codecvt: cannot convert from " + std::string(from_name) + " to "
+        + std::string(to_name));
+    return cd;
+  }
+
+  template <class InternT>
+  std::codecvt_base::result iconv_codecvt<InternT>::do_in(state_type&,
+    const char* from, const char* from_end, const char*& from_next,
+    InternT* to, InternT* to_end, InternT*& to_next) const
+  {
+    descriptor cd(*this, in_pool_, true);
+    std::size_t from_left = static_cast<std::size_t>(from_end - from);
+    char* out = reinterpret_cast<char*>(to);
+    std::size_t to_left = static_cast<std::size_t>(to_end - to) * sizeof(InternT);
+    result r = detail::iconv_call(cd.get(), from, from_left, out, to_left);
+    from_next = from;
+    to_next = reinterpret_cast<InternT*>(out);
+    return r;
+  }
+
+  template <class InternT>
+  std::codecvt_base::result iconv_codecvt<InternT>::do_out(state_type&,
+    const InternT* from, const InternT* from_end, const InternT*& from_next,
+    char* to, char* to_end, char*& to_next) const
+  {
+    //  the output must end in the initial shift state, so that the next call may start
+    //  there; if there is no room to return to it, convert again leaving an octet more
+    //  room, which only stateful encodings, given a full buffer, ever do
+    descriptor cd(*this, out_pool_, false);
+    const std::size_t room = static_cast<std::size_t>(to_end - to);
+    for (std::size_t reserve = 0; reserve <= room; ++reserve)
+    {
+      if (reserve != 0)
+        ::iconv(cd.get(), nullptr, nullptr, nullptr, nullptr);
+      const char* in = reinterpret_cast<const char*>(from);
+      std::size_t from_left
+        = static_cast<std::size_t>(from_end - from) * sizeof(InternT);
+      char* out = to;
+      std::size_t to_left = room - reserve;
+      result r = detail::iconv_call(cd.get(), in, from_left, out, to_left);
+      if (in == reinterpret_cast<const char*>(from))
+      {
+        //  nothing converted; drop any escape sequence written ahead of it
+        from_next = from;
+        to_next = to;
+        return r;
+      }
+      to_left += reserve;
+      if (::iconv(cd.get(), nullptr, nullptr, &out, &to_left) != std::size_t(-1))
+      {
+        from_next = reinterpret_cast<const InternT*>(in);
+        to_next = out;
+        return r;
+      }
+    }
+    from_next = from;
+    to_next = to;
+    return std::codecvt_base::partial;
+  }
+
+  template <class InternT>
+  int iconv_codecvt<InternT>::do_length(state_type&, const char* from,
+    const char* from_end, std::size_t max) const
+  {
+    //  convert into a scratch buffer, offering no more room than max code units
+    descriptor cd(*this, in_pool_, true);
+    const char* first = from;
+    std::size_t from_left = static_cast<std::size_t>(from_end - from);
+    InternT buf[BOOST_UNICODE_BUFFER_SIZE / sizeof(InternT)];
+    while (max != 0 && from_left != 0)
+    {
+      std::size_t room = max < sizeof(buf) / sizeof(InternT)
+        ? max : sizeof(buf) / sizeof(InternT);
+      char* out = reinterpret_cast<char*>(buf);
+      std::size_t to_left = room * sizeof(InternT);
+      const char* before = from;
+      result r = detail::iconv_call(cd.get(), from, from_left, out, to_left);
+      max -= static_cast<std::size_t>(reinterpret_cast<InternT*>(out) - buf);
+      if (r == std::codecvt_base::error || (r == std::codecvt_base::partial
+        && from == before))
+        break;  // ill-formed, or the input ends within a sequence, or no more room
+    }
+    return static_cast<int>(from - first);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_ICONV_CODECVT_HPP
@@ -0,0 +1,389 @@
+﻿//  boost/unicode/inline_string.hpp  ---------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  inline_basic_string<CharT, N> holds up to N code units within itself, and spills    //
+//  to the heap only beyond that, so that a short conversion result is never            //
+//  allocated. std::basic_string does the same, but for a small buffer of its           //
+//  implementation's choosing: 15 chars but only 3 char32_t in libstdc++.               //
+//                                                                                      //
+//  to_inline_string<ToEncoding, N>(v) is to_string() with such a result:               //
+//                                                                                      //
+//    inline_u32string<24> s = to_inline_string<utf32, 24>(u8"short");  // no new       //
+//                                                                                      //
+//  Neither it nor to_string() grows its result a code unit at a time. Output that      //
+//  fits the capacity the result already has, even expanded as much as it could be,     //
+//  is written to the result directly; other output of short input is written to a      //
+//  buffer on the stack first, so that a result that does spill is allocated once, at   //
+//  its exact size.                                                                     //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_INLINE_STRING_HPP)
+#define BOOST_UNICODE_INLINE_STRING_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/assert.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <type_traits>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  template <class CharT, std::size_t N, class Traits = std::char_traits<CharT>>
+  class inline_basic_string
+  {
+  public:
+    using value_type = CharT;
+    using traits_type = Traits;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = CharT&;
+    using const_reference = const CharT&;
+    using pointer = CharT*;
+    using const_pointer = const CharT*;
+    using iterator = CharT*;
+    using const_iterator = const CharT*;
+    using view_type = boost::basic_string_view<CharT, Traits>;
+
+    static constexpr size_type inline_capacity = N;
+
+    inline_basic_string() noexcept;
+    explicit inline_basic_string(view_type v);
+    inline_basic_string(const inline_basic_string& other);
+    inline_basic_string(inline_basic_string&& other) noexcept;
+    inline_basic_string& operator=(const inline_basic_string& other);
+    inline_basic_string& operator=(inline_basic_string&& other) noexcept;
+    ~inline_basic_string();
+
+    const CharT* data() const noexcept  { return data_; }
+    CharT*       data() noexcept        { return data_; }
+    const CharT* c_str() const noexcept { return data_; }
+    size_type    size() const noexcept  { return size_; }
+    size_type    length() const noexcept { return size_; }
+    size_type    capacity() const noexcept { return capacity_; }
+    bool         empty() const noexcept { return size_ == 0; }
+
+    //  true if the code units are held within *this, not on the heap
+    bool         is_inline() const noexcept { return data_ == buf_; }
+
+    iterator       begin() noexcept        { return data_; }
+    iterator       end() noexcept          { return data_ + size_; }
+    const_iterator begin() const noexcept  { return data_; }
+    const_iterator end() const noexcept    { return data_ + size_; }
+    const_iterator cbegin() const noexcept { return data_; }
+    const_iterator cend() const noexcept   { return data_ + size_; }
+
+    //  Requires: i <= size(); the code unit at size() is CharT()
+    reference       operator[](size_type i) noexcept;
+    const_reference operator[](size_type i) const noexcept;
+
+    view_type view() const noexcept { return view_type(data_, size_); }
+    operator view_type() const noexcept { return view(); }
+    std::basic_string<CharT, Traits> str() const
+      { return std::basic_string<CharT, Traits>(data_, size_); }
+
+    void reserve(size_type n);
+    void resize(size_type n);  // code units added are CharT()
+    void clear() noexcept;
+    void push_back(CharT c);
+    inline_basic_string& append(const CharT* p, size_type n);
+
+  private:  // exposition only
+    void grow(size_type n);   // capacity() becomes at least n
+    void release() noexcept;  // the heap storage, if any
+
+    CharT*    data_;
+    size_type size_;
+    size_type capacity_;
+    CharT     buf_[N + 1];
+  };
+
+  template <std::size_t N> using inline_string = inline_basic_string<char, N>;
+  template <std::size_t N> using inline_u16string = inline_basic_string<char16_t, N>;
+  template <std::size_t N> using inline_u32string = inline_basic_string<char32_t, N>;
+  template <std::size_t N> using inline_wstring = inline_basic_string<wchar_t, N>;
+
+  template <class CharT, std::size_t N, class Traits>
+  bool operator==(const inline_basic_string<CharT, N, Traits>& x,
+    const inline_basic_string<CharT, N, Traits>& y) noexcept;
+  template <class CharT, std::size_t N, class Traits>
+  bool operator!=(const inline_basic_string<CharT, N, Traits>& x,
+    const inline_basic_string<CharT, N, Traits>& y) noexcept;
+
+  template <class CharT, std::size_t N, class Traits>
+  std::basic_ostream<CharT, Traits>& operator<<(std::basic_ostream<CharT, Traits>& os,
+    const inline_basic_string<CharT, N, Traits>& s);
+
+  //  [uni.to_inline_string] as to_string(), but for a UTF ToEncoding, and without
+  //  ccvt_type arguments; a string_view is UTF-8
+  template <class ToEncoding, std::size_t N, class ...Pack>
+    inline_basic_string<typename ToEncoding::value_type, N>
+      to_inline_string(boost::string_view v, const Pack& ... args);
+  template <class ToEncoding, std::size_t N, class ...Pack>
+    inline_basic_string<typename ToEncoding::value_type, N>
+      to_inline_string(boost::u16string_view v, const Pack& ... args);
+  template <class ToEncoding, std::size_t N, class ...Pack>
+    inline_basic_string<typename ToEncoding::value_type, N>
+      to_inline_string(boost::u32string_view v, const Pack& ... args);
+  template <class ToEncoding, std::size_t N, class ...Pack>
+    inline_basic_string<typename ToEncoding::value_type, N>
+      to_inline_string(boost::wstring_view v, const Pack& ... args);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  template <class CharT, std::size_t N, class Traits>
+  constexpr std::size_t inline_basic_string<CharT, N, Traits>::inline_capacity;
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>::inline_basic_string() noexcept
+    : data_(buf_), size_(0), capacity_(N)
+  {
+    buf_[0] = CharT();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>::inline_basic_string(view_type v)
+    : inline_basic_string()
+  {
+    append(v.data(), v.size());
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>::inline_basic_string(
+    const inline_basic_string& other) : inline_basic_string()
+  {
+    append(other.data_, other.size_);
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>::inline_basic_string(
+    inline_basic_string&& other) noexcept : inline_basic_string()
+  {
+    *this = std::move(other);
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>&
+    inline_basic_string<CharT, N, Traits>::operator=(const inline_basic_string& other)
+  {
+    if (this != &other)
+    {
+      clear();
+      append(other.data_, other.size_);
+    }
+    return *this;
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>&
+    inline_basic_string<CharT, N, Traits>::operator=(inline_basic_string&& other)
+      noexcept
+  {
+    if (this == &other)
+      return *this;
+    release();
+    if (other.is_inline())
+    {
+      Traits::copy(buf_, other.buf_, other.size_ + 1);
+      size_ = other.size_;
+    }
+    else  // take the heap storage, leaving other empty
+    {
+      data_ = other.data_;
+      size_ = other.size_;
+      capacity_ = other.capacity_;
+      other.data_ = other.buf_;
+      other.capacity_ = N;
+    }
+    other.size_ = 0;
+    other.buf_[0] = CharT();
+    return *this;
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>::~inline_basic_string()
+  {
+    release();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline typename inline_basic_string<CharT, N, Traits>::reference
+    inline_basic_string<CharT, N, Traits>::operator[](size_type i) noexcept
+  {
+    BOOST_ASSERT(i <= size_);
+    return data_[i];
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline typename inline_basic_string<CharT, N, Traits>::const_reference
+    inline_basic_string<CharT, N, Traits>::operator[](size_type i) const noexcept
+  {
+    BOOST_ASSERT(i <= size_);
+    return data_[i];
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline void inline_basic_string<CharT, N, Traits>::reserve(size_type n)
+  {
+    if (n > capacity_)
+      grow(n);
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline void inline_basic_string<CharT, N, Traits>::resize(size_type n)
+  {
+    if (n > size_)
+    {
+      reserve(n);
+      Traits::assign(data_ + size_, n - size_, CharT());
+    }
+    size_ = n;
+    data_[n] = CharT();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline void inline_basic_string<CharT, N, Traits>::clear() noexcept
+  {
+    size_ = 0;
+    data_[0] = CharT();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline void inline_basic_string<CharT, N, Traits>::push_back(CharT c)
+  {
+    if (size_ == capacity_)
+      grow(size_ + 1);
+    data_[size_++] = c;
+    data_[size_] = CharT();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline inline_basic_string<CharT, N, Traits>&
+    inline_basic_string<CharT, N, Traits>::append(const CharT* p, size_type n)
+  {
+    if (n > capacity_ - size_)
+      grow(size_ + n);
+    Traits::copy(data_ + size_, p, n);
+    size_ += n;
+    data_[size_] = CharT();
+    return *this;
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  void inline_basic_string<CharT, N, Traits>::grow(size_type n)
+  {
+    //  at least double, so that push_back() is amortized constant time
+    const size_type cap = std::max(n, 2 * capacity_);
+    CharT* p = new CharT[cap + 1];
+    Traits::copy(p, data_, size_ + 1);
+    release();
+    data_ = p;
+    capacity_ = cap;
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline void inline_basic_string<CharT, N, Traits>::release() noexcept
+  {
+    if (!is_inline())
+      delete[] data_;
+    data_ = buf_;
+    capacity_ = N;
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline bool operator==(const inline_basic_string<CharT, N, Traits>& x,
+    const inline_basic_string<CharT, N, Traits>& y) noexcept
+  {
+    return x.view() == y.view();
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline bool operator!=(const inline_basic_string<CharT, N, Traits>& x,
+    const inline_basic_string<CharT, N, Traits>& y) noexcept
+  {
+    return !(x == y);
+  }
+
+  template <class CharT, std::size_t N, class Traits>
+  inline std::basic_ostream<CharT, Traits>& operator<<(
+    std::basic_ostream<CharT, Traits>& os, const inline_basic_string<CharT, N, Traits>& s)
+  {
+    return os << s.view();
+  }
+
+  // to_inline_string implementation ---------------------------------------------------//
+
+  namespace detail
+  {
+    template <class FromEncoding, class ToEncoding, std::size_t N, class View,
+      class ... Pack>
+    inline inline_basic_string<typename ToEncoding::value_type, N>
+      convert_to_inline_string(View v, const Pack& ... args)
+    {
+      static_assert(std::is_same<ToEncoding, utf8>::value
+        || std::is_same<ToEncoding, utf16>::value
+        || std::is_same<ToEncoding, utf32>::value
+        || std::is_same<ToEncoding, wide>::value,
+        "ToEncoding must be utf8, utf16, utf32, or wide");
+      static_assert(detail::ccvt_count<Pack...>() == 0,
+        "A ccvt_type argument is not allowed");
+      return convert_to_string<FromEncoding, ToEncoding,
+        inline_basic_string<typename ToEncoding::value_type, N>>(v, args ...);
+    }
+  }
+
+  template <class ToEncoding, std::size_t N, class ...Pack>
+  inline inline_basic_string<typename ToEncoding::value_type, N>
+    to_inline_string(boost::string_view v, const Pack& ... args)
+  {
+    return detail::convert_to_inline_string<utf8, ToEncoding, N>(v, args ...);
+  }
+
+  template <class ToEncoding, std::size_t N, class ...Pack>
+  inline inline_basic_string<typename ToEncoding::value_type, N>
+    to_inline_string(boost::u16string_view v, const Pack& ... args)
+  {
+    return detail::convert_to_inline_string<utf16, ToEncoding, N>(v, args ...);
+  }
+
+  template <class ToEncoding, std::size_t N, class ...Pack>
+  inline inline_basic_string<typename ToEncoding::value_type, N>
+    to_inline_string(boost::u32string_view v, const Pack& ... args)
+  {
+    return detail::convert_to_inline_string<utf32, ToEncoding, N>(v, args ...);
+  }
+
+  template <class ToEncoding, std::size_t N, class ...Pack>
+  inline inline_basic_string<typename ToEncoding::value_type, N>
+    to_inline_string(boost::wstring_view v, const Pack& ... args)
+  {
+    return detail::convert_to_inline_string<wide, ToEncoding, N>(v, args ...);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_INLINE_STRING_HPP
@@ -0,0 +1,237 @@
+﻿//  boost/unicode/instrumentation.hpp  -------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Optional counters for the conversion hot paths. To enable them, define              //
+//  BOOST_UNICODE_INSTRUMENTATION before including any boost/unicode header, and do so  //
+//  consistently across the program. Otherwise the hooks expand to nothing and          //
+//  snapshot_counters() returns zeros, so code that reads the counters compiles either  //
+//  way.                                                                                //
+//                                                                                      //
+//  Each thread increments its own cache-line aligned block without atomic              //
+//  read-modify-write operations. snapshot_counters() sums the blocks of all live       //
+//  threads plus the totals left behind by threads that have exited.                    //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_INSTRUMENTATION_HPP)
+#define BOOST_UNICODE_INSTRUMENTATION_HPP
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <boost/config.hpp>
+#include <boost/unicode/detail/constant_evaluation.hpp>
+
+#if defined(BOOST_UNICODE_INSTRUMENTATION)
+# include <atomic>
+# include <mutex>
+#endif
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  enum class counter
+  {
+    bytes_in,          // code units consumed, in bytes, by each conversion stage
+    bytes_out,         // code units produced, in bytes, by each conversion stage
+    code_points,       // well-formed code points produced by UTF conversions
+
+    //  ill-formed sequences found while decoding, by category
+    truncated,         // lead octet or high surrogate missing its continuation
+    overlong,          // UTF-8 sequence longer than the code point requires
+    surrogate,         // encoded or unpaired surrogate
+    out_of_range,      // code point above U+10FFFF
+    invalid,           // octet that cannot begin a sequence, or a codecvt or iconv
+                       //   error whose kind is unknown
+
+    fast_path_blocks,  // blocks handled whole by a word- or vector-at-a-time loop:
+                       //   eight UTF-8 octets, or sixteen UTF-32 code units
+    slow_path_blocks,  // blocks such a loop handed to code-unit-at-a-time code
+
+    codecvt_calls,     // calls to codecvt in() or out()
+    iconv_calls,       // calls to iconv()
+  };
+
+  constexpr std::size_t counter_count
+    = static_cast<std::size_t>(counter::iconv_calls) + 1;
+
+  const char* counter_name(counter c) BOOST_NOEXCEPT;
+
+  struct counters_snapshot
+  {
+    std::array<std::uint64_t, counter_count> values;
+
+    std::uint64_t operator[](counter c) const BOOST_NOEXCEPT
+      { return values[static_cast<std::size_t>(c)]; }
+    std::uint64_t errors() const BOOST_NOEXCEPT;  // sum of the ill-formed categories
+  };
+
+  constexpr bool instrumentation_enabled() BOOST_NOEXCEPT
+  {
+#  if defined(BOOST_UNICODE_INSTRUMENTATION)
+    return true;
+#  else
+    return false;
+#  endif
+  }
+
+  //  returns: totals over all threads since program start or reset_counters()
+  counters_snapshot snapshot_counters();
+
+  //  Effects: sets all totals to zero. Increments racing with the reset may be lost.
+  void reset_counters();
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+
+//  Nothing is counted during constant evaluation, so the hooks may appear in constexpr
+//  functions.
+#if defined(BOOST_UNICODE_INSTRUMENTATION)
+# define BOOST_UNICODE_COUNT(name, n) \
+    (::boost::unicode::detail::in_constant_evaluation() ? (void)0 \
+      : ::boost::unicode::detail::count(::boost::unicode::counter::name, (n)))
+#else
+# define BOOST_UNICODE_COUNT(name, n) ((void)sizeof(n))
+#endif
+
+namespace boost
+{
+namespace unicode
+{
+  inline const char* counter_name(counter c) BOOST_NOEXCEPT
+  {
+    static const char* const names[counter_count] = { "bytes_in", "bytes_out",
+      "code_points", "truncated", "overlong", "surrogate", "out_of_range", "invalid",
+      "fast_path_blocks", "slow_path_blocks", "codecvt_calls", "iconv_calls" };
+    return names[static_cast<std::size_t>(c)];
+  }
+
+  inline std::uint64_t counters_snapshot::errors() const BOOST_NOEXCEPT
+  {
+    return (*this)[counter::truncated] + (*this)[counter::overlong]
+      + (*this)[counter::surrogate] + (*this)[counter::out_of_range]
+      + (*this)[counter::invalid];
+  }
+
+#if !defined(BOOST_UNICODE_INSTRUMENTATION)
+
+  inline counters_snapshot snapshot_counters()
+  {
+    counters_snapshot s;
+    s.values.fill(0);
+    return s;
+  }
+
+  inline void reset_counters() {}
+
+#else
+
+namespace detail
+{
+  constexpr std::size_t cache_line_size = 64;
+
+  //  One per thread, linked into a list so that registration never allocates. Only the
+  //  owning thread writes the values, so relaxed loads and stores suffice; the atomics
+  //  exist only so that snapshot_counters() may read them concurrently.
+  struct alignas(cache_line_size) thread_counters
+  {
+    std::array<std::atomic<std::uint64_t>, counter_count> values;
+    thread_counters* prev;
+    thread_counters* next;
+
+    thread_counters();
+    ~thread_counters();
+  };
+
+  struct counters_registry
+  {
+    std::mutex                                mutex;
+    thread_counters*                          head = nullptr;
+    std::array<std::uint64_t, counter_count>  retired = {};  // from exited threads
+  };
+
+  inline counters_registry& registry() BOOST_NOEXCEPT
+  {
+    static counters_registry r;
+    return r;
+  }
+
+  inline thread_counters::thread_counters() : prev(nullptr)
+  {
+    for (auto& v : values)
+      v.store(0, std::memory_order_relaxed);
+    counters_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    next = r.head;
+    if (next)
+      next->prev = this;
+    r.head = this;
+  }
+
+  inline thread_counters::~thread_counters()
+  {
+    counters_registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    for (std::size_t i = 0; i < counter_count; ++i)
+      r.retired[i] += values[i].load(std::memory_order_relaxed);
+    (prev ? prev->next : r.head) = next;
+    if (next)
+      next->prev = prev;
+  }
+
+  inline thread_counters& this_thread_counters()
+  {
+    static thread_local thread_counters tc;
+    return tc;
+  }
+
+  inline void count(counter c, std::uint64_t n) BOOST_NOEXCEPT
+  {
+    std::atomic<std::uint64_t>& v
+      = this_thread_counters().values[static_cast<std::size_t>(c)];
+    v.store(v.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+}  // namespace detail
+
+  inline counters_snapshot snapshot_counters()
+  {
+    detail::counters_registry& r = detail::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    counters_snapshot s;
+    s.values = r.retired;
+    for (detail::thread_counters* tc = r.head; tc; tc = tc->next)
+      for (std::size_t i = 0; i < counter_count; ++i)
+        s.values[i] += tc->values[i].load(std::memory_order_relaxed);
+    return s;
+  }
+
+  inline void reset_counters()
+  {
+    detail::counters_registry& r = detail::registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    r.retired.fill(0);
+    for (detail::thread_counters* tc = r.head; tc; tc = tc->next)
+      for (auto& v : tc->values)
+        v.store(0, std::memory_order_relaxed);
+  }
+
+#endif  // BOOST_UNICODE_INSTRUMENTATION
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_INSTRUMENTATION_HPP
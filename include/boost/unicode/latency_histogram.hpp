@@ -0,0 +1,292 @@
+﻿//  boost/unicode/latency_histogram.hpp  -----------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  A conversion_observer that keeps a latency histogram for each kind of conversion    //
+//  and input size, so that tail latencies of large conversions are not hidden by the   //
+//  many small ones. Recording is lock-free and may happen on any number of threads.    //
+//                                                                                      //
+//  latency_histogram buckets are log-linear, as in HdrHistogram: values below 32 are   //
+//  exact, and above that each power of two is divided into 16 buckets, so a reported   //
+//  percentile is at most 1/16 above the true value.                                    //
+//                                                                                      //
+//  Usage:                                                                              //
+//                                                                                      //
+//    static latency_histogram_sink sink;                                               //
+//    set_conversion_observer(&sink);                                                   //
+//    ...                                                                               //
+//    sink.write_text(std::cout);                                                       //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_LATENCY_HISTOGRAM_HPP)
+#define BOOST_UNICODE_LATENCY_HISTOGRAM_HPP
+
+#include <boost/unicode/trace.hpp>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  class latency_histogram
+  {
+  public:
+    static constexpr unsigned    sub_bucket_bits = 4;
+    static constexpr std::size_t bucket_count
+      = (64 - sub_bucket_bits + 1) << sub_bucket_bits;
+
+    latency_histogram() BOOST_NOEXCEPT;
+    latency_histogram(const latency_histogram&) = delete;
+    latency_histogram& operator=(const latency_histogram&) = delete;
+
+    void record(std::uint64_t value) BOOST_NOEXCEPT;
+    void reset() BOOST_NOEXCEPT;
+
+    std::uint64_t count() const BOOST_NOEXCEPT;
+    std::uint64_t max() const BOOST_NOEXCEPT;
+    double        mean() const BOOST_NOEXCEPT;
+
+    //  returns: the highest value in the bucket holding the given percentile, in the
+    //  range [0, 100], but no more than max(); 0 if count() == 0
+    std::uint64_t percentile(double p) const BOOST_NOEXCEPT;
+
+    static std::size_t   bucket_index(std::uint64_t value) BOOST_NOEXCEPT;
+    static std::uint64_t bucket_highest(std::size_t index) BOOST_NOEXCEPT;
+
+  private:  // exposition only
+    std::array<std::atomic<std::uint64_t>, bucket_count> buckets_;
+    std::atomic<std::uint64_t> count_;
+    std::atomic<std::uint64_t> total_;
+    std::atomic<std::uint64_t> max_;
+  };
+
+  class latency_histogram_sink : public conversion_observer
+  {
+  public:
+    //  input sizes are bucketed by powers of 16 bytes: <64B, <1KiB, ..., and unknown
+    static constexpr std::size_t size_bucket_count = 7;
+    static std::size_t size_bucket(std::size_t input_bytes) BOOST_NOEXCEPT;
+    static const char* size_bucket_name(std::size_t bucket) BOOST_NOEXCEPT;
+
+    void conversion_end(const conversion_event& event,
+      std::chrono::nanoseconds duration) BOOST_NOEXCEPT override;
+
+    //  latencies, in nanoseconds
+    const latency_histogram& histogram(conversion operation,
+      std::size_t size_bucket) const BOOST_NOEXCEPT;
+
+    void reset() BOOST_NOEXCEPT;
+
+    //  one line or object per non-empty histogram; times in nanoseconds
+    void write_text(std::ostream& os) const;
+    void write_json(std::ostream& os) const;
+
+  private:  // exposition only
+    latency_histogram histograms_[conversion_count][size_bucket_count];
+  };
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  //  latency_histogram  ---------------------------------------------------------------//
+
+  inline latency_histogram::latency_histogram() BOOST_NOEXCEPT
+  {
+    reset();
+  }
+
+  inline std::size_t latency_histogram::bucket_index(std::uint64_t value) BOOST_NOEXCEPT
+  {
+    constexpr std::uint64_t linear = std::uint64_t(2) << sub_bucket_bits;
+    if (value < linear)
+      return static_cast<std::size_t>(value);
+    unsigned magnitude = 63;  // position of the highest set bit
+    for (; !(value >> magnitude); --magnitude) {}
+    unsigned shift = magnitude - sub_bucket_bits;
+    std::uint64_t top = value >> shift;  // the highest sub_bucket_bits + 1 bits
+    return ((magnitude - sub_bucket_bits + 1) << sub_bucket_bits)
+      + static_cast<std::size_t>(top - (std::uint64_t(1) << sub_bucket_bits));
+  }
+
+  inline std::uint64_t latency_histogram::bucket_highest(std::size_t index) BOOST_NOEXCEPT
+  {
+    constexpr std::size_t linear = std::size_t(2) << sub_bucket_bits;
+    if (index < linear)
+      return index;
+    unsigned shift = static_cast<unsigned>(index >> sub_bucket_bits) - 1;
+    std::uint64_t top = (std::uint64_t(1) << sub_bucket_bits)
+      + (index & ((std::size_t(1) << sub_bucket_bits) - 1));
+    return ((top + 1) << shift) - 1;
+  }
+
+  inline void latency_histogram::record(std::uint64_t value) BOOST_NOEXCEPT
+  {
+    buckets_[bucket_index(value)].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(value, std::memory_order_relaxed);
+    std::uint64_t prior = max_.load(std::memory_order_relaxed);
+    while (value > prior
+      && !max_.compare_exchange_weak(prior, value, std::memory_order_relaxed)) {}
+  }
+
+  inline void latency_histogram::reset() BOOST_NOEXCEPT
+  {
+    for (auto& b : buckets_)
+      b.store(0, std::memory_order_relaxed);
+    count_.store(0, std::memory_order_relaxed);
+    total_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+  }
+
+  inline std::uint64_t latency_histogram::count() const BOOST_NOEXCEPT
+  {
+    return count_.load(std::memory_order_relaxed);
+  }
+
+  inline std::uint64_t latency_histogram::max() const BOOST_NOEXCEPT
+  {
+    return max_.load(std::memory_order_relaxed);
+  }
+
+  inline double latency_histogram::mean() const BOOST_NOEXCEPT
+  {
+    std::uint64_t n = count();
+    return n ? static_cast<double>(total_.load(std::memory_order_relaxed)) / n : 0.0;
+  }
+
+  inline std::uint64_t latency_histogram::percentile(double p) const BOOST_NOEXCEPT
+  {
+    //  count_ may run ahead of the buckets while recording is in progress, so the
+    //  buckets are summed rather than trusting it
+    std::uint64_t n = 0;
+    for (auto& b : buckets_)
+      n += b.load(std::memory_order_relaxed);
+    if (n == 0)
+      return 0;
+    std::uint64_t rank = static_cast<std::uint64_t>(p / 100.0 * n + 0.5);
+    if (rank == 0)
+      rank = 1;
+    std::uint64_t seen = 0;
+    std::size_t i = 0;
+    for (; i < bucket_count - 1; ++i)
+    {
+      seen += buckets_[i].load(std::memory_order_relaxed);
+      if (seen >= rank)
+        break;
+    }
+    std::uint64_t highest = bucket_highest(i);
+    return highest < max() ? highest : max();
+  }
+
+  //  latency_histogram_sink  ----------------------------------------------------------//
+
+  inline std::size_t latency_histogram_sink::size_bucket(std::size_t input_bytes)
+    BOOST_NOEXCEPT
+  {
+    if (input_bytes == unknown_size)
+      return size_bucket_count - 1;
+    std::size_t bucket = 0;
+    for (std::size_t limit = 64; bucket < size_bucket_count - 2 && input_bytes >= limit;
+      limit *= 16)
+      ++bucket;
+    return bucket;
+  }
+
+  inline const char* latency_histogram_sink::size_bucket_name(std::size_t bucket)
+    BOOST_NOEXCEPT
+  {
+    static const char* const names[size_bucket_count]
+      = { "<64B", "<1KiB", "<16KiB", "<256KiB", "<4MiB", ">=4MiB", "unknown" };
+    return names[bucket];
+  }
+
+  inline void latency_histogram_sink::conversion_end(const conversion_event& event,
+    std::chrono::nanoseconds duration) BOOST_NOEXCEPT
+  {
+    histograms_[static_cast<std::size_t>(event.operation)]
+      [size_bucket(event.input_bytes)].record(
+        static_cast<std::uint64_t>(duration.count()));
+  }
+
+  inline const latency_histogram& latency_histogram_sink::histogram(
+    conversion operation, std::size_t size_bucket) const BOOST_NOEXCEPT
+  {
+    return histograms_[static_cast<std::size_t>(operation)][size_bucket];
+  }
+
+  inline void latency_histogram_sink::reset() BOOST_NOEXCEPT
+  {
+    for (auto& row : histograms_)
+      for (auto& h : row)
+        h.reset();
+  }
+
+  inline void latency_histogram_sink::write_text(std::ostream& os) const
+  {
+    for (std::size_t op = 0; op < conversion_count; ++op)
+      for (std::size_t size = 0; size < size_bucket_count; ++size)
+      {
+        const latency_histogram& h = histograms_[op][size];
+        if (h.count() == 0)
+          continue;
+        os << conversion_name(static_cast<conversion>(op)) << ' '
+           << size_bucket_name(size)
+           << " count=" << h.count()
+           << " mean=" << static_cast<std::uint64_t>(h.mean())
+           << " p50=" << h.percentile(50)
+           << " p90=" << h.percentile(90)
+           << " p99=" << h.percentile(99)
+           << " p99.9=" << h.percentile(99.9)
+           << " max=" << h.max() << '\n';
+      }
+  }
+
+  inline void latency_histogram_sink::write_json(std::ostream& os) const
+  {
+    os << "{\"unit\":\"ns\",\"histograms\":[";
+    const char* separator = "";
+    for (std::size_t op = 0; op < conversion_count; ++op)
+      for (std::size_t size = 0; size < size_bucket_count; ++size)
+      {
+        const latency_histogram& h = histograms_[op][size];
+        if (h.count() == 0)
+          continue;
+        os << separator
+           << "{\"operation\":\"" << conversion_name(static_cast<conversion>(op))
+           << "\",\"input_size\":\"" << size_bucket_name(size)
+           << "\",\"count\":" << h.count()
+           << ",\"mean\":" << static_cast<std::uint64_t>(h.mean())
+           << ",\"p50\":" << h.percentile(50)
+           << ",\"p90\":" << h.percentile(90)
+           << ",\"p99\":" << h.percentile(99)
+           << ",\"p99.9\":" << h.percentile(99.9)
+           << ",\"max\":" << h.max() << '}';
+        separator = ",";
+      }
+    os << "]}\n";
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_LATENCY_HISTOGRAM_HPP
@@ -0,0 +1,221 @@
+﻿//  boost/unicode/literal.hpp  ---------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Compile-time transcoding of string literals, for APIs that want a particular UTF    //
+//  without paying for the conversion at run time:                                      //
+//                                                                                      //
+//    constexpr auto name = transcode_literal<utf16>(u8"Grüße");                        //
+//    static_assert(is_well_formed(u8"Grüße"), "ill-formed literal");                   //
+//                                                                                      //
+//  The array holds the transcoded literal, including its terminating null, followed    //
+//  by as many nulls as needed to fill a size computed from the length of the literal   //
+//  alone. BOOST_UNICODE_LITERAL gives an array of exactly the transcoded size instead. //
+//                                                                                      //
+//  Ill-formed sequences are replaced exactly as recode() would replace them. Constant  //
+//  evaluation requires C++17, where std::array becomes modifiable in constexpr code.   //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_LITERAL_HPP)
+#define BOOST_UNICODE_LITERAL_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  namespace detail
+  {
+    template <class CharT> struct literal_encoding;
+    template <class FromCharT, class ToEncoding>
+      constexpr std::size_t literal_capacity(std::size_t n) BOOST_NOEXCEPT;
+  }
+
+  //  returns: the number of code units, including the terminating null, that
+  //  transcode_literal<ToEncoding> produces for literal
+  template <class ToEncoding, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::size_t transcoded_size(const CharT (&literal)[N]);
+
+  //  returns: literal transcoded to ToEncoding, padded with nulls
+  template <class ToEncoding, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::array<typename ToEncoding::value_type,
+    detail::literal_capacity<CharT, ToEncoding>(N)>
+      transcode_literal(const CharT (&literal)[N]);
+
+  //  returns: literal transcoded to ToEncoding, padded with nulls
+  //  throws: std::length_error if Size < transcoded_size<ToEncoding>(literal), which is
+  //  a compile-time error in a constant expression
+  template <class ToEncoding, std::size_t Size, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::array<typename ToEncoding::value_type, Size>
+    transcode_literal(const CharT (&literal)[N]);
+
+}  // namespace unicode
+}  // namespace boost
+
+//  an array of exactly transcoded_size<ToEncoding>(literal) code units
+#define BOOST_UNICODE_LITERAL(ToEncoding, literal)                                      \
+  ::boost::unicode::transcode_literal<ToEncoding,                                       \
+    ::boost::unicode::transcoded_size<ToEncoding>(literal)>(literal)
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  template<> struct literal_encoding<char>     { using type = utf8; };
+#if defined(__cpp_char8_t)
+  template<> struct literal_encoding<char8_t>  { using type = utf8; };
+#endif
+  template<> struct literal_encoding<char16_t> { using type = utf16; };
+  template<> struct literal_encoding<char32_t> { using type = utf32; };
+  template<> struct literal_encoding<wchar_t>  { using type = wide; };
+
+  template <class Encoding> struct code_unit_octets
+    : std::integral_constant<std::size_t, sizeof(typename Encoding::value_type)> {};
+  template <> struct code_unit_octets<wide>
+    : code_unit_octets<BOOST_UNICODE_WIDE_UTF> {};
+
+  //  the most output code units that one input code unit, or an ill-formed sequence of
+  //  them, can produce; one octet or UTF-16 code unit may become a three octet U+FFFD
+  constexpr std::size_t literal_expansion(std::size_t from_octets, std::size_t to_octets)
+    BOOST_NOEXCEPT
+  {
+    return to_octets == 4 ? 1
+      : to_octets == 2 ? (from_octets == 4 ? 2 : 1)
+      : (from_octets == 4 ? 4 : 3);
+  }
+
+  template <class FromCharT, class ToEncoding>
+  constexpr std::size_t literal_capacity(std::size_t n) BOOST_NOEXCEPT
+  {
+    return n * literal_expansion(
+      code_unit_octets<typename literal_encoding<FromCharT>::type>::value,
+      code_unit_octets<ToEncoding>::value);
+  }
+
+  //  constexpr output iterators; std::back_insert_iterator is not constexpr until C++20
+
+  template <class CharT, std::size_t Size>
+  struct literal_buffer
+  {
+    std::array<CharT, Size> units{};
+    std::size_t             size = 0;
+  };
+
+  template <class CharT, std::size_t Size>
+  class literal_inserter
+  {
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    constexpr explicit literal_inserter(literal_buffer<CharT, Size>& buffer)
+      BOOST_NOEXCEPT : buffer_(&buffer) {}
+
+    template <class T>
+    BOOST_CXX14_CONSTEXPR literal_inserter& operator=(T unit)
+    {
+      if (buffer_->size == Size)
+        throw std::length_error("boost::unicode::transcode_literal: Size too small");
+      buffer_->units[buffer_->size++] = static_cast<CharT>(unit);
+      return *this;
+    }
+    BOOST_CXX14_CONSTEXPR literal_inserter& operator*() BOOST_NOEXCEPT  { return *this; }
+    BOOST_CXX14_CONSTEXPR literal_inserter& operator++() BOOST_NOEXCEPT { return *this; }
+    BOOST_CXX14_CONSTEXPR literal_inserter operator++(int) BOOST_NOEXCEPT
+      { return *this; }
+
+  private:
+    literal_buffer<CharT, Size>* buffer_;
+  };
+
+  class literal_counter
+  {
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+
+    constexpr explicit literal_counter(std::size_t& n) BOOST_NOEXCEPT : n_(&n) {}
+
+    template <class T>
+    BOOST_CXX14_CONSTEXPR literal_counter& operator=(T) BOOST_NOEXCEPT
+    {
+      ++*n_;
+      return *this;
+    }
+    BOOST_CXX14_CONSTEXPR literal_counter& operator*() BOOST_NOEXCEPT { return *this; }
+    BOOST_CXX14_CONSTEXPR literal_counter& operator++() BOOST_NOEXCEPT { return *this; }
+    BOOST_CXX14_CONSTEXPR literal_counter operator++(int) BOOST_NOEXCEPT { return *this; }
+
+  private:
+    std::size_t* n_;
+  };
+
+  template <class ToEncoding>
+  BOOST_CXX14_CONSTEXPR void check_literal_encoding() BOOST_NOEXCEPT
+  {
+    static_assert(is_known_encoding<ToEncoding>::value,
+      "ToEncoding must be utf8, utf16, utf32, or wide");
+  }
+}  // namespace detail
+
+  template <class ToEncoding, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::size_t transcoded_size(const CharT (&literal)[N])
+  {
+    detail::check_literal_encoding<ToEncoding>();
+    std::size_t n = 0;
+    detail::recode_untraced<typename detail::literal_encoding<CharT>::type, ToEncoding>(
+      literal, literal + N, detail::literal_counter(n));
+    return n;
+  }
+
+  template <class ToEncoding, std::size_t Size, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::array<typename ToEncoding::value_type, Size>
+    transcode_literal(const CharT (&literal)[N])
+  {
+    detail::check_literal_encoding<ToEncoding>();
+    detail::literal_buffer<typename ToEncoding::value_type, Size> buffer;
+    detail::recode_untraced<typename detail::literal_encoding<CharT>::type, ToEncoding>(
+      literal, literal + N, detail::literal_inserter<typename ToEncoding::value_type,
+        Size>(buffer));
+    return buffer.units;
+  }
+
+  template <class ToEncoding, class CharT, std::size_t N>
+  BOOST_CXX14_CONSTEXPR std::array<typename ToEncoding::value_type,
+    detail::literal_capacity<CharT, ToEncoding>(N)>
+      transcode_literal(const CharT (&literal)[N])
+  {
+    return transcode_literal<ToEncoding,
+      detail::literal_capacity<CharT, ToEncoding>(N)>(literal);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_LITERAL_HPP
@@ -0,0 +1,186 @@
+﻿//  boost/unicode/offset_index.hpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  offset_index translates offsets within a UTF-8 sequence between UTF-8 code units,   //
+//  UTF-16 code units, and code points without rescanning from the start of the         //
+//  sequence. Checkpoints are sampled every interval() code points, so a translation    //
+//  costs one lookup (O(1) for code points, O(log n) otherwise) plus a scan of at most  //
+//  interval() code points.                                                             //
+//                                                                                      //
+//  Ill-formed sequences count as one code point and one UTF-16 code unit, the U+FFFD   //
+//  they become when recoded. An offset that falls inside a sequence is moved back to   //
+//  the start of that sequence. An offset past the end is moved back to the end.        //
+//                                                                                      //
+//  The index refers to, but does not own, the indexed sequence.                        //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_OFFSET_INDEX_HPP)
+#define BOOST_UNICODE_OFFSET_INDEX_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/assert.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  class offset_index
+  {
+  public:
+    struct position
+    {
+      std::size_t utf8;        // offset in UTF-8 code units
+      std::size_t utf16;       // offset in UTF-16 code units
+      std::size_t code_point;  // offset in code points
+    };
+
+    explicit offset_index(boost::string_view v, std::size_t interval = 64);
+
+    boost::string_view  view() const noexcept;
+    std::size_t         interval() const noexcept;
+    position            end() const noexcept;
+
+    //  the position of the code point containing the given offset
+    position from_utf8(std::size_t offset) const noexcept;
+    position from_utf16(std::size_t offset) const noexcept;
+    position from_code_point(std::size_t offset) const noexcept;
+
+    //  convenience conversions
+    std::size_t utf8_to_utf16(std::size_t offset) const noexcept
+      { return from_utf8(offset).utf16; }
+    std::size_t utf16_to_utf8(std::size_t offset) const noexcept
+      { return from_utf16(offset).utf8; }
+    std::size_t utf8_to_code_point(std::size_t offset) const noexcept
+      { return from_utf8(offset).code_point; }
+    std::size_t code_point_to_utf8(std::size_t offset) const noexcept
+      { return from_code_point(offset).utf8; }
+    std::size_t utf16_to_code_point(std::size_t offset) const noexcept
+      { return from_utf16(offset).code_point; }
+    std::size_t code_point_to_utf16(std::size_t offset) const noexcept
+      { return from_code_point(offset).utf16; }
+
+  private:  // exposition only
+
+    boost::string_view     v_;            // the indexed sequence
+    std::size_t            interval_;     // code points between checkpoints
+    std::vector<position>  checkpoints_;  // checkpoints_[i].code_point == i * interval_
+    position               end_;          // position one past the last code point
+
+    //  advance p by one code point
+    void next(position& p) const noexcept;
+
+    //  scan forward from checkpoint while the next code point starts at or before
+    //  offset, as measured by member M
+    template <std::size_t position::*M>
+    position scan(position p, std::size_t offset) const noexcept;
+
+    template <std::size_t position::*M>
+    position find(std::size_t offset) const noexcept;
+  };
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  inline offset_index::offset_index(boost::string_view v, std::size_t interval)
+    : v_(v), interval_(interval ? interval : 1), end_()
+  {
+    checkpoints_.reserve(v.size() / interval_ + 1);
+    position p = position();
+    while (p.utf8 != v_.size())
+    {
+      if (p.code_point % interval_ == 0)
+        checkpoints_.push_back(p);
+      next(p);
+    }
+    if (checkpoints_.empty())
+      checkpoints_.push_back(p);
+    end_ = p;
+  }
+
+  inline boost::string_view offset_index::view() const noexcept { return v_; }
+  inline std::size_t offset_index::interval() const noexcept { return interval_; }
+  inline offset_index::position offset_index::end() const noexcept { return end_; }
+
+  inline void offset_index::next(position& p) const noexcept
+  {
+    BOOST_ASSERT(p.utf8 < v_.size());
+    const char* first = v_.data() + p.utf8;
+    char32_t u32;
+    bool well_formed = detail::utf8_decode(first, v_.data() + v_.size(), u32);
+    p.utf8 = static_cast<std::size_t>(first - v_.data());
+    p.utf16 += (well_formed && u32 > 0xFFFFu) ? 2 : 1;
+    ++p.code_point;
+  }
+
+  template <std::size_t offset_index::position::*M>
+  inline offset_index::position
+    offset_index::scan(position p, std::size_t offset) const noexcept
+  {
+    while (p.utf8 != v_.size())
+    {
+      position q = p;
+      next(q);
+      if (q.*M > offset)
+        break;
+      p = q;
+    }
+    return p;
+  }
+
+  template <std::size_t offset_index::position::*M>
+  inline offset_index::position offset_index::find(std::size_t offset) const noexcept
+  {
+    if (offset >= end_.*M)
+      return end_;
+    auto it = std::upper_bound(checkpoints_.cbegin(), checkpoints_.cend(), offset,
+      [](std::size_t off, const position& p) { return off < p.*M; });
+    BOOST_ASSERT(it != checkpoints_.cbegin());  // checkpoints_[0] is all zeros
+    return scan<M>(*--it, offset);
+  }
+
+  inline offset_index::position offset_index::from_utf8(std::size_t offset)
+    const noexcept
+  {
+    return find<&position::utf8>(offset);
+  }
+
+  inline offset_index::position offset_index::from_utf16(std::size_t offset)
+    const noexcept
+  {
+    return find<&position::utf16>(offset);
+  }
+
+  inline offset_index::position offset_index::from_code_point(std::size_t offset)
+    const noexcept
+  {
+    if (offset >= end_.code_point)
+      return end_;
+    return scan<&position::code_point>(checkpoints_[offset / interval_], offset);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_OFFSET_INDEX_HPP
@@ -16,6 +16,8 @@
 #define BOOST_UNICODE_RECODER_HPP
 
 #include <boost/unicode/string_encoding.hpp>
+#include <array>
+#include <cstring>
 #include <type_traits>
 #include <iconv.h>
 #include <boost/assert.hpp>
@@ -30,6 +32,10 @@ namespace unicode
 
   //  ***** WARNING - EXPERIMENTAL - UNDOCUMENTED *****
 
+  //  How many times eh() is called for a run of ill-formed input: once for each code
+  //  unit of the run, or once for the whole run
+  enum class recoder_replacement { per_unit, per_run };
+
   template <class FromCharT, class ToCharT>
   class recoder
   {
@@ -37,12 +43,18 @@ namespace unicode
     using from_value_type = FromCharT;
     using to_value_type = ToCharT;
 
-    recoder(const std::string& from_name, const std::string& to_name);
+    recoder(const std::string& from_name, const std::string& to_name,
+      recoder_replacement replacement = recoder_replacement::per_run);
     ~recoder();
 
     const std::string& from_name() const noexcept;
     const std::string& to_name() const noexcept;
+    recoder_replacement replacement() const noexcept;
 
+    //  Converts [first, last) as a whole: starts from the initial shift state, treats
+    //  an incomplete sequence at the end as ill-formed, and ends with the sequence
+    //  returning the output to the initial shift state. Any input held over by feed()
+    //  is discarded.
     template <class OutputIterator, class Error = ufffd<ToCharT>>
     OutputIterator recode(const FromCharT* first, const FromCharT* last,
       OutputIterator result, Error eh = Error());
@@ -51,13 +63,75 @@ namespace unicode
     // codeset, iconv() performs an implementation-dependent conversion on this
     // character." So the eh argument is only applied when an input sub-sequence is
     // invalid (i.e. ill-formed) for the input encoding.
+    //
+    // A run of ill-formed input is skipped in one step, not one iconv() call per code
+    // unit. If the input encoding is the UTF form of FromCharT, the run is found with
+    // first_ill_formed(); otherwise, for char input, it extends over the octets that
+    // iconv() cannot start a character with.
+
+    //  streaming: the input is given in chunks, which may split a sequence anywhere
+
+    //  Converts [first, last) as the next chunk of the input. An incomplete sequence at
+    //  the end is held over, and converted with the start of the next chunk. A run of
+    //  ill-formed input split between chunks is replaced as if the input were whole, so
+    //  the output is that of recode() however the input is split.
+    template <class OutputIterator, class Error = ufffd<ToCharT>>
+    OutputIterator feed(const FromCharT* first, const FromCharT* last,
+      OutputIterator result, Error eh = Error());
+
+    //  Ends the input: replaces any incomplete sequence held over with eh(), outputs
+    //  the sequence returning the output to the initial shift state, if any, and
+    //  readies the recoder for a new input.
+    template <class OutputIterator, class Error = ufffd<ToCharT>>
+    OutputIterator flush(OutputIterator result, Error eh = Error());
+
+    //  Discards any input held over and returns to the initial shift state, without
+    //  output.
+    void reset() noexcept;
+
+    //  Returns: the number of octets of input held over by feed()
+    std::size_t pending() const noexcept;
 
   private:  // exposition only
 
+    template <class OutputIterator, class Error>
+    OutputIterator recode_untraced(const FromCharT* first, const FromCharT* last,
+      OutputIterator result, Error eh);
+
+    //  converts [inbuf, inbuf + inbytesleft); if !final, stops at an incomplete
+    //  sequence at the end, leaving inbuf and inbytesleft to describe it
+    template <class OutputIterator, class Error>
+    OutputIterator convert(char*& inbuf, std::size_t& inbytesleft,
+      OutputIterator result, Error eh, bool final);
+
+    //  outputs the octets [first, last) of iconv() output
+    template <class OutputIterator>
+    OutputIterator emit(const char* first, const char* last, OutputIterator result);
+
+    //  returns the end of the run of ill-formed input starting at first
+    const char* run_end(const char* first, const char* last, bool final) const;
+
+    //  returns the number of times to call eh() for the n octets of ill-formed input at
+    //  first, as recode() would for the same input given whole
+    std::size_t replacements(const char* first, std::size_t n) const;
+
+    static constexpr std::size_t carry_capacity = 32;  // octets; far longer than
+                                                       //   any incomplete sequence
+
     std::string from_name_;   // from encoding name
     std::string to_name_;     // to encoding name
     iconv_t     cd_;          // iconv conversion descriptor
-    
+    std::array<char, carry_capacity>
+                carry_;       // incomplete sequence held over by feed()
+    std::size_t carried_;     // octets in carry_
+    bool        at_start_;    // no output since the initial shift state
+    bool        run_open_;    // a run of ill-formed input reached the end of a chunk,
+                              //   with no input converted since
+    recoder_replacement
+                replacement_;
+    bool        utf_;         // from_name_ is the UTF form of FromCharT
+    std::array<bool, 256>
+                lead_;        // if !utf_, octets iconv() can start a character with
   };
 
 }  // namespace unicode
@@ -70,14 +144,96 @@ namespace boost
 {
 namespace unicode
 {
+namespace detail
+{
+  //  the UTF encoding form whose code unit is CharT
+  template <class CharT> struct recoder_utf;
+  template <> struct recoder_utf<char>     { using type = utf8; };
+  template <> struct recoder_utf<char16_t> { using type = utf16; };
+  template <> struct recoder_utf<char32_t> { using type = utf32; };
+  template <> struct recoder_utf<wchar_t>
+    { using type = std::conditional<sizeof(wchar_t) == 2, utf16, utf32>::type; };
+
+  //  true if iconv name is the UTF form with code units of size octets, in native
+  //  byte order
+  inline bool recoder_is_utf(const std::string& name, std::size_t size)
+  {
+    std::string n;
+    for (char c : name)
+      if (c != '-' && c != '_')
+        n += (c >= 'a' && c <= 'z') ? static_cast<char>(c - 'a' + 'A') : c;
+    if (size == 1)
+      return n == "UTF8";
+    const char16_t probe = 1;
+    const char* order = *reinterpret_cast<const unsigned char*>(&probe) == 1 ? "LE" : "BE";
+    return n == (size == 2 ? "UTF16" : "UTF32") + std::string(order);
+  }
+
+  //  returns the end of the ill-formed sequence the range sub from first_ill_formed()
+  //  begins with. For UTF-16 that range also covers the code unit after an unpaired
+  //  high surrogate, which may begin a well-formed sequence of its own.
+  template <class CharT, class Tag>
+  const CharT* recoder_ill_formed_end(std::pair<const CharT*, const CharT*> sub, Tag)
+    { return sub.second; }
+  template <class CharT>
+  const CharT* recoder_ill_formed_end(std::pair<const CharT*, const CharT*> sub, utf16)
+    { return sub.first + 1; }
+
+  //  returns the end of the run of ill-formed sequences starting at first. Only the
+  //  first few code units past each sequence are examined, so that the well-formed
+  //  input after the run is not scanned. Unless final, a sequence cut short by last
+  //  after the first is left for the next chunk to complete.
+  template <class CharT, class Tag>
+  const CharT* recoder_run_end(const CharT* first, const CharT* last, Tag, bool final)
+  {
+    auto window = [last](const CharT* p)
+      { return last - p > 4 ? p + 4 : last; };  // longest sequence is 4 code units
+    auto sub = first_ill_formed(first, window(first), Tag());
+    if (sub.first != first)  // iconv() and the validator disagree
+      return first + 1;
+    const CharT* end = recoder_ill_formed_end(sub, Tag());
+    const CharT* last_sub = first;
+    while (end != last)
+    {
+      auto next = first_ill_formed(end, window(end), Tag());
+      if (next.first != end)
+        break;
+      last_sub = end;
+      end = recoder_ill_formed_end(next, Tag());
+    }
+    return end == last && !final ? (last_sub != first ? last_sub : end) : end;
+  }
+}  // namespace detail
+
   template <class FromCharT, class ToCharT>
   recoder<FromCharT, ToCharT>::recoder(const std::string& from_name,
-    const std::string& to_name)
+    const std::string& to_name, recoder_replacement replacement)
     : from_name_(from_name), to_name_(to_name), cd_(iconv_open(
-        to_name.c_str(), from_name.c_str()))
+        to_name.c_str(), from_name.c_str())), carried_(0), at_start_(true),
+      run_open_(false), replacement_(replacement),
+      utf_(detail::recoder_is_utf(from_name, sizeof(FromCharT))), lead_()
   {
     if (cd_ == iconv_t(-1))
       throw "open barf with errno " + std::to_string(errno);
+
+    //  find the lead octets by converting each octet by itself: EILSEQ means no
+    //  character starts with it
+    if (!utf_ && sizeof(FromCharT) == 1)
+    {
+      for (std::size_t c = 0; c < lead_.size(); ++c)
+      {
+        char octet = static_cast<char>(c);
+        char* inbuf = &octet;
+        std::size_t inbytesleft = 1;
+        std::array<char, 16> buf;
+        char* outbuf = buf.data();
+        std::size_t outbytesleft = buf.size();
+        iconv(cd_, nullptr, nullptr, nullptr, nullptr);
+        lead_[c] = iconv(cd_, &inbuf, &inbytesleft, &outbuf, &outbytesleft)
+          != std::size_t(-1) || errno != EILSEQ;
+      }
+      iconv(cd_, nullptr, nullptr, nullptr, nullptr);
+    }
   }
 
   template <class FromCharT, class ToCharT>
@@ -95,73 +251,236 @@ namespace unicode
   inline const std::string& recoder<FromCharT, ToCharT>::to_name() const noexcept
     { return to_name_; }
 
+  template <class FromCharT, class ToCharT>
+  inline recoder_replacement recoder<FromCharT, ToCharT>::replacement() const noexcept
+    { return replacement_; }
+
+  template <class FromCharT, class ToCharT>
+  inline void recoder<FromCharT, ToCharT>::reset() noexcept
+  {
+    iconv(cd_, nullptr, nullptr, nullptr, nullptr);
+    carried_ = 0;
+    at_start_ = true;
+    run_open_ = false;
+  }
+
+  template <class FromCharT, class ToCharT>
+  inline std::size_t recoder<FromCharT, ToCharT>::pending() const noexcept
+    { return carried_; }
+
+  template <class FromCharT, class ToCharT>
+  template <class OutputIterator, class Error>
+  inline OutputIterator recoder<FromCharT, ToCharT>::recode(
+    const FromCharT* first, const FromCharT* last, OutputIterator result, Error eh)
+  {
+    if (conversion_observer* observer = get_conversion_observer())
+    {
+      detail::trace_scope trace(observer, conversion::recoder, from_name_.c_str(),
+        to_name_.c_str(), detail::byte_distance<FromCharT>(first, last));
+      OutputIterator end = recode_untraced(first, last, result, eh);
+      trace.finish(detail::byte_distance<ToCharT>(result, end));
+      return end;
+    }
+    return recode_untraced(first, last, result, eh);
+  }
+
   template <class FromCharT, class ToCharT>
   template <class OutputIterator, class Error>
-  OutputIterator recoder<FromCharT, ToCharT>::recode(
+  OutputIterator recoder<FromCharT, ToCharT>::recode_untraced(
     const FromCharT* first, const FromCharT* last, OutputIterator result, Error eh)
   {
     BOOST_ASSERT(cd_ != iconv_t(-1));  // recoder construction failed,
                                        //   yet recode has been called
+    BOOST_ASSERT(last - first >= 0);
+    reset();
+    char* inbuf = const_cast<char*>(reinterpret_cast<const char*>(first));
+    std::size_t inbytesleft
+      = static_cast<std::size_t>(reinterpret_cast<const char*>(last) - inbuf);
+    result = convert(inbuf, inbytesleft, result, eh, true);
+    return flush(result, eh);
+  }
 
-    //  The POSIX iconv declaration being adapted to is:
-    //    size_t iconv(iconv_t cd, const char **inbuf, size_t *inbytesleft,
-    //      char **outbuf, size_t *outbytesleft);
-    
+  template <class FromCharT, class ToCharT>
+  template <class OutputIterator, class Error>
+  OutputIterator recoder<FromCharT, ToCharT>::feed(
+    const FromCharT* first, const FromCharT* last, OutputIterator result, Error eh)
+  {
+    BOOST_ASSERT(cd_ != iconv_t(-1));
+    BOOST_ASSERT(last - first >= 0);
     char* inbuf = const_cast<char*>(reinterpret_cast<const char*>(first));
-    BOOST_ASSERT((reinterpret_cast<const char*>(last) - inbuf) >= 0);
     std::size_t inbytesleft
       = static_cast<std::size_t>(reinterpret_cast<const char*>(last) - inbuf);
 
+    //  complete the sequence held over with the start of this chunk
+    if (carried_ != 0)
+    {
+      const std::size_t old_carried = carried_;
+      const std::size_t n = inbytesleft < carry_capacity - carried_
+        ? inbytesleft : carry_capacity - carried_;
+      std::memcpy(carry_.data() + carried_, inbuf, n);
+      char* carrybuf = carry_.data();
+      std::size_t carryleft = carried_ + n;
+      result = convert(carrybuf, carryleft, result, eh, false);
+      const std::size_t used = static_cast<std::size_t>(carrybuf - carry_.data());
+      carried_ = 0;
+      if (used < old_carried)  // still incomplete
+      {
+        if (n == inbytesleft)  // all of this chunk held over too
+        {
+          std::memmove(carry_.data(), carrybuf, carryleft);
+          carried_ = carryleft;
+          return result;
+        }
+        //  longer than any sequence can be
+        std::size_t replacements = this->replacements(carrybuf, carryleft);
+        BOOST_UNICODE_COUNT(invalid, replacements);
+        for (; replacements != 0; --replacements)
+          for (auto it = eh(); *it != '\0'; ++it)
+            *result++ = *it;
+        run_open_ = true;
+        inbuf += n;
+        inbytesleft -= n;
+      }
+      else
+      {
+        inbuf += used - old_carried;  // an incomplete sequence left in carry_ is
+        inbytesleft -= used - old_carried;  //   also at the start of what remains
+      }
+    }
+
+    result = convert(inbuf, inbytesleft, result, eh, false);
+    if (inbytesleft > carry_capacity)  // longer than any sequence can be
+    {
+      std::size_t replacements = this->replacements(inbuf, inbytesleft);
+      BOOST_UNICODE_COUNT(invalid, replacements);
+      for (; replacements != 0; --replacements)
+        for (auto it = eh(); *it != '\0'; ++it)
+          *result++ = *it;
+      run_open_ = true;
+      inbuf += inbytesleft;
+      inbytesleft = 0;
+    }
+    std::memcpy(carry_.data(), inbuf, inbytesleft);
+    carried_ = inbytesleft;
+    return result;
+  }
+
+  template <class FromCharT, class ToCharT>
+  template <class OutputIterator, class Error>
+  OutputIterator recoder<FromCharT, ToCharT>::flush(OutputIterator result, Error eh)
+  {
+    BOOST_ASSERT(cd_ != iconv_t(-1));
+    if (carried_ != 0)
+    {
+      std::size_t replacements = this->replacements(carry_.data(), carried_);
+      BOOST_UNICODE_COUNT(truncated, replacements);
+      for (; replacements != 0; --replacements)
+        for (auto it = eh(); *it != '\0'; ++it)
+          *result++ = *it;
+      carried_ = 0;
+    }
+    run_open_ = false;
+
+    //  the shift sequence; iconv() then starts over, BOM and all
     std::array<char, BOOST_UNICODE_BUFFER_SIZE> buf;
+    char* outbuf = buf.data();
+    std::size_t outbytesleft = buf.size();
+    iconv(cd_, nullptr, nullptr, &outbuf, &outbytesleft);
+    result = emit(buf.data(), outbuf, result);
+    at_start_ = true;
+    return result;
+  }
+
+  template <class FromCharT, class ToCharT>
+  template <class OutputIterator>
+  OutputIterator recoder<FromCharT, ToCharT>::emit(const char* first, const char* last,
+    OutputIterator result)
+  {
+    // ignore leading char16_t or char32_t byte order marker (BOM) gratuitously 
+    // inserted by libstdc++
+    if (at_start_ && first != last)
+    {
+      at_start_ = false;
+      if ((std::is_same<ToCharT, char32_t>::value
+            || std::is_same<ToCharT, char16_t>::value)
+          && static_cast<std::size_t>(last - first) >= sizeof(ToCharT)
+          && *reinterpret_cast<const ToCharT*>(first) == 0xFEFF)
+        first += sizeof(ToCharT);
+    }
+
+    for (; first != last; first += sizeof(ToCharT))
+      *result++ = *reinterpret_cast<const ToCharT*>(first);
+    return result;
+  }
+
+  template <class FromCharT, class ToCharT>
+  const char* recoder<FromCharT, ToCharT>::run_end(const char* first, const char* last,
+    bool final) const
+  {
+    if (static_cast<std::size_t>(last - first) <= sizeof(FromCharT))
+      return last;
+    if (utf_)
+      return reinterpret_cast<const char*>(detail::recoder_run_end(
+        reinterpret_cast<const FromCharT*>(first),
+        reinterpret_cast<const FromCharT*>(first)
+          + (last - first) / static_cast<std::ptrdiff_t>(sizeof(FromCharT)),
+        typename detail::recoder_utf<FromCharT>::type(), final));
+    if (sizeof(FromCharT) == 1)
+    {
+      const char* end = first + 1;
+      while (end != last && !lead_[static_cast<unsigned char>(*end)])
+        ++end;
+      return end;
+    }
+    return first + sizeof(FromCharT);
+  }
 
-    char* outbuf; 
-    std::size_t outbytesleft;
-    std::size_t iconv_result;
-    bool first_output_code_point = true;
+  template <class FromCharT, class ToCharT>
+  std::size_t recoder<FromCharT, ToCharT>::replacements(const char* first,
+    std::size_t n) const
+  {
+    if (replacement_ == recoder_replacement::per_unit)
+      return (n + sizeof(FromCharT) - 1) / sizeof(FromCharT);
+
+    //  a run cut off by the end of the last chunk goes on here if recode() would have
+    //  taken these octets into it: for UTF input, any ill-formed sequence does; for
+    //  other char input, only octets iconv() cannot start a character with
+    bool goes_on = run_open_
+      && (utf_ || (sizeof(FromCharT) == 1 && !lead_[static_cast<unsigned char>(*first)]));
+    return goes_on ? 0 : 1;
+  }
+
+  template <class FromCharT, class ToCharT>
+  template <class OutputIterator, class Error>
+  OutputIterator recoder<FromCharT, ToCharT>::convert(char*& inbuf,
+    std::size_t& inbytesleft, OutputIterator result, Error eh, bool final)
+  {
+    //  The POSIX iconv declaration being adapted to is:
+    //    size_t iconv(iconv_t cd, const char **inbuf, size_t *inbytesleft,
+    //      char **outbuf, size_t *outbytesleft);
 
-    // TODO:
-    // put the conversion descriptor cd_ into its initial shift state
-    //outbuf = buf.data();
-    //outbytesleft = buf.size();
-    //iconv(cd_, 0, 0, &outbuf, &outbytesleft);
+    std::array<char, BOOST_UNICODE_BUFFER_SIZE> buf;
 
     //  loop until the entire input sequence is processed by iconv() 
 
     while (inbytesleft !=0)
     {
-      outbuf = buf.data();
-      outbytesleft = buf.size();
-
-      //std::cout << "\nbefore iconv(), inbytesleft=" << inbytesleft
-      //  << ", outbytesleft=" << outbytesleft << std::endl;
-
-      iconv_result = iconv(cd_, &inbuf, &inbytesleft, &outbuf, &outbytesleft);
+      char* outbuf = buf.data();
+      std::size_t outbytesleft = buf.size();
 
-      //std::cout << "after iconv(), inbytesleft=" << inbytesleft
-      //  << ", outbytesleft=" << outbytesleft
-      //  << ", return=" << iconv_result << ", errno=" << errno << std::endl;
+      std::size_t inbytes = inbytesleft;
+      std::size_t iconv_result
+        = iconv(cd_, &inbuf, &inbytesleft, &outbuf, &outbytesleft);
 
       int saved_errno = errno;  // save errno in case *result++ resets it
-      auto out_it = buf.data(); // get ready to output buffer contents
-
-      // ignore leading char16_t or char32_t byte order marker (BOM) gratuitously 
-      // inserted by libstdc++
-      if (first_output_code_point)
-      {
-        first_output_code_point = false;
-        if ((std::is_same<ToCharT, char32_t>::value
-              || std::is_same<ToCharT, char16_t>::value)
-            && outbytesleft <= (buf.size()- sizeof(ToCharT))
-            && *reinterpret_cast<ToCharT*>(buf.data()) == 0xFEFF)
-        {
-          out_it += sizeof(ToCharT);
-          outbytesleft -= sizeof(ToCharT);
-        }
-      }
+      BOOST_UNICODE_COUNT(iconv_calls, 1);
+      BOOST_UNICODE_COUNT(bytes_in, inbytes - inbytesleft);
+      BOOST_UNICODE_COUNT(bytes_out, outbuf - buf.data());
+      if (inbytesleft != inbytes)
+        run_open_ = false;
 
       // output the buffer contents, if any
-      for (; out_it != outbuf; out_it += sizeof(ToCharT))
-        *result++ = *reinterpret_cast<ToCharT*>(out_it);
+      result = emit(buf.data(), outbuf, result);
 
       if (iconv_result != std::size_t(-1))   // success; no error reported
       {
@@ -173,16 +492,27 @@ namespace unicode
       if (saved_errno == E2BIG)  // E2BIG: lack of space in the output buffer
         continue;
 
+      if (saved_errno == EINVAL && !final)  // EINVAL: incomplete sequence at the end,
+        return result;                      //   to be completed by the next chunk
+
       if (saved_errno == EILSEQ // EILSEQ: invalid multibyte sequence in the input
           || saved_errno == EINVAL)
       {
-        for (auto it = eh(); *it != '\0'; ++it)  // output any error message
-          *result++ = *it;
-         if (inbytesleft <= sizeof(FromCharT))
-          break;
-        // move forward one code-unit  
-        inbuf += sizeof(FromCharT);
-        inbytesleft -= sizeof(FromCharT);
+        //  skip the whole run; EINVAL: incomplete sequence at the end, so all the rest
+        const char* end = saved_errno == EILSEQ
+          ? run_end(inbuf, inbuf + inbytesleft, final) : inbuf + inbytesleft;
+        std::size_t n = static_cast<std::size_t>(end - inbuf);
+        std::size_t replacements = this->replacements(inbuf, n);
+        if (saved_errno == EILSEQ)
+          BOOST_UNICODE_COUNT(invalid, replacements);
+        else
+          BOOST_UNICODE_COUNT(truncated, replacements);
+        for (; replacements != 0; --replacements)
+          for (auto it = eh(); *it != '\0'; ++it)  // output any error message
+            *result++ = *it;
+        inbuf += n;
+        inbytesleft -= n;
+        run_open_ = !final;
       }
       
       else  // some totally unexpected error, so bail out
@@ -0,0 +1,118 @@
+﻿//  boost/unicode/sanitize.hpp  --------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#if !defined(BOOST_UNICODE_SANITIZE_HPP)
+#define BOOST_UNICODE_SANITIZE_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <array>
+#include <cstring>
+#include <string>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  //  Effects: Replaces each ill-formed sequence in s with U+FFFD, giving the same
+  //    result as s = to_string<utf8>(s), but without allocating or copying when s is
+  //    already well-formed. Otherwise s is compacted in place if the result fits in
+  //    the space already consumed, or else reallocated once at its exact size.
+  //  Returns: true if s was already well-formed.
+  bool sanitize_in_place(std::string& s);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  utf8_sanitize
+  //
+  //  Calls out(p, n, consumed) for each successive piece [p, p+n) of the sanitized
+  //  result, where consumed is the end of the input the piece was produced from.
+  //  Well-formed runs are passed straight through from the input; each ill-formed
+  //  sequence is recoded exactly as utf8_to_char32_t() does.
+
+  template <class Output>
+  void utf8_sanitize(const char* first, const char* last, Output out)
+  {
+    for (;;)
+    {
+      const char* err = first_ill_formed(first, last, utf8()).first;
+      if (err != first)
+        out(first, static_cast<std::size_t>(err - first), err);
+      if (err == last)
+        return;
+
+      std::array<char, 4> buf;
+      char* buf_end = buf.data();
+      char32_t u32;
+      if (utf8_decode(err, last, u32))
+        buf_end = char32_t_to_utf8<char>(u32, buf_end, ufffd<char>());
+      else
+        buf_end = char32_t_to_utf8<char>(0xFFFDu, buf_end, ufffd<char>());
+      out(buf.data(), static_cast<std::size_t>(buf_end - buf.data()), err);
+      first = err;
+    }
+  }
+}  // namespace detail
+
+  inline bool sanitize_in_place(std::string& s)
+  {
+    const char* first = s.data();
+    const char* last = first + s.size();
+    const char* err = detail::first_ill_formed(first, last, utf8()).first;
+    if (err == last)
+      return true;  // the common case
+
+    //  size the result, noting if writing it would ever overtake the input
+    std::size_t size = static_cast<std::size_t>(err - first);
+    bool fits = true;
+    detail::utf8_sanitize(err, last,
+      [&](const char*, std::size_t n, const char* consumed)
+      {
+        size += n;
+        fits = fits && size <= static_cast<std::size_t>(consumed - first);
+      });
+
+    if (fits)
+    {
+      char* out = &s[0] + (err - first);
+      detail::utf8_sanitize(err, last,
+        [&](const char* p, std::size_t n, const char*)
+        {
+          std::memmove(out, p, n);
+          out += n;
+        });
+      s.resize(size);
+    }
+    else
+    {
+      std::string tmp;
+      tmp.reserve(size);
+      tmp.append(first, err);
+      detail::utf8_sanitize(err, last,
+        [&](const char* p, std::size_t n, const char*) { tmp.append(p, n); });
+      s.swap(tmp);
+    }
+    return false;
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_SANITIZE_HPP
@@ -0,0 +1,511 @@
+﻿//  boost/unicode/sink.hpp  ------------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  A sink is a destination for recode_to_sink() that takes code units in blocks, not   //
+//  one at a time through an output iterator:                                           //
+//                                                                                      //
+//    std::u16string s;                                                                 //
+//    auto sink = make_sink(s);                                                         //
+//    recode_to_sink<utf8, utf16>(v.begin(), v.end(), sink);                            //
+//                                                                                      //
+//  Sink requirements, for a sink s of type Sink:                                       //
+//                                                                                      //
+//    Sink::value_type          the code unit type                                      //
+//    s.reserve(n)              a hint that about n more code units follow              //
+//    s.write(p, n)             appends the n code units at p                           //
+//    s.acquire(n)              returns a span<value_type> of space for up to n code    //
+//                              units, empty only if the sink can take no more          //
+//    s.commit(k)               appends the first k code units of the span last         //
+//                              acquired, which is then released                        //
+//                                                                                      //
+//  The conversion writes into acquired spans of sink_block_size code units, so a       //
+//  string or vector is resized once per block rather than grown by a push_back() per   //
+//  code unit, and a raw buffer, such as an mmap() region, is written in place. Runs    //
+//  copied without conversion, such as the well-formed runs of a UTF-8 to UTF-8         //
+//  recode, go to write() whole.                                                        //
+//                                                                                      //
+//  string_sink and vector_sink append to a container. buffer_sink fills [first, last)  //
+//  and counts what did not fit. streambuf_sink and fd_sink hand each block to sputn()  //
+//  or to POSIX write(); fd_sink buffers BOOST_UNICODE_BUFFER_SIZE octets of them, and  //
+//  is flushed by flush() or its destructor.                                            //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_SINK_HPP)
+#define BOOST_UNICODE_SINK_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <streambuf>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <unistd.h>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  //  code units per span acquired by recode_to_sink()
+  constexpr std::size_t sink_block_size = 64;
+
+  template <class T>
+  class span
+  {
+  public:
+    constexpr span() noexcept : data_(nullptr), size_(0) {}
+    constexpr span(T* p, std::size_t n) noexcept : data_(p), size_(n) {}
+
+    constexpr T*          data() const noexcept  { return data_; }
+    constexpr std::size_t size() const noexcept  { return size_; }
+    constexpr bool        empty() const noexcept { return size_ == 0; }
+    constexpr T*          begin() const noexcept { return data_; }
+    constexpr T*          end() const noexcept   { return data_ + size_; }
+
+  private:
+    T*          data_;
+    std::size_t size_;
+  };
+
+  template <class CharT, class Traits = std::char_traits<CharT>,
+    class Alloc = std::allocator<CharT>>
+  class string_sink
+  {
+  public:
+    using value_type = CharT;
+    using string_type = std::basic_string<CharT, Traits, Alloc>;
+
+    explicit string_sink(string_type& s) noexcept : s_(s), used_(s.size()) {}
+
+    void reserve(std::size_t n)                { s_.reserve(used_ + n); }
+    void write(const CharT* p, std::size_t n)  { s_.append(p, n); used_ += n; }
+    span<CharT> acquire(std::size_t n);
+    void commit(std::size_t k);
+
+  private:  // exposition only
+    string_type& s_;
+    std::size_t  used_;  // s_.size() but for an acquired span
+  };
+
+  template <class T, class Alloc = std::allocator<T>>
+  class vector_sink
+  {
+  public:
+    using value_type = T;
+    using vector_type = std::vector<T, Alloc>;
+
+    explicit vector_sink(vector_type& v) noexcept : v_(v), used_(v.size()) {}
+
+    void reserve(std::size_t n)            { v_.reserve(used_ + n); }
+    void write(const T* p, std::size_t n)  { v_.insert(v_.end(), p, p + n); used_ += n; }
+    span<T> acquire(std::size_t n);
+    void commit(std::size_t k);
+
+  private:  // exposition only
+    vector_type& v_;
+    std::size_t  used_;  // v_.size() but for an acquired span
+  };
+
+  //  Fills [first, last). Code units beyond last are counted but not kept, so that
+  //  size() + overflow() is the size the buffer needed to be.
+  template <class T>
+  class buffer_sink
+  {
+  public:
+    using value_type = T;
+
+    buffer_sink(T* first, T* last) noexcept : first_(first), next_(first), last_(last),
+      overflow_(0) {}
+
+    T*          data() const noexcept     { return first_; }
+    std::size_t size() const noexcept
+      { return static_cast<std::size_t>(next_ - first_); }
+    std::size_t overflow() const noexcept { return overflow_; }
+
+    void reserve(std::size_t) noexcept {}
+    void write(const T* p, std::size_t n) noexcept;
+    span<T> acquire(std::size_t n) noexcept;
+    void commit(std::size_t k) noexcept;
+
+  private:  // exposition only
+    T*          first_;
+    T*          next_;
+    T*          last_;
+    std::size_t overflow_;  // code units that did not fit
+    std::array<T, sink_block_size> spill_;  // acquired once the buffer is full
+    bool        spilled_ = false;           // the last span acquired is spill_
+  };
+
+  //  Writes to a std::basic_streambuf with sputn(). failed() is true if sputn() ever
+  //  wrote less than it was given.
+  template <class CharT, class Traits = std::char_traits<CharT>>
+  class streambuf_sink
+  {
+  public:
+    using value_type = CharT;
+
+    explicit streambuf_sink(std::basic_streambuf<CharT, Traits>& sb) noexcept
+      : sb_(sb), failed_(false) {}
+
+    bool failed() const noexcept { return failed_; }
+
+    void reserve(std::size_t) noexcept {}
+    void write(const CharT* p, std::size_t n);
+    span<CharT> acquire(std::size_t n) noexcept;
+    void commit(std::size_t k) { write(buf_.data(), k); }
+
+  private:  // exposition only
+    std::basic_streambuf<CharT, Traits>& sb_;
+    bool failed_;
+    std::array<CharT, sink_block_size> buf_;
+  };
+
+  //  Writes to a POSIX file descriptor, such as a file, pipe, or socket, in buffered
+  //  blocks. Throws: std::system_error if write() fails.
+  template <class T = char>
+  class fd_sink
+  {
+  public:
+    using value_type = T;
+
+    explicit fd_sink(int fd) noexcept : fd_(fd), used_(0) {}
+    ~fd_sink();  // flushes, ignoring errors
+
+    void flush();
+
+    void reserve(std::size_t) noexcept {}
+    void write(const T* p, std::size_t n);
+    span<T> acquire(std::size_t n);
+    void commit(std::size_t k) noexcept { used_ += k; }
+
+  private:  // exposition only
+    static constexpr std::size_t capacity = BOOST_UNICODE_BUFFER_SIZE * 32 / sizeof(T);
+
+    void write_fd(const T* p, std::size_t n);
+
+    int         fd_;
+    std::size_t used_;  // code units in buf_
+    std::array<T, capacity> buf_;
+  };
+
+  template <class CharT, class Traits, class Alloc>
+  string_sink<CharT, Traits, Alloc>
+    make_sink(std::basic_string<CharT, Traits, Alloc>& s) noexcept;
+  template <class T, class Alloc>
+  vector_sink<T, Alloc> make_sink(std::vector<T, Alloc>& v) noexcept;
+  template <class T>
+  buffer_sink<T> make_sink(T* first, T* last) noexcept;
+  template <class CharT, class Traits>
+  streambuf_sink<CharT, Traits> make_sink(std::basic_streambuf<CharT, Traits>& sb)
+    noexcept;
+
+  //  As recode(), but to sink, whose value_type must be ToEncoding::value_type
+  template <class FromEncoding, class ToEncoding, class InputIterator, class Sink,
+    class ... T>
+  void recode_to_sink(InputIterator first, InputIterator last, Sink& sink,
+    const T& ... args);
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  //  string_sink  -------------------------------------------------------------------//
+
+  //  as codecvt_sink does for a string, the span is made by resize(), and the unused
+  //  part trimmed by commit()
+  template <class CharT, class Traits, class Alloc>
+  inline span<CharT> string_sink<CharT, Traits, Alloc>::acquire(std::size_t n)
+  {
+    s_.resize(used_ + n);
+    return span<CharT>(&s_[0] + used_, n);
+  }
+
+  template <class CharT, class Traits, class Alloc>
+  inline void string_sink<CharT, Traits, Alloc>::commit(std::size_t k)
+  {
+    used_ += k;
+    s_.resize(used_);
+  }
+
+  //  vector_sink  -------------------------------------------------------------------//
+
+  template <class T, class Alloc>
+  inline span<T> vector_sink<T, Alloc>::acquire(std::size_t n)
+  {
+    v_.resize(used_ + n);
+    return span<T>(v_.data() + used_, n);
+  }
+
+  template <class T, class Alloc>
+  inline void vector_sink<T, Alloc>::commit(std::size_t k)
+  {
+    used_ += k;
+    v_.resize(used_);
+  }
+
+  //  buffer_sink  -------------------------------------------------------------------//
+
+  template <class T>
+  inline void buffer_sink<T>::write(const T* p, std::size_t n) noexcept
+  {
+    std::size_t room = static_cast<std::size_t>(last_ - next_);
+    std::size_t k = n < room ? n : room;
+    std::copy(p, p + k, next_);
+    next_ += k;
+    overflow_ += n - k;
+  }
+
+  template <class T>
+  inline span<T> buffer_sink<T>::acquire(std::size_t n) noexcept
+  {
+    std::size_t room = static_cast<std::size_t>(last_ - next_);
+    spilled_ = room == 0;
+    if (spilled_)
+      return span<T>(spill_.data(), n < spill_.size() ? n : spill_.size());
+    return span<T>(next_, n < room ? n : room);
+  }
+
+  template <class T>
+  inline void buffer_sink<T>::commit(std::size_t k) noexcept
+  {
+    if (spilled_)
+      overflow_ += k;
+    else
+      next_ += k;
+  }
+
+  //  streambuf_sink  ----------------------------------------------------------------//
+
+  template <class CharT, class Traits>
+  inline void streambuf_sink<CharT, Traits>::write(const CharT* p, std::size_t n)
+  {
+    if (sb_.sputn(p, static_cast<std::streamsize>(n)) != static_cast<std::streamsize>(n))
+      failed_ = true;
+  }
+
+  template <class CharT, class Traits>
+  inline span<CharT> streambuf_sink<CharT, Traits>::acquire(std::size_t n) noexcept
+  {
+    return span<CharT>(buf_.data(), n < buf_.size() ? n : buf_.size());
+  }
+
+  //  fd_sink  -----------------------------------------------------------------------//
+
+  template <class T>
+  inline fd_sink<T>::~fd_sink()
+  {
+    try { flush(); }
+    catch (...) {}
+  }
+
+  template <class T>
+  inline void fd_sink<T>::write_fd(const T* p, std::size_t n)
+  {
+    const char* first = reinterpret_cast<const char*>(p);
+    std::size_t left = n * sizeof(T);
+    while (left != 0)
+    {
+      ::ssize_t written = ::write(fd_, first, left);
+      if (written < 0)
+      {
+        if (errno == EINTR)
+          continue;
+        throw std::system_error(errno, std::system_category(), "fd_sink");
+      }
+      first += written;
+      left -= static_cast<std::size_t>(written);
+    }
+  }
+
+  template <class T>
+  inline void fd_sink<T>::flush()
+  {
+    std::size_t n = used_;
+    used_ = 0;
+    write_fd(buf_.data(), n);
+  }
+
+  template <class T>
+  inline void fd_sink<T>::write(const T* p, std::size_t n)
+  {
+    if (n < capacity - used_)
+    {
+      std::copy(p, p + n, buf_.data() + used_);
+      used_ += n;
+      return;
+    }
+    flush();
+    write_fd(p, n);
+  }
+
+  template <class T>
+  inline span<T> fd_sink<T>::acquire(std::size_t n)
+  {
+    if (capacity - used_ < n)
+      flush();
+    return span<T>(buf_.data() + used_, n < capacity ? n : capacity);
+  }
+
+  //  make_sink  ---------------------------------------------------------------------//
+
+  template <class CharT, class Traits, class Alloc>
+  inline string_sink<CharT, Traits, Alloc>
+    make_sink(std::basic_string<CharT, Traits, Alloc>& s) noexcept
+  {
+    return string_sink<CharT, Traits, Alloc>(s);
+  }
+
+  template <class T, class Alloc>
+  inline vector_sink<T, Alloc> make_sink(std::vector<T, Alloc>& v) noexcept
+  {
+    return vector_sink<T, Alloc>(v);
+  }
+
+  template <class T>
+  inline buffer_sink<T> make_sink(T* first, T* last) noexcept
+  {
+    return buffer_sink<T>(first, last);
+  }
+
+  template <class CharT, class Traits>
+  inline streambuf_sink<CharT, Traits>
+    make_sink(std::basic_streambuf<CharT, Traits>& sb) noexcept
+  {
+    return streambuf_sink<CharT, Traits>(sb);
+  }
+
+namespace detail
+{
+  //  sink_writer, sink_iterator
+  //
+  //  The output iterator recode() writes through: each code unit goes into the span
+  //  acquired from the sink, and a full span is committed and another acquired. The
+  //  span is held by a sink_writer that the iterator points to, so that the iterator,
+  //  like a back_inserter, is one pointer, passed in a register through the kernels.
+
+  template <class Sink>
+  struct sink_writer
+  {
+    using char_type = typename Sink::value_type;
+
+    explicit sink_writer(Sink& s) noexcept
+      : sink(s), first(nullptr), next(nullptr), last(nullptr) {}
+
+    void refill()
+    {
+      flush();
+      span<char_type> s = sink.acquire(sink_block_size);
+      BOOST_ASSERT(!s.empty());
+      first = next = s.data();
+      last = s.data() + s.size();
+    }
+
+    //  commits the code units written to the span, and releases it
+    void flush()
+    {
+      if (first != nullptr)
+        sink.commit(static_cast<std::size_t>(next - first));
+      first = next = last = nullptr;
+    }
+
+    Sink&      sink;
+    char_type* first;  // the span acquired, if any
+    char_type* next;
+    char_type* last;
+  };
+
+  template <class Sink>
+  class sink_iterator
+  {
+  public:
+    using iterator_category = std::output_iterator_tag;
+    using value_type = void;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = void;
+    using char_type = typename Sink::value_type;
+
+    explicit sink_iterator(sink_writer<Sink>& w) noexcept : w_(&w) {}
+
+    sink_iterator& operator*() noexcept     { return *this; }
+    sink_iterator& operator++() noexcept    { return *this; }
+    sink_iterator& operator++(int) noexcept { return *this; }
+
+    sink_iterator& operator=(char_type c)
+    {
+      if (w_->next == w_->last)
+        w_->refill();
+      *w_->next++ = c;
+      return *this;
+    }
+
+    sink_writer<Sink>& writer() const noexcept { return *w_; }
+
+  private:
+    sink_writer<Sink>* w_;
+  };
+
+  //  runs copied without conversion go to write() whole
+  template <class ToCharT, class Sink>
+  inline sink_iterator<Sink> copy_code_units(const ToCharT* first, const ToCharT* last,
+    sink_iterator<Sink> result)
+  {
+    result.writer().flush();
+    result.writer().sink.write(first, static_cast<std::size_t>(last - first));
+    return result;
+  }
+
+  template <class Sink, class RandomAccessIterator>
+  inline void reserve_for(Sink& sink, RandomAccessIterator first,
+    RandomAccessIterator last, std::random_access_iterator_tag)
+  {
+    sink.reserve(static_cast<std::size_t>(last - first));
+  }
+  template <class Sink, class InputIterator, class Tag>
+  inline void reserve_for(Sink&, InputIterator, InputIterator, Tag) {}
+}  // namespace detail
+
+  template <class FromEncoding, class ToEncoding, class InputIterator, class Sink,
+    class ... T>
+  inline void recode_to_sink(InputIterator first, InputIterator last, Sink& sink,
+    const T& ... args)
+  {
+    static_assert(std::is_same<typename Sink::value_type,
+      typename ToEncoding::value_type>::value,
+      "Sink::value_type must be ToEncoding::value_type");
+
+    //  one code unit out for each in is a lower bound for most conversions
+    detail::reserve_for(sink, first, last,
+      typename std::iterator_traits<InputIterator>::iterator_category());
+    detail::sink_writer<Sink> w(sink);
+    recode<FromEncoding, ToEncoding>(first, last, detail::sink_iterator<Sink>(w),
+      args ...);
+    w.flush();
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_SINK_HPP
@@ -14,11 +14,18 @@
 #include <array>
 #include <type_traits>
 #include <cstdint>
+#include <cstring>
 #include <boost/config.hpp>
 #include <boost/utility/string_view_fwd.hpp> 
 #include <boost/utility/string_view.hpp> 
 #include <boost/assert.hpp>
 #include <boost/cstdint.hpp>     // todo: remove me
+#include <boost/unicode/instrumentation.hpp>
+#include <boost/unicode/trace.hpp>
+#include <boost/unicode/detail/constant_evaluation.hpp>
+#include <boost/unicode/detail/sse2.hpp>
+#include <boost/unicode/detail/swar.hpp>
+#include <boost/unicode/detail/utf8_dfa.hpp>
 
 // TODO: update this:
 //--------------------------------------------------------------------------------------//
@@ -129,6 +136,7 @@ namespace unicode
   //  [uni.recode] encoding conversion algorithm
   template <class FromEncoding, class ToEncoding, class InputIterator,
     class OutputIterator, class ... T>
+  BOOST_CXX14_CONSTEXPR
   OutputIterator recode(InputIterator first, InputIterator last, OutputIterator result,  
     const T& ... args);
 
@@ -148,13 +156,22 @@ namespace unicode
 
   //  [uni.utf-query] UTF encoding queries
   template <class ForwardIterator>
-    std::pair<ForwardIterator, ForwardIterator>
+    BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
       first_ill_formed(ForwardIterator first, ForwardIterator last) BOOST_NOEXCEPT;
 
-  bool is_well_formed(boost::string_view v) BOOST_NOEXCEPT;
-  bool is_well_formed(boost::u16string_view v) BOOST_NOEXCEPT;
-  bool is_well_formed(boost::u32string_view v) BOOST_NOEXCEPT;
-  bool is_well_formed(boost::wstring_view v) BOOST_NOEXCEPT;
+  BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::string_view v) BOOST_NOEXCEPT;
+  BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::u16string_view v) BOOST_NOEXCEPT;
+  BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::u32string_view v) BOOST_NOEXCEPT;
+  BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::wstring_view v) BOOST_NOEXCEPT;
+
+  //  [uni.utf-count] UTF length queries; ill-formed sequences are counted exactly as
+  //  recode() with the default error handler would replace them
+  std::size_t count_code_points(boost::string_view v) BOOST_NOEXCEPT;
+  std::size_t count_code_points(boost::u16string_view v) BOOST_NOEXCEPT;
+  std::size_t count_code_points(boost::u32string_view v) BOOST_NOEXCEPT;
+  std::size_t count_code_points(boost::wstring_view v) BOOST_NOEXCEPT;
+
+  std::size_t utf16_length_of_utf8(boost::string_view v) BOOST_NOEXCEPT;
 
 }  // namespace unicode
 }  // namespace boost
@@ -187,6 +204,130 @@ namespace unicode
         ? 1 + ccvt_count<Pack...>()
         : 0;
     }
+
+    inline const char* encoding_name(narrow) BOOST_NOEXCEPT { return "narrow"; }
+    inline const char* encoding_name(utf8) BOOST_NOEXCEPT   { return "utf8"; }
+    inline const char* encoding_name(utf16) BOOST_NOEXCEPT  { return "utf16"; }
+    inline const char* encoding_name(utf32) BOOST_NOEXCEPT  { return "utf32"; }
+    inline const char* encoding_name(wide) BOOST_NOEXCEPT   { return "wide"; }
+
+    //  recode() without the tracing hook, for use within the library
+    template <class FromEncoding, class ToEncoding,
+      class InputIterator, class OutputIterator, class ... T>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator recode_untraced(InputIterator first, InputIterator last,
+      OutputIterator result, const T& ... args);
+
+    struct utf_tag;
+    template <class Encoding> struct dispatch;
+
+    //  utf_pair: both encodings are UTF, so that max_expansion() bounds the output; the
+    //  other encodings, such as gb18030 or cesu8, can expand more
+    template <class FromEncoding, class ToEncoding>
+    struct utf_pair : std::integral_constant<bool,
+      std::is_same<typename dispatch<FromEncoding>::tag, utf_tag>::value
+      && std::is_same<typename dispatch<ToEncoding>::tag, utf_tag>::value> {};
+
+    //  max_expansion: the most code units a UTF to UTF recode() with the default error
+    //  handler outputs per code unit in; U+FFFD, three octets in UTF-8, replaces as
+    //  little as one code unit
+    template <class FromEncoding, class ToEncoding>
+    constexpr std::size_t max_expansion() noexcept
+    {
+      return sizeof(typename ToEncoding::value_type) == 1
+        ? (sizeof(typename FromEncoding::value_type) == 4 ? 4 : 3)
+        : (sizeof(typename FromEncoding::value_type) == 4
+          && sizeof(typename ToEncoding::value_type) == 2 ? 2 : 1);
+    }
+
+    //  appends_runs: String is one that copy_code_units() appends a run to in one call
+    template <class String> struct appends_runs : std::false_type {};
+    template <class CharT, class Traits, class Alloc>
+    struct appends_runs<std::basic_string<CharT, Traits, Alloc>> : std::true_type {};
+
+    template <class FromEncoding, class ToEncoding, class View, class String>
+    inline void sized_recode_to_string(std::false_type, View v, String& s)
+    {
+      recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
+        std::back_inserter(s));
+    }
+
+    template <class FromEncoding, class ToEncoding, class View, class String>
+    inline void sized_recode_to_string(std::true_type, View v, String& s)
+    {
+      using to_char = typename ToEncoding::value_type;
+      constexpr std::size_t expansion = max_expansion<FromEncoding, ToEncoding>();
+      constexpr std::size_t short_size
+        = 8 * BOOST_UNICODE_BUFFER_SIZE / (expansion * sizeof(to_char));
+
+      if (v.size() * expansion <= s.capacity())
+      {
+        s.resize(v.size() * expansion);
+        to_char* first = &s[0];
+        to_char* last
+          = recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(), first);
+        s.resize(static_cast<std::size_t>(last - first));
+      }
+      else if (v.size() <= short_size && !(appends_runs<String>::value
+        && sizeof(typename View::value_type) == sizeof(to_char)))
+      {
+        to_char buf[short_size * expansion];
+        to_char* last
+          = recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(), buf);
+        s.append(buf, static_cast<std::size_t>(last - buf));
+      }
+      else
+        recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
+          std::back_inserter(s));
+    }
+
+    //  recode_to_string: converts v to s, which is empty. For UTF encodings and the
+    //  default error handler, output sure to fit the capacity s already has, such as its
+    //  small string buffer, is written to s directly, so it is not allocated at all; and
+    //  output sure to fit 8 * BOOST_UNICODE_BUFFER_SIZE octets is written to a buffer on
+    //  the stack, then copied to s, so it is allocated once at its exact size. Longer
+    //  input, an error handler whose replacement could be any length, other encodings,
+    //  or, for a std::basic_string, code units of the same size, whose well-formed runs
+    //  copy_code_units() appends whole anyway, are appended.
+    template <class FromEncoding, class ToEncoding, class View, class String>
+    inline void recode_to_string(View v, String& s)
+    {
+      sized_recode_to_string<FromEncoding, ToEncoding>(
+        utf_pair<FromEncoding, ToEncoding>(), v, s);
+    }
+
+    template <class FromEncoding, class ToEncoding, class View, class String,
+      class T, class ... Pack>
+    inline void recode_to_string(View v, String& s, const T& arg, const Pack& ... args)
+    {
+      recode_untraced<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
+        std::back_inserter(s), arg, args ...);
+    }
+
+    template <class FromEncoding, class ToEncoding, class String, class View,
+      class ... T>
+    String traced_to_string(conversion_observer* observer, View v, const T& ... args)
+    {
+      trace_scope trace(observer, conversion::to_string,
+        encoding_name(FromEncoding()), encoding_name(ToEncoding()),
+        v.size() * sizeof(typename View::value_type));
+      String tmp;
+      recode_to_string<FromEncoding, ToEncoding>(v, tmp, args ...);
+      trace.finish(tmp.size() * sizeof(typename ToEncoding::value_type));
+      return tmp;
+    }
+
+    template <class FromEncoding, class ToEncoding,
+      class String = std::basic_string<typename ToEncoding::value_type>,
+      class View, class ... T> inline
+    String convert_to_string(View v, const T& ... args)
+    {
+      if (conversion_observer* observer = get_conversion_observer())
+        return traced_to_string<FromEncoding, ToEncoding, String>(observer, v, args ...);
+      String tmp;
+      recode_to_string<FromEncoding, ToEncoding>(v, tmp, args ...);
+      return tmp;
+    }
   }
  
   template <class ToEncoding, class ...Pack> inline
@@ -212,10 +353,7 @@ namespace unicode
       || detail::ccvt_count<Pack...>() == 2,
       narrow, utf8>::type;
 
-    std::basic_string<typename ToEncoding::value_type> tmp;
-    recode<FromEncoding, ToEncoding>(v.cbegin(), v.cend(),
-      std::back_inserter(tmp), args...);
-    return tmp;
+    return detail::convert_to_string<FromEncoding, ToEncoding>(v, args ...);
   }
 
   template <class ToEncoding, class ...Pack> inline
@@ -231,10 +369,7 @@ namespace unicode
           "Multiple ccvt_type arguments are not allowed");
     static_assert(std::is_same<ToEncoding, narrow>::value
       || detail::ccvt_count<Pack...>() == 0, "A ccvt_type argument is not allowed");
-    std::basic_string<typename ToEncoding::value_type> tmp;
-    recode<utf16, ToEncoding>(v.cbegin(), v.cend(),
-      std::back_inserter(tmp), args ...);
-    return tmp;
+    return detail::convert_to_string<utf16, ToEncoding>(v, args ...);
   }
 
   template <class ToEncoding, class ...Pack> inline
@@ -250,10 +385,7 @@ namespace unicode
           "Multiple ccvt_type arguments are not allowed");
     static_assert(std::is_same<ToEncoding, narrow>::value
       || detail::ccvt_count<Pack...>() == 0, "A ccvt_type argument is not allowed");
-    std::basic_string<typename ToEncoding::value_type> tmp;
-    recode<utf32, ToEncoding>(v.cbegin(), v.cend(),
-      std::back_inserter(tmp), args ...);
-    return tmp;
+    return detail::convert_to_string<utf32, ToEncoding>(v, args ...);
   }
 
   template <class ToEncoding, class ...Pack> inline
@@ -269,10 +401,7 @@ namespace unicode
           "Multiple ccvt_type arguments are not allowed");
     static_assert(std::is_same<ToEncoding, narrow>::value
       || detail::ccvt_count<Pack...>() == 0, "A ccvt_type argument is not allowed");
-    std::basic_string<typename ToEncoding::value_type> tmp;
-    recode<wide, ToEncoding>(v.cbegin(), v.cend(),
-      std::back_inserter(tmp), args ...);
-    return tmp;
+    return detail::convert_to_string<wide, ToEncoding>(v, args ...);
   }
 
   namespace detail
@@ -280,21 +409,99 @@ namespace unicode
     // forward declare the functions needed to implement recode_utf_to_utf -------------//
 
     template <class ToCharT, class InputIterator, class OutputIterator,
-      class U32Error, class OutError> inline
+      class U32Error, class OutError> inline BOOST_CXX14_CONSTEXPR
       OutputIterator utf8_to_char32_t(InputIterator first, InputIterator last,
         OutputIterator result, U32Error u32_eh, OutError out_eh);
     template <class ToCharT, class InputIterator, class OutputIterator,
-      class U32Error, class OutError> inline
+      class U32Error, class OutError> inline BOOST_CXX14_CONSTEXPR
       OutputIterator utf16_to_char32_t(InputIterator first, InputIterator last,
         OutputIterator result, U32Error u32_eh, OutError out_eh);
-    template <class ToCharT, class OutputIterator, class Error> inline
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
       OutputIterator char32_t_to_utf8(char32_t u32, OutputIterator result, Error eh);
-    template <class ToCharT, class OutputIterator, class OutError> inline
+    template <class ToCharT, class OutputIterator, class OutError>
+      inline BOOST_CXX14_CONSTEXPR
       OutputIterator char32_t_to_utf16(char32_t u32, OutputIterator result,
         OutError out_eh);
-    template <class ToCharT, class OutputIterator, class OutError> inline
+    template <class ToCharT, class OutputIterator, class OutError>
+      inline BOOST_CXX14_CONSTEXPR
       OutputIterator char32_t_to_utf32(char32_t u32, OutputIterator result,
         OutError out_eh);
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf8(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf16(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf16(const char32_t* first, const char32_t* last,
+        OutputIterator result, Error eh);
+# if WCHAR_MAX >= 0x1FFFFFFFu
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf16(const wchar_t* first, const wchar_t* last,
+        OutputIterator result, Error eh);
+# endif
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf8_to_utf32(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf32(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf8_to_utf32(const char* first, const char* last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf32(const char16_t* first, const char16_t* last,
+        OutputIterator result, Error eh);
+# if WCHAR_MAX >= 0x1FFFu && WCHAR_MAX < 0x1FFFFFFFu
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf32(const wchar_t* first, const wchar_t* last,
+        OutputIterator result, Error eh);
+# endif
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf8_to_utf8(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf16(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf32(InputIterator first, InputIterator last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf8_to_utf8(const char* first, const char* last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf16(const char16_t* first, const char16_t* last,
+        OutputIterator result, Error eh);
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf32(const char32_t* first, const char32_t* last,
+        OutputIterator result, Error eh);
+# if WCHAR_MAX >= 0x1FFFFFFFu
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf32_to_utf32(const wchar_t* first, const wchar_t* last,
+        OutputIterator result, Error eh);
+# elif WCHAR_MAX >= 0x1FFFu
+    template <class ToCharT, class OutputIterator, class Error>
+      inline BOOST_CXX14_CONSTEXPR
+      OutputIterator utf16_to_utf16(const wchar_t* first, const wchar_t* last,
+        OutputIterator result, Error eh);
+# endif
     
     //----------------------------------------------------------------------------------//
     //                      recode_utf_to_utf implementation                            //
@@ -305,7 +512,10 @@ namespace unicode
     //  we need a value that can never appear in valid utf32 to pass the error through
     //  to the final output type and there be detected as an error and then processed
     //  by the appropriate error handler for that output type.
-    struct u32_err_pass_thru { const char32_t* operator()() const { return U"\x110000"; } };
+    struct u32_err_pass_thru
+    {
+      constexpr const char32_t* operator()() const noexcept { return U"\x110000"; }
+    };
 
 # if WCHAR_MAX >= 0x1FFFFFFFu
 #   define BOOST_UNICODE_WIDE_UTF utf32
@@ -318,17 +528,17 @@ namespace unicode
     // from utf8 -----------------------------------------------------------------------//
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char>> inline
+      class Error = ufffd<char>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf8 /*from*/, utf8 /*to*/,
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      // pass input sequence through UTF-32 conversion to ensure the
-      // output sequence is valid even if the input sequence isn't valid
-      return utf8_to_char32_t<char>(first, last, result, u32_err_pass_thru(), eh);
+      return utf8_to_utf8<char>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char16_t>> inline
+      class Error = ufffd<char16_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf8, utf16,
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -338,25 +548,34 @@ namespace unicode
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char32_t>> inline
+      class Error = ufffd<char32_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf8, utf32,
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      return utf8_to_char32_t<char32_t>(first, last, result, u32_err_pass_thru(), eh);
+      return utf8_to_utf32<char32_t>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<wchar_t>> inline
+      class Error = ufffd<wchar_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf8, wide,
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
+#   if WCHAR_MAX >= 0x1FFFFFFFu
+      return utf8_to_utf32<wchar_t>(first, last, result, eh);
+#   elif WCHAR_MAX >= 0x1FFFu
       return utf8_to_char32_t<wchar_t>(first, last, result, u32_err_pass_thru(), eh);
+#   else
+      return utf8_to_utf8<wchar_t>(first, last, result, eh);
+#   endif
     }
 
     // from utf16 ----------------------------------------------------------------------//
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char>> inline
+      class Error = ufffd<char>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf16, utf8,
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -366,91 +585,87 @@ namespace unicode
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char16_t>> inline
+      class Error = ufffd<char16_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf16, utf16, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      // pass input sequence through UTF-32 conversion to ensure the
-      // output sequence is valid even if the input sequence isn't valid
-      return utf16_to_char32_t<char16_t>(first, last, result, u32_err_pass_thru(), eh);
+      return utf16_to_utf16<char16_t>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char32_t>> inline
+      class Error = ufffd<char32_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf16, utf32, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      return utf16_to_char32_t<char32_t>(first, last, result, u32_err_pass_thru(), eh);
+      return utf16_to_utf32<char32_t>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<wchar_t>> inline
+      class Error = ufffd<wchar_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf16, wide, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
+#   if WCHAR_MAX >= 0x1FFFFFFFu
+      return utf16_to_utf32<wchar_t>(first, last, result, eh);
+#   elif WCHAR_MAX >= 0x1FFFu
+      return utf16_to_utf16<wchar_t>(first, last, result, eh);
+#   else
       return utf16_to_char32_t<wchar_t>(first, last, result, u32_err_pass_thru(), eh);
+#   endif
     }
 
     // from utf32 ----------------------------------------------------------------------//
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char>> inline
+      class Error = ufffd<char>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf32, utf8, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      for (; first != last; ++first)
-      {
-        result = char32_t_to_utf8<char>(static_cast<char32_t>(*first), result, eh);
-      }
-      return result;
+      return utf32_to_utf8<char>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char16_t>> inline
+      class Error = ufffd<char16_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf32, utf16, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      for (; first != last; ++first)
-      {
-        result = char32_t_to_utf16<char16_t>(static_cast<char32_t>(*first), result, eh);
-      }
-      return result;
+      return utf32_to_utf16<char16_t>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char32_t>> inline
+      class Error = ufffd<char32_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf32, utf32, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      for (; first != last; ++first)
-      {
-        result = char32_t_to_utf32<char32_t>(static_cast<char32_t>(*first), result, eh);
-      }
-      return result;
+      return utf32_to_utf32<char32_t>(first, last, result, eh);
     }
 
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<wchar_t>> inline
+      class Error = ufffd<wchar_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(utf32, wide, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
-      for (; first != last; ++first)
-      {
-#       if WCHAR_MAX >= 0x1FFFFFFFu
-        result = char32_t_to_utf32<wchar_t>(static_cast<char32_t>(*first), result, eh);
-#       elif WCHAR_MAX >= 0x1FFFu
-        result = char32_t_to_utf16<wchar_t>(static_cast<char32_t>(*first), result, eh);
-#       else
-        result = char32_t_to_utf8<wchar_t>(static_cast<char32_t>(*first), result, eh);
-#       endif
-      }
-      return result;
+#   if WCHAR_MAX >= 0x1FFFFFFFu
+      return utf32_to_utf32<wchar_t>(first, last, result, eh);
+#   elif WCHAR_MAX >= 0x1FFFu
+      return utf32_to_utf16<wchar_t>(first, last, result, eh);
+#   else
+      return utf32_to_utf8<wchar_t>(first, last, result, eh);
+#   endif
     }
 
     // from wide -----------------------------------------------------------------------//
  
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char>> inline
+      class Error = ufffd<char>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(wide, utf8, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -458,7 +673,8 @@ namespace unicode
     }
  
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char16_t>> inline
+      class Error = ufffd<char16_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(wide, utf16, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -466,7 +682,8 @@ namespace unicode
     }
  
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<char32_t>> inline
+      class Error = ufffd<char32_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(wide, utf32, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -474,7 +691,8 @@ namespace unicode
     }
  
     template <class InputIterator, class OutputIterator,
-      class Error = ufffd<wchar_t>> inline
+      class Error = ufffd<wchar_t>>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_utf_to_utf(wide, wide, 
       InputIterator first, InputIterator last, OutputIterator result, Error eh = Error())
     {
@@ -493,6 +711,10 @@ namespace unicode
       OutputIterator codecvt_utf_to_narrow(const FromCharT* from,
         const FromCharT* from_end, OutputIterator result,
         const std::codecvt<FromCharT, char, std::mbstate_t>& ccvt, Error eh);
+    template <class FromCharT, class OutputIterator, class Error> inline
+      OutputIterator codecvt_well_formed_to_narrow(const FromCharT* first,
+        const FromCharT* last, OutputIterator result,
+        const std::codecvt<FromCharT, char, std::mbstate_t>& ccvt, Error eh);
 
     template <class CharT> struct utf_encoding;
     template<> struct utf_encoding<char>     { using tag = utf8; };
@@ -537,21 +759,27 @@ namespace unicode
     struct wide_err_pass_thru {const wchar_t* operator()() const {return L"\xED\B0\80";}};
 # endif
 
-    // TODO: Both functions should have a second overload to deal with case of the utf
-    // already being wide, so no need to converting to an intermediary wstring.
+    // TODO: recode_narrow_to_utf should have a second overload to deal with case of the
+    // utf already being wide, so no need to converting to an intermediary wstring.
 
     // recode_utf_to_narrow
-    template <class InputIterator, class OutputIterator, class Codecvt,
-      class Error = ufffd<char>> inline
-    OutputIterator recode_utf_to_narrow(InputIterator first, InputIterator last,
-      OutputIterator result, const Codecvt& ccvt, Error eh = Error())
+
+    //  contiguous input already of the codecvt's intern_type
+    template <class InputIterator, class OutputIterator, class Codecvt, class Error>
+    inline OutputIterator utf_to_narrow(InputIterator first, InputIterator last,
+      OutputIterator result, const Codecvt& ccvt, Error eh, std::true_type)
+    {
+      return codecvt_well_formed_to_narrow(first, last, result, ccvt, eh);
+    }
+
+    //  any other input, via an intermediary string of the codecvt's intern_type
+    template <class InputIterator, class OutputIterator, class Codecvt, class Error>
+    inline OutputIterator utf_to_narrow(InputIterator first, InputIterator last,
+      OutputIterator result, const Codecvt& ccvt, Error eh, std::false_type)
     {
-      static_assert(is_ccvt<Codecvt>(),
-        "fourth argument must be type std::codecvt<wchar_t, char, std::mbstate_t>"
-        " or type std::codecvt<char32_t, char, std::mbstate_t>");
       using intermediate_type = typename Codecvt::intern_type;
       std::basic_string<intermediate_type> tmp;
-      recode<typename 
+      recode_untraced<typename 
         utf_encoding<typename std::iterator_traits<InputIterator>::value_type>::tag,
         typename utf_encoding<intermediate_type>::tag>
         (first, last, std::back_inserter(tmp), wide_err_pass_thru());
@@ -559,6 +787,20 @@ namespace unicode
         ccvt, eh);
     }
 
+    template <class InputIterator, class OutputIterator, class Codecvt,
+      class Error = ufffd<char>> inline
+    OutputIterator recode_utf_to_narrow(InputIterator first, InputIterator last,
+      OutputIterator result, const Codecvt& ccvt, Error eh = Error())
+    {
+      static_assert(is_ccvt<Codecvt>(),
+        "fourth argument must be type std::codecvt<wchar_t, char, std::mbstate_t>"
+        " or type std::codecvt<char32_t, char, std::mbstate_t>");
+      using from_type = typename std::iterator_traits<InputIterator>::value_type;
+      return utf_to_narrow(first, last, result, ccvt, eh,
+        std::integral_constant<bool, std::is_pointer<InputIterator>::value
+          && std::is_same<from_type, typename Codecvt::intern_type>::value>());
+    }
+
     // recode_narrow_to_utf
     template <class ToEncoding, class InputIterator, class OutputIterator,
       class Codecvt,
@@ -573,7 +815,7 @@ namespace unicode
       std::basic_string<intermediate_type> tmp;
       codecvt_narrow_to_utf(first, last, std::back_inserter(tmp), ccvt,
         wide_err_pass_thru());
-      return recode<typename encoding<intermediate_type>::type,
+      return recode_untraced<typename encoding<intermediate_type>::type,
         ToEncoding>(tmp.cbegin(), tmp.cend(), result, eh);
     }
 
@@ -608,7 +850,8 @@ namespace unicode
     struct narrow_tag {};
 
     template <class FromEncoding, class ToEncoding,
-      class InputIterator, class OutputIterator, class ... T> inline
+      class InputIterator, class OutputIterator, class ... T>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator recode_dispatch(utf_tag, utf_tag, InputIterator first,
         InputIterator last, OutputIterator result, const T& ... args)
     {
@@ -654,12 +897,40 @@ namespace unicode
     template<> struct dispatch<utf32>  { using tag = utf_tag; };
     template<> struct dispatch<wide>   { using tag = utf_tag; };
 
+    template <class FromEncoding, class ToEncoding,
+      class InputIterator, class OutputIterator, class ... T>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator recode_untraced(InputIterator first, InputIterator last,
+      OutputIterator result, const T& ... args)
+    {
+      return recode_dispatch<FromEncoding, ToEncoding>(
+        typename dispatch<FromEncoding>::tag(),
+        typename dispatch<ToEncoding>::tag(),
+        first, last, result, args ...);
+    }
+
+    //  kept out of line from recode() so that the untraced path stays small
+    template <class FromEncoding, class ToEncoding,
+      class InputIterator, class OutputIterator, class ... T>
+    OutputIterator traced_recode(conversion_observer* observer, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+    {
+      trace_scope trace(observer, conversion::recode,
+        encoding_name(FromEncoding()), encoding_name(ToEncoding()),
+        byte_distance<typename FromEncoding::value_type>(first, last));
+      OutputIterator end
+        = recode_untraced<FromEncoding, ToEncoding>(first, last, result, args ...);
+      trace.finish(byte_distance<typename ToEncoding::value_type>(result, end));
+      return end;
+    }
+
   }  // namespace detail
 
   //------------------------------ recode definition -----------------------------------//
 
   template <class FromEncoding, class ToEncoding,
-    class InputIterator, class OutputIterator, class ... T> inline
+    class InputIterator, class OutputIterator, class ... T>
+  inline BOOST_CXX14_CONSTEXPR
   OutputIterator recode(InputIterator first, InputIterator last, OutputIterator result,  
     const T& ... args)
   {
@@ -667,10 +938,12 @@ namespace unicode
       "FromEncoding must be utf8, utf16, utf32, narrow, or wide");
     static_assert(is_encoding<ToEncoding>::value,
       "ToEncoding must be utf8, utf16, utf32, narrow, or wide");
-    return detail::recode_dispatch<FromEncoding, ToEncoding>(
-      typename detail::dispatch<FromEncoding>::tag(),
-      typename detail::dispatch<ToEncoding>::tag(),
-      first, last, result, args ...);
+    if (!detail::in_constant_evaluation())
+      if (conversion_observer* observer = get_conversion_observer())
+        return detail::traced_recode<FromEncoding, ToEncoding>(observer, first, last,
+          result, args ...);
+    return detail::recode_untraced<FromEncoding, ToEncoding>(first, last, result,
+      args ...);
   }
 
   namespace detail
@@ -685,22 +958,44 @@ namespace unicode
     //  char32_t outputers; these helpers take a single char32_t code point, and output as
     //  many code units as needed to represent the code point. OutputT may be wchar_t for
     //  one of the overloads; which one depends on the platform.
-    template <class ToCharT, class OutputIterator, class Error> inline
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator u32_outputer(utf32, char32_t x, OutputIterator result, Error eh)
     {
       return char32_t_to_utf32<ToCharT>(x, result, eh);
     }
-    template <class ToCharT, class OutputIterator, class Error> inline
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator u32_outputer(utf16, char32_t x, OutputIterator result, Error eh)
     {
       return char32_t_to_utf16<ToCharT>(x, result, eh);
     }
-    template <class ToCharT, class OutputIterator, class Error> inline
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator u32_outputer(utf8, char32_t x, OutputIterator result, Error eh)
     {
       return char32_t_to_utf8<ToCharT>(x, result, eh);
     }
 
+    //  instrumentation for the encoders below; see instrumentation.hpp
+    template <class ToCharT>
+    inline BOOST_CXX14_CONSTEXPR
+    void count_encoded(std::size_t units) BOOST_NOEXCEPT
+    {
+      BOOST_UNICODE_COUNT(code_points, 1);
+      BOOST_UNICODE_COUNT(bytes_out, units * sizeof(ToCharT));
+    }
+
+    //  U+110000 is the marker u32_err_pass_thru sends on for an error the decoder has
+    //  already counted
+    inline BOOST_CXX14_CONSTEXPR void count_u32_error(char32_t u32) BOOST_NOEXCEPT
+    {
+      if (u32 >= 0xD800u && u32 <= 0xDFFFu)
+        BOOST_UNICODE_COUNT(surrogate, 1);
+      else if (u32 != 0x110000u)
+        BOOST_UNICODE_COUNT(out_of_range, 1);
+    }
+
 //--------------------------------------------------------------------------------------//
 //  Algorithms for converting UTF-8 and UTF-16 to and from a single UTF-32 encoded      //
 //  char32_t; these can then be composed into complete conversion functions without     //
@@ -709,26 +1004,35 @@ namespace unicode
 //--------------------------------------------------------------------------------------//
  
     template <class ToCharT, class OutputIterator, class Error>
-    inline
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator char32_t_to_utf8(char32_t u32, OutputIterator result, Error eh)
     {
       if (u32 <= 0x007Fu)
+      {
         *result++ = static_cast<ToCharT>(u32);
+        count_encoded<ToCharT>(1);
+      }
       else if (u32 <= 0x07FFu)
       {
         *result++ = static_cast<ToCharT>(0xC0u + (u32 >> 6));
         *result++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+        count_encoded<ToCharT>(2);
       }
       else if (u32 >= 0xD800u && u32 <= 0xDFFFu)  // surrogates are ill-formed
       {
+        count_u32_error(u32);
         for (const char* rep = eh(); *rep; ++rep)
+        {
           *result++ = *rep;
+          BOOST_UNICODE_COUNT(bytes_out, sizeof(ToCharT));
+        }
       }
       else if (u32 <= 0xFFFFu)
       {
         *result++ = static_cast<ToCharT>(0xE0u + (u32 >> 12));
         *result++ = static_cast<ToCharT>(0x80u + ((u32 >> 6) & 0x3Fu));
         *result++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+        count_encoded<ToCharT>(3);
       }
       else if (u32 <= 0x10FFFFu)
       {
@@ -736,23 +1040,29 @@ namespace unicode
         *result++ = static_cast<ToCharT>(0x80u + ((u32 >> 12) & 0x3Fu));
         *result++ = static_cast<ToCharT>(0x80u + ((u32 >> 6) & 0x3Fu));
         *result++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+        count_encoded<ToCharT>(4);
       }
       else  // invalid code point
       {
+        count_u32_error(u32);
         for (auto rep = eh(); *rep; ++rep)
+        {
           *result++ = *rep;
+          BOOST_UNICODE_COUNT(bytes_out, sizeof(ToCharT));
+        }
       }
       return result;
     }
 
     template <class ToCharT, class OutputIterator, class OutError>
-    inline
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator char32_t_to_utf16(char32_t u32, OutputIterator result,
       OutError out_eh)
     {
       if (u32 < 0xD800u || (u32 >= 0xE000u && u32 <=0xFFFFu))  // valid code point in BMP
       {
         *result++ = static_cast<ToCharT>(u32);  
+        count_encoded<ToCharT>(1);
       }
       else if (u32 >= 0x10000u && u32 <= 0x10FFFFu) // valid code point needing surrogate pair
       {
@@ -760,32 +1070,175 @@ namespace unicode
           + static_cast<ToCharT>(u32 >> 10));
         *result++ = static_cast<ToCharT>(low_surrogate_base
           + static_cast<ToCharT>(u32 & ten_bit_mask));
+        count_encoded<ToCharT>(2);
       }
       else  // invalid code point
       {
+        count_u32_error(u32);
         for (auto itr = out_eh(); *itr; ++itr)
+        {
           *result++ = *itr;
+          BOOST_UNICODE_COUNT(bytes_out, sizeof(ToCharT));
+        }
       }
       return result;
     }
 
     template <class ToCharT, class OutputIterator, class OutError>
-    inline
+    inline BOOST_CXX14_CONSTEXPR
     OutputIterator char32_t_to_utf32(char32_t u32, OutputIterator result,
       OutError out_eh)
     {
       if (u32 < 0xD800u || (u32 >= 0xE000u && u32 <= 0x10FFFFu))  // valid code point
       {
         *result++ = static_cast<ToCharT>(u32);  
+        count_encoded<ToCharT>(1);
       }
       else  // invalid code point
       {
+        count_u32_error(u32);
         for (auto itr = out_eh(); *itr; ++itr)
+        {
           *result++ = *itr;
+          BOOST_UNICODE_COUNT(bytes_out, sizeof(ToCharT));
+        }
+      }
+      return result;
+    }
+
+    //  UTF-32 encoders  ---------------------------------------------------------------//
+
+    //  Contiguous UTF-32 input bound for UTF-16 is taken sixteen code points at a time
+    //  where SSE2 is available. One pass over a block finds whether all are valid and,
+    //  from their bitwise or, the widest. All-BMP blocks become UTF-16 by vector packs,
+    //  and other valid blocks need no per code point error tests. Blocks with an
+    //  ill-formed code point, and any final partial block, go to the code point at a
+    //  time encoder. UTF-8 output is always a code point at a time; packing all-ASCII
+    //  blocks was no faster on the whole than the well-predicted scalar encoder.
+
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf8_scalar(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      for (; first != last; ++first)
+      {
+        BOOST_UNICODE_COUNT(bytes_in, 4);
+        result = char32_t_to_utf8<ToCharT>(static_cast<char32_t>(*first), result, eh);
       }
       return result;
     }
 
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf16_scalar(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      for (; first != last; ++first)
+      {
+        BOOST_UNICODE_COUNT(bytes_in, 4);
+        result = char32_t_to_utf16<ToCharT>(static_cast<char32_t>(*first), result, eh);
+      }
+      return result;
+    }
+
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf8(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      return utf32_to_utf8_scalar<ToCharT>(first, last, result, eh);
+    }
+
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf16(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      return utf32_to_utf16_scalar<ToCharT>(first, last, result, eh);
+    }
+
+# if defined(BOOST_UNICODE_SSE2)
+
+    template <class ToCharT, class U32CharT, class OutputIterator, class Error>
+    inline OutputIterator utf32_blocks_to_utf16(const U32CharT* first,
+      const U32CharT* last, OutputIterator result, Error eh)
+    {
+      for (; static_cast<std::size_t>(last - first) >= sse2_block_size;
+        first += sse2_block_size)
+      {
+        char32_t bits = sse2_utf32_block_bits(first);
+        if (bits > 0x10FFFFu)
+        {
+          BOOST_UNICODE_COUNT(slow_path_blocks, 1);
+          result = utf32_to_utf16_scalar<ToCharT>(first, first + sse2_block_size,
+            result, eh);
+          continue;
+        }
+        BOOST_UNICODE_COUNT(fast_path_blocks, 1);
+        BOOST_UNICODE_COUNT(bytes_in, 4 * sse2_block_size);
+        BOOST_UNICODE_COUNT(code_points, sse2_block_size);
+
+        if (bits < 0x10000u)  // all in the BMP, so one code unit each
+        {
+          BOOST_UNICODE_COUNT(bytes_out, sse2_block_size * sizeof(ToCharT));
+          std::uint16_t units[sse2_block_size];
+          sse2_utf32_to_utf16(first, units);
+          for (std::uint16_t unit : units)
+            *result++ = static_cast<ToCharT>(unit);
+        }
+        else
+        {
+          for (std::size_t i = 0; i < sse2_block_size; ++i)
+          {
+            char32_t u32 = static_cast<char32_t>(first[i]);
+            if (u32 < 0x10000u)
+            {
+              BOOST_UNICODE_COUNT(bytes_out, sizeof(ToCharT));
+              *result++ = static_cast<ToCharT>(u32);
+            }
+            else
+            {
+              BOOST_UNICODE_COUNT(bytes_out, 2 * sizeof(ToCharT));
+              *result++ = static_cast<ToCharT>(high_surrogate_base + (u32 >> 10));
+              *result++ = static_cast<ToCharT>(low_surrogate_base + (u32 & ten_bit_mask));
+            }
+          }
+        }
+      }
+      BOOST_UNICODE_COUNT(slow_path_blocks, first != last);
+      return utf32_to_utf16_scalar<ToCharT>(first, last, result, eh);
+    }
+
+#   define BOOST_UNICODE_UTF32_BLOCKS(encoder) \
+      if (!in_constant_evaluation()) \
+        return utf32_blocks_to_##encoder<ToCharT>(first, last, result, eh);
+# else
+#   define BOOST_UNICODE_UTF32_BLOCKS(encoder)
+# endif  // BOOST_UNICODE_SSE2
+
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf16(const char32_t* first, const char32_t* last,
+      OutputIterator result, Error eh)
+    {
+      BOOST_UNICODE_UTF32_BLOCKS(utf16)
+      return utf32_to_utf16_scalar<ToCharT>(first, last, result, eh);
+    }
+
+# if WCHAR_MAX >= 0x1FFFFFFFu
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf32_to_utf16(const wchar_t* first, const wchar_t* last,
+      OutputIterator result, Error eh)
+    {
+      BOOST_UNICODE_UTF32_BLOCKS(utf16)
+      return utf32_to_utf16_scalar<ToCharT>(first, last, result, eh);
+    }
+# endif
+
+# undef BOOST_UNICODE_UTF32_BLOCKS
+
     //  table3
     //
     //  Based on ISO/IEC 10646:2014 9.2 Table 3, Well-formed UTF-8 Octet sequences
@@ -822,257 +1275,543 @@ namespace unicode
       0x03u,   // 0xF1
       0x03u,   // 0xF2
       0x03u,   // 0xF3
-      0x03u,   // 0xF4
+      0x33u,   // 0xF4  80-8F    (i.e. > U+10FFFF is invalid)
     };
 
-    template <class ToCharT, class InputIterator, class OutputIterator,
-      class U32Error, class OutError>
-    inline
-    OutputIterator utf8_to_char32_t(InputIterator first, InputIterator last,
-      OutputIterator result, U32Error u32_eh, OutError out_eh)
+    //  utf8_decode
+    //
+    //  Decodes the code point beginning at first, advancing first past it. Returns true
+    //  if the sequence is well-formed, otherwise false and first has been advanced past
+    //  the ill-formed sequence. Requires: first != last.
+    //
+    //  This is the single definition of the UTF-8 decoding rules; utf8_to_char32_t and
+    //  the UTF-8 queries are built on it so that they always agree. The backend is
+    //  utf8_decode_branchy, or utf8_dfa_decode if BOOST_UNICODE_UTF8_DFA is defined; the
+    //  two split ill-formed input identically.
+
+    template <class InputIterator>
+    inline BOOST_CXX14_CONSTEXPR
+    bool utf8_decode_branchy(InputIterator& first, InputIterator last, char32_t& u32)
     {
-      using encoding_tag = utf_encoding<ToCharT>::tag;
+      u32 = static_cast<unsigned char>(*first++);
 
-      for (; first != last;)
+      if (u32 <= 0x7Fu)  // 7-bit ASCII
       {
-        char32_t u32 = static_cast<unsigned char>(*first++);
+        BOOST_UNICODE_COUNT(bytes_in, 1);
+        return true;     // by definition, 7-bit ASCII is valid UTF-8
+      }
 
-        if (u32 <= 0x7Fu)  // 7-bit ASCII
-        {
-          //  by definition, 7-bit ASCII is valid UTF-8, so bypass further checking
-          result = u32_outputer<ToCharT>(encoding_tag(), u32, result, out_eh);
-          continue;
-        }
+      int octets = 1;
+      int continues = 0;
+      char32_t minimum = 0;  // smallest code point that needs this many octets
 
-        int continues = 0;
-        bool overlong = false;
+      if ((u32 & 0xE0u) == 0xC0u)    // 2 byte sequence
+      {
+        u32 &= 0x1Fu;
+        continues = 1;
+        minimum = 0x80u;
+      }
+      else if ((u32 & 0xF0u) == 0xE0u)  // 3 byte sequence
+      {
+        u32 &= 0x0Fu;
+        continues = 2;
+        minimum = 0x800u;
+      }
+      else if ((u32 & 0xF8u) == 0xF0u)  // 4 byte sequence
+      {
+        u32 &= 0x07u;
+        continues = 3;
+        minimum = 0x10000u;
+      }
+      else
+        continues = -1;  // flag as error
+
+      //  process the continuation bytes
+      //    requirement: increment past continuation bytes even if overlong 
+      for (; continues > 0
+        && first != last                                          // continuation byte
+        && (static_cast<unsigned char>(*first) & 0xC0u) == 0x80u; //   not missing
+        --continues)
+      {
+        u32 <<= 6;
+        u32 += static_cast<unsigned char>(*first++) & 0x3Fu;
+        ++octets;
+      }
+      BOOST_UNICODE_COUNT(bytes_in, octets);
+
+      if (continues < 0)                   // not a lead octet
+        BOOST_UNICODE_COUNT(invalid, 1);
+      else if (continues != 0)             // missing continuation
+        BOOST_UNICODE_COUNT(truncated, 1);
+      else if (u32 < minimum)              // overlong sequence
+        BOOST_UNICODE_COUNT(overlong, 1);
+      else if (u32 > 0x10FFFFu)            // out-of-range
+        BOOST_UNICODE_COUNT(out_of_range, 1);
+      else if (u32 >= 0xD800u && u32 <= 0xDFFFu)  // surrogate (ill-formed UTF-32)
+        BOOST_UNICODE_COUNT(surrogate, 1);
+      else
+        return true;
+      return false;
+    }
 
-        if ((u32 & 0xE0u) == 0xC0u)    // 2 byte sequence
-        {
-          u32 &= 0x1Fu;
-          continues = 1;
-          if ((u32 & 0xFEu) == 0xC0)   // overlong?
-            overlong = true;
-        }
-        else if ((u32 & 0xF0u) == 0xE0u)  // 3 byte sequence
-        {
-          u32 &= 0x0Fu;
-          continues = 2;
-          if (u32 == 0xE0u               
-            && first != last
-            && (static_cast<unsigned char>(*first) & 0xE0u) == 0x80u)  // overlong?
-            overlong = true;
-        }
-        else if ((u32 & 0xF8u) == 0xF0u)  // 4 byte sequence
-        {
-          u32 &= 0x07u;
-          continues = 3;
-          if (u32 == 0xF0u               
-            && first != last
-            && (static_cast<unsigned char>(*first) & 0xF0u) == 0x80u)  // overlong?
-            overlong = true;
-        }
-        else
-          continues = -1;  // flag as error
-
-        //  process the continuation bytes
-        //    requirement: increment past continuation bytes even if overlong 
-        for (; continues > 0
-          && first != last                                          // continuation byte
-          && (static_cast<unsigned char>(*first) & 0xC0u) == 0x80u; //   not missing
-          --continues)
-        {
-          u32 <<= 6;
-          u32 += static_cast<unsigned char>(*first++) & 0x3Fu;
-        }
+    template <class InputIterator>
+    inline BOOST_CXX14_CONSTEXPR
+    bool utf8_decode(InputIterator& first, InputIterator last, char32_t& u32)
+    {
+#   if defined(BOOST_UNICODE_UTF8_DFA)
+      return utf8_dfa_decode(first, last, u32);
+#   else
+      return utf8_decode_branchy(first, last, u32);
+#   endif
+    }
 
-        if (overlong                             // overlong sequence
-          || continues != 0                      // missing continuation
-          || u32 > 0x10FFFFu                     // out-of-range
-          || (u32 >= 0xD800u && u32 <= 0xDFFFu)  // surrogate (which is ill-formed UTF-32)
-          )
-        {
-          for (auto itr = u32_eh(); *itr; ++itr)
-            result = u32_outputer<ToCharT>(encoding_tag(), *itr, result, out_eh);
-        }
-        else
-          result = u32_outputer<ToCharT>(encoding_tag(), u32, result, out_eh);
+    //  utf16_decode
+    //
+    //  Same contract as utf8_decode, but for UTF-16.
+
+    template <class InputIterator>
+    inline BOOST_CXX14_CONSTEXPR
+    bool utf16_decode(InputIterator& first, InputIterator last, char32_t& u32)
+    {
+      char16_t c = *first++;
+
+      if (c < 0xD800 || c > 0xDFFF)  // not a surrogate
+      {
+        BOOST_UNICODE_COUNT(bytes_in, 2);
+        u32 = c; // BMP
+        return true;
       }
+      //  verify we have a valid surrogate pair
+      if (first != last
+        && (c & 0xFC00) == 0xD800        // 0xD800 to 0xDBFF aka low surrogate
+        && (*first & 0xFC00) == 0xDC00)  // 0xDC00 to 0xDFFF aka high surrogate
+      {
+        // combine the surrogate pair into a single UTF-32 code point
+        BOOST_UNICODE_COUNT(bytes_in, 4);
+        u32 = (static_cast<char32_t>(c) << 10) + *first++ - 0x35FDC00;
+        return true;
+      }
+      BOOST_UNICODE_COUNT(bytes_in, 2);
+      if ((c & 0xFC00) == 0xD800)
+        BOOST_UNICODE_COUNT(truncated, 1);  // high surrogate without its low surrogate
+      else
+        BOOST_UNICODE_COUNT(surrogate, 1);  // unpaired low surrogate
+      // invalid code point; no need to increment first again
+      // cases: c was high surrogate          action: do not increment first again
+      //        *first is not high surrogate  action: do not increment first again
+      //        first == last                 action: do not increment first again
+      return false;
+    }
+
+    //  outputs u32 if the decoder found it well-formed, otherwise the replacement
+    template <class ToCharT, class OutputIterator, class U32Error, class OutError>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator decoded_outputer(bool well_formed, char32_t u32, OutputIterator result,
+      U32Error u32_eh, OutError out_eh)
+    {
+      using encoding_tag = typename utf_encoding<ToCharT>::tag;
+
+      if (well_formed)
+        return u32_outputer<ToCharT>(encoding_tag(), u32, result, out_eh);
+      for (auto itr = u32_eh(); *itr; ++itr)
+        result = u32_outputer<ToCharT>(encoding_tag(), *itr, result, out_eh);
       return result;
     }
 
     template <class ToCharT, class InputIterator, class OutputIterator,
       class U32Error, class OutError>
-    inline
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf8_to_char32_t(InputIterator first, InputIterator last,
+      OutputIterator result, U32Error u32_eh, OutError out_eh)
+    {
+      for (; first != last;)
+      {
+        char32_t u32 = 0;
+        bool well_formed = utf8_decode(first, last, u32);
+        result = decoded_outputer<ToCharT>(well_formed, u32, result, u32_eh, out_eh);
+      }
+      return result;
+    }
+
+    template <class ToCharT, class InputIterator, class OutputIterator,
+      class U32Error, class OutError>
+    inline BOOST_CXX14_CONSTEXPR
       OutputIterator utf16_to_char32_t(InputIterator first, InputIterator last,
         OutputIterator result, U32Error u32_eh, OutError out_eh)
     {
-      using encoding_tag = utf_encoding<ToCharT>::tag;
-
       for (; first != last;)
       {
-        char32_t u32;
+        char32_t u32 = 0;
+        bool well_formed = utf16_decode(first, last, u32);
+        result = decoded_outputer<ToCharT>(well_formed, u32, result, u32_eh, out_eh);
+      }
+      return result;
+    }
 
-        char16_t c = *first++;
+    //  UTF-32 decoders  ---------------------------------------------------------------//
 
-        if (c < 0xD800 || c > 0xDFFF)  // not a surrogate
-        {
-          u32 = c; // BMP
-        }
-        //  verify we have a valid surrogate pair
-        else if (first != last
-          && (c & 0xFC00) == 0xD800        // 0xD800 to 0xDBFF aka low surrogate
-          && (*first & 0xFC00) == 0xDC00)  // 0xDC00 to 0xDFFF aka high surrogate
+    //  Contiguous UTF-8 and UTF-16 input is widened sixteen code units at a time where
+    //  SSE2 is available. ASCII octets, and UTF-16 code units that are not surrogates,
+    //  are each one code point and are output straight from the widened lanes. Every
+    //  other sequence goes to utf8_decode or utf16_decode, so ill-formed input is split
+    //  and replaced exactly as by utf8_to_char32_t or utf16_to_char32_t.
+    //
+    //  For UTF-8 only a leading run of ASCII blocks is widened. Mixing block tests with
+    //  decoding was slower on every corpus with non-ASCII text than utf8_to_char32_t
+    //  alone, so from the first block that is not all ASCII the rest of the input goes
+    //  to utf8_to_char32_t, called from utf8_to_utf32 itself so that utf8_decode is
+    //  still inlined into its loop.
+
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf8_to_utf32(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      return utf8_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    }
+
+    template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf16_to_utf32(InputIterator first, InputIterator last,
+      OutputIterator result, Error eh)
+    {
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    }
+
+# if defined(BOOST_UNICODE_SSE2)
+
+    //  outputs lanes [i, n) up to the first whose bit is set in mask
+    //  returns: the number output
+    template <class ToCharT, class OutputIterator>
+    inline std::size_t output_lanes(const std::uint32_t* lanes, unsigned mask,
+      std::size_t i, OutputIterator& result)
+    {
+      std::size_t start = i;
+      for (; i < sse2_block_size && !(mask & (1u << i)); ++i)
+        *result++ = static_cast<ToCharT>(lanes[i]);
+      BOOST_UNICODE_COUNT(code_points, i - start);
+      BOOST_UNICODE_COUNT(bytes_out, (i - start) * sizeof(ToCharT));
+      return i - start;
+    }
+
+    //  outputs the whole ASCII blocks at the start of [first, last)
+    //  returns: the end of them
+    template <class ToCharT, class OutputIterator>
+    inline const char* utf8_ascii_blocks_to_utf32(const char* first, const char* last,
+      OutputIterator& result)
+    {
+      std::uint32_t lanes[sse2_block_size];
+      for (; static_cast<std::size_t>(last - first) >= sse2_block_size
+        && sse2_widen_octets(first, lanes) == 0; first += sse2_block_size)
+      {
+        BOOST_UNICODE_COUNT(fast_path_blocks, 1);
+        BOOST_UNICODE_COUNT(bytes_in, sse2_block_size);
+        BOOST_UNICODE_COUNT(code_points, sse2_block_size);
+        BOOST_UNICODE_COUNT(bytes_out, sse2_block_size * sizeof(ToCharT));
+        for (std::uint32_t lane : lanes)
+          *result++ = static_cast<ToCharT>(lane);
+      }
+      BOOST_UNICODE_COUNT(slow_path_blocks, first != last);
+      return first;
+    }
+
+    template <class ToCharT, class U16CharT, class OutputIterator, class Error>
+    inline OutputIterator utf16_blocks_to_utf32(const U16CharT* first,
+      const U16CharT* last, OutputIterator result, Error eh)
+    {
+      std::uint32_t lanes[sse2_block_size];
+      while (static_cast<std::size_t>(last - first) >= sse2_block_size)
+      {
+        const U16CharT* block = first;
+        unsigned surrogates = sse2_widen_utf16(block, lanes);
+        if (surrogates == 0)
         {
-          // combine the surrogate pair into a single UTF-32 code point
-          u32 = (static_cast<char32_t>(c) << 10) + *first++ - 0x35FDC00;
+          BOOST_UNICODE_COUNT(fast_path_blocks, 1);
+          BOOST_UNICODE_COUNT(bytes_in, 2 * sse2_block_size);
+          BOOST_UNICODE_COUNT(code_points, sse2_block_size);
+          BOOST_UNICODE_COUNT(bytes_out, sse2_block_size * sizeof(ToCharT));
+          for (std::uint32_t lane : lanes)
+            *result++ = static_cast<ToCharT>(lane);
+          first += sse2_block_size;
+          continue;
         }
-        else  // invalid code point
+        BOOST_UNICODE_COUNT(slow_path_blocks, 1);
+
+        //  a surrogate pair may end past the block
+        while (static_cast<std::size_t>(first - block) < sse2_block_size)
         {
-          for (auto itr = u32_eh(); *itr; ++itr)
-            result = u32_outputer<ToCharT>(encoding_tag(), *itr, result, out_eh);
-          continue;  // no need to increment first; that has already been done above
-          // cases: c was high surrogate          action: do not increment first again
-          //        *first is not high surrogate  action: do not increment first again
-          //        first == last                 action: do not increment first again
+          std::size_t n = output_lanes<ToCharT>(lanes, surrogates,
+            static_cast<std::size_t>(first - block), result);
+          BOOST_UNICODE_COUNT(bytes_in, 2 * n);
+          first += n;
+          if (static_cast<std::size_t>(first - block) < sse2_block_size)
+          {
+            char32_t u32 = 0;
+            bool well_formed = utf16_decode(first, last, u32);
+            result = decoded_outputer<ToCharT>(well_formed, u32, result,
+              u32_err_pass_thru(), eh);
+          }
         }
-        result = u32_outputer<ToCharT>(encoding_tag(), u32, result, out_eh);
       }
-      return result;
+      BOOST_UNICODE_COUNT(slow_path_blocks, first != last);
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    }
+
+#   define BOOST_UNICODE_UTF32_BLOCKS(decoder) \
+      if (!in_constant_evaluation()) \
+        return decoder##_blocks_to_utf32<ToCharT>(first, last, result, eh);
+# else
+#   define BOOST_UNICODE_UTF32_BLOCKS(decoder)
+# endif  // BOOST_UNICODE_SSE2
+
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf8_to_utf32(const char* first, const char* last,
+      OutputIterator result, Error eh)
+    {
+#   if defined(BOOST_UNICODE_SSE2)
+      if (!in_constant_evaluation())
+        first = utf8_ascii_blocks_to_utf32<ToCharT>(first, last, result);
+#   endif
+      return utf8_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    }
+
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf16_to_utf32(const char16_t* first, const char16_t* last,
+      OutputIterator result, Error eh)
+    {
+      BOOST_UNICODE_UTF32_BLOCKS(utf16)
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    }
+
+# if WCHAR_MAX >= 0x1FFFu && WCHAR_MAX < 0x1FFFFFFFu
+    template <class ToCharT, class OutputIterator, class Error>
+    inline BOOST_CXX14_CONSTEXPR
+    OutputIterator utf16_to_utf32(const wchar_t* first, const wchar_t* last,
+      OutputIterator result, Error eh)
+    {
+      BOOST_UNICODE_UTF32_BLOCKS(utf16)
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
     }
+# endif
+
+# undef BOOST_UNICODE_UTF32_BLOCKS
 
 //--------------------------------------------------------------------------------------//
 //                     codecvt based recoding implementation                            //
 //--------------------------------------------------------------------------------------//
 
-  //  TODO: Both functions need to protect against buffer overflow caused by excessively
-  //  long error handler returned strings. But if the only use is for pass_thru that is
-  //  not strictly needed.
+  //  copy_code_units
+  //
+  //  Appends [first, last) to result. Appending to a string through a back_inserter is
+  //  the common case, and is done with one append() rather than a push_back() per
+  //  code unit. Code units of the same size, such as wchar_t and char32_t where wchar_t
+  //  is 32 bits, have the same representation and are copied as bytes.
 
-  //  TODO: Combine these functions into one. The are identical except for the
-  //  ccvt.in/ccvt.out call and the easy-to-parameterize from/to character types.
-
-  //  codecvt_utf_to_narrow
-  template <class FromCharT, class OutputIterator, class Error> inline
-    //  for clarity, use the same names for ccvt.in() arguments as the standard library
-    OutputIterator codecvt_utf_to_narrow(const FromCharT* from, const FromCharT* from_end,
-      OutputIterator result, const std::codecvt<FromCharT, char, std::mbstate_t>& ccvt,
-      Error eh)
+  template <class ToCharT, class CharT, class OutputIterator>
+  inline OutputIterator copy_code_units(const CharT* first, const CharT* last,
+    OutputIterator result)
   {
-    //static_assert(std::is_same<FromCharT, typename Codecvt::intern_type>::value,
-    //  "FromCharT and Codecvt::intern_type must be the same type");
-    //static_assert(std::is_same<ToCharT, typename Codecvt::extern_type>::value,
-    //  "ToCharT and Codecvt::extern_type must be the same type");
-    //static_assert(!std::is_same<FromCharT, ToCharT>::value,
-    //  "FromCharT and ToCharT must not be the same type");
-
-    std::array<char, BOOST_UNICODE_BUFFER_SIZE> buf;
-    std::mbstate_t mbstate  = std::mbstate_t();
-    const FromCharT* from_next;
-    std::codecvt_base::result ccvt_result = std::codecvt_base::ok;
+    for (; first != last; ++first)
+      *result++ = static_cast<ToCharT>(*first);
+    return result;
+  }
 
-    //  loop until the entire input sequence is processed by the codecvt facet 
+  template <class ToCharT, class CharT>
+  inline ToCharT* copy_code_units(const CharT* first, const CharT* last,
+    ToCharT* result)
+  {
+    if (sizeof(ToCharT) != sizeof(CharT))
+    {
+      for (; first != last; ++first)
+        *result++ = static_cast<ToCharT>(*first);
+      return result;
+    }
+    std::size_t n = static_cast<std::size_t>(last - first);
+    if (n != 0)
+      std::memcpy(result, first, n * sizeof(CharT));
+    return result + n;
+  }
 
-    while (from != from_end)
+  template <class Container>
+  struct back_insert_container : std::back_insert_iterator<Container>
+  {
+    //  container is a protected member, reachable only through a derived class
+    static Container& get(std::back_insert_iterator<Container>& itr) BOOST_NOEXCEPT
     {
-      char* to = buf.data();
-      char* to_end = to + buf.size();
-      char* to_next = to;
+      return *(itr.*&back_insert_container::container);
+    }
+  };
 
-      ccvt_result
-        = ccvt.out(mbstate, from, from_end, from_next, to, to_end, to_next);
+  template <class ToCharT, class CharT, class Traits, class Alloc>
+  inline std::back_insert_iterator<std::basic_string<ToCharT, Traits, Alloc>>
+    copy_code_units(const CharT* first, const CharT* last,
+      std::back_insert_iterator<std::basic_string<ToCharT, Traits, Alloc>> result)
+  {
+    std::basic_string<ToCharT, Traits, Alloc>& s
+      = back_insert_container<std::basic_string<ToCharT, Traits, Alloc>>::get(result);
+    if (sizeof(ToCharT) == sizeof(CharT))
+      s.append(reinterpret_cast<const ToCharT*>(first),
+        static_cast<std::size_t>(last - first));
+    else
+      s.append(first, last);
+    return result;
+  }
 
-      if (ccvt_result == std::codecvt_base::ok)
-      {
-        for (; to != to_next; ++to)
-          *result++ = *to;
-        from = from_next;
-      }
-      else if (ccvt_result == std::codecvt_base::error)
-      {
-        for (; to != to_next; ++to)
-          *result++ = *to;
-        for (auto it = eh(); *it != '\0'; ++it)
-          *result++ = *it;
-        from = from_next + 1;  // bypass error
-      }
-      else  // ccvt_result == std::codecvt_base::partial
-      {
-        if (to_next == buf.data())
-        {
-          for (auto it = eh(); *it != '\0'; ++it)
-            *result++ = *it;
-          from = from_end;
-        }
-        else
-        {
-          // eliminate the possibility that buf does not have enough room
-          for (; to != to_next; ++to)
-            *result++ = *to;
-          from = from_next;
-        }
-      }
+  //  codecvt_sink
+  //
+  //  The destination of each ccvt.in() or ccvt.out() call. A string appended to through
+  //  a back_inserter is converted into in place, room being made by resize() and the
+  //  unused part trimmed afterwards; any other output goes through a buffer.
+
+  template <class ToCharT, class OutputIterator>
+  class codecvt_sink
+  {
+  public:
+    explicit codecvt_sink(OutputIterator result) : result_(result) {}
+
+    ToCharT* begin(std::size_t) { return buf_.data(); }
+    ToCharT* end() { return buf_.data() + buf_.size(); }
+    void commit(ToCharT* to_next)
+      { result_ = copy_code_units<ToCharT>(buf_.data(), to_next, result_); }
+    OutputIterator& result() { return result_; }
+
+  private:
+    std::array<ToCharT, BOOST_UNICODE_BUFFER_SIZE> buf_;
+    OutputIterator result_;
+  };
+
+  template <class ToCharT, class Traits, class Alloc>
+  class codecvt_sink<ToCharT,
+    std::back_insert_iterator<std::basic_string<ToCharT, Traits, Alloc>>>
+  {
+    using string_type = std::basic_string<ToCharT, Traits, Alloc>;
+  public:
+    explicit codecvt_sink(std::back_insert_iterator<string_type> result)
+      : result_(result), s_(back_insert_container<string_type>::get(result_)) {}
+
+    ToCharT* begin(std::size_t room)
+    {
+      std::size_t used = s_.size();
+      s_.resize(used + room);
+      return &s_[0] + used;
     }
-    return result;
+    ToCharT* end() { return &s_[0] + s_.size(); }
+    void commit(ToCharT* to_next)
+      { s_.resize(static_cast<std::size_t>(to_next - &s_[0])); }
+    std::back_insert_iterator<string_type>& result() { return result_; }
+
+  private:
+    std::back_insert_iterator<string_type> result_;
+    string_type& s_;
+  };
+
+  struct codecvt_in {};
+  struct codecvt_out {};
+
+  template <class Codecvt, class FromCharT, class ToCharT> inline
+  std::codecvt_base::result codecvt_call(codecvt_in, const Codecvt& ccvt,
+    std::mbstate_t& state, const FromCharT* from, const FromCharT* from_end,
+    const FromCharT*& from_next, ToCharT* to, ToCharT* to_end, ToCharT*& to_next)
+  {
+    return ccvt.in(state, from, from_end, from_next, to, to_end, to_next);
   }
 
-  //  codecvt_narrow_to_utf
-  template <class OutputIterator, class Codecvt, class Error> inline
-    //  for clarity, use the same names for ccvt.in() arguments as the standard library
-  OutputIterator codecvt_narrow_to_utf(const char* from, const char* from_end,
-    OutputIterator result, const Codecvt& ccvt, Error eh)
+  template <class Codecvt, class FromCharT, class ToCharT> inline
+  std::codecvt_base::result codecvt_call(codecvt_out, const Codecvt& ccvt,
+    std::mbstate_t& state, const FromCharT* from, const FromCharT* from_end,
+    const FromCharT*& from_next, ToCharT* to, ToCharT* to_end, ToCharT*& to_next)
   {
-    using utf_type = typename Codecvt::intern_type;
+    return ccvt.out(state, from, from_end, from_next, to, to_end, to_next);
+  }
 
-    std::array<utf_type, BOOST_UNICODE_BUFFER_SIZE> buf;
+  //  codecvt_convert
+  //
+  //  Converts [from, from_end) with ccvt.in() or ccvt.out(), as Direction says, one
+  //  mbstate_t carried across the calls. ok and partial both resume at from_next, so a
+  //  sequence cut short for want of room is converted by the next call. error is
+  //  replaced by eh and the code unit at from_next skipped. partial that does nothing,
+  //  even given room for the longest sequence, means the input ends within a sequence,
+  //  and is replaced by eh once.
+  //
+  //  ccvt.in() never outputs more code units than it consumes, so the room offered is
+  //  the input remaining. ccvt.out() may output up to max_length() octets per code
+  //  unit, so room starts at the input remaining and is doubled, up to max_length()
+  //  times that, after each partial.
+
+  template <class Direction, class ToCharT, class FromCharT, class OutputIterator,
+    class Codecvt, class Error> inline
+  OutputIterator codecvt_convert(const FromCharT* from, const FromCharT* from_end,
+    OutputIterator result, const Codecvt& ccvt, Error eh)
+  {
+    codecvt_sink<ToCharT, OutputIterator> sink(result);
     std::mbstate_t mbstate  = std::mbstate_t();
-    const char* from_next;
-    std::codecvt_base::result ccvt_result = std::codecvt_base::ok;
-
-    //  loop until the entire input sequence is processed by the codecvt facet 
+    const std::size_t max_factor = std::is_same<Direction, codecvt_out>::value
+      ? static_cast<std::size_t>(ccvt.max_length() > 0 ? ccvt.max_length() : 1) : 1;
+    std::size_t factor = 1;
 
     while (from != from_end)
     {
-      utf_type* to = buf.data();
-      utf_type* to_end = to + buf.size();
-      utf_type* to_next = to;
-
-      ccvt_result
-        = ccvt.in(mbstate, from, from_end, from_next, to, to_end, to_next);
+      ToCharT* to = sink.begin(static_cast<std::size_t>(from_end - from) * factor);
+      ToCharT* to_end = sink.end();
+      ToCharT* to_next = to;
+      const FromCharT* from_next = from;
+
+      std::codecvt_base::result ccvt_result = codecvt_call(Direction(), ccvt, mbstate,
+        from, from_end, from_next, to, to_end, to_next);
+      BOOST_UNICODE_COUNT(codecvt_calls, 1);
+      BOOST_UNICODE_COUNT(bytes_in, (from_next - from) * sizeof(FromCharT));
+      BOOST_UNICODE_COUNT(bytes_out, (to_next - to) * sizeof(ToCharT));
+      sink.commit(to_next);
 
       if (ccvt_result == std::codecvt_base::ok)
-      {
-        for (; to != to_next; ++to)
-          *result++ = *to;
         from = from_next;
-      }
       else if (ccvt_result == std::codecvt_base::error)
       {
-        for (; to != to_next; ++to)
-          *result++ = *to;
+        BOOST_UNICODE_COUNT(invalid, 1);
         for (auto it = eh(); *it != '\0'; ++it)
-          *result++ = *it;
+          *sink.result()++ = *it;
         from = from_next + 1;  // bypass error
       }
-      else  // ccvt_result == std::codecvt_base::partial
+      else if (to_next != to || from_next != from)
       {
-        if (to_next == buf.data())
-        {
-          for (auto it = eh(); *it != '\0'; ++it)
-            *result++ = *it;
-          from = from_end;
-        }
-        else
-        {
-          // eliminate the possibility that buf does not have enough room
-          for (; to != to_next; ++to)
-            *result++ = *to;
-          from = from_next;
-        }
+        //  partial, for want of room or because the input ends within a sequence:
+        //  carry the rest over to the next call, with more room
+        factor = factor * 2 < max_factor ? factor * 2 : max_factor;
+        from = from_next;
+      }
+      else if (factor < max_factor)
+        factor = max_factor;  // partial with nothing done; retry with the most room
+      else  // partial with nothing done, given room for the longest sequence, or noconv
+      {
+        BOOST_UNICODE_COUNT(truncated, 1);
+        for (auto it = eh(); *it != '\0'; ++it)
+          *sink.result()++ = *it;
+        from = from_end;
       }
     }
-    return result;
+    return sink.result();
   }
+
+  //  codecvt_utf_to_narrow
+  template <class FromCharT, class OutputIterator, class Error> inline
+    OutputIterator codecvt_utf_to_narrow(const FromCharT* from, const FromCharT* from_end,
+      OutputIterator result, const std::codecvt<FromCharT, char, std::mbstate_t>& ccvt,
+      Error eh)
+  {
+    return codecvt_convert<codecvt_out, char>(from, from_end, result, ccvt, eh);
+  }
+
+  //  codecvt_narrow_to_utf
+  template <class OutputIterator, class Codecvt, class Error> inline
+  OutputIterator codecvt_narrow_to_utf(const char* from, const char* from_end,
+    OutputIterator result, const Codecvt& ccvt, Error eh)
+  {
+    return codecvt_convert<codecvt_in, typename Codecvt::intern_type>(from, from_end,
+      result, ccvt, eh);
+  }
+
   template <class T> struct is_known_encoding : public std::false_type {};
   template<> struct is_known_encoding<utf8>   : std::true_type {};
   template<> struct is_known_encoding<utf16>  : std::true_type {};
@@ -1083,7 +1822,7 @@ namespace unicode
   //template <class T> constexpr bool is_known_encoding_v = is_known_encoding<T>::value;
 
   template <class ForwardIterator>
-  std::pair<ForwardIterator, ForwardIterator>
+  BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
     first_ill_formed(ForwardIterator first, ForwardIterator last, utf32) BOOST_NOEXCEPT
   {
     for (; first != last; ++first)
@@ -1096,7 +1835,7 @@ namespace unicode
   }
 
   template <class ForwardIterator>
-  std::pair<ForwardIterator, ForwardIterator>
+  BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
     first_ill_formed(ForwardIterator first, ForwardIterator last, utf16) BOOST_NOEXCEPT
   {
     for (; first != last; ++first)
@@ -1105,20 +1844,25 @@ namespace unicode
       if (c >= 0xD800u && c < 0xE000u)  // surrogates must always be paired
       {
         auto first_code_unit = first;
+        if (c >= 0xDC00u)  // low surrogate without a high surrogate
+          return std::make_pair(first_code_unit, ++first);
         if (++first == last)
           return std::make_pair(first_code_unit, first);
-        else if ((c = static_cast<char16_t>(*first)) < 0xD800u || c > 0xDFFFu)
+        else if ((c = static_cast<char16_t>(*first)) < 0xDC00u || c > 0xDFFFu)
           return std::make_pair(first_code_unit, ++first);
       }
     }
     return std::make_pair(last, last);
   }
 
+  //  An error range begins with the first octet of an ill-formed sequence and runs
+  //  through any following octets that cannot begin a sequence.
   template <class ForwardIterator>
-  std::pair<ForwardIterator, ForwardIterator>
-    first_ill_formed(ForwardIterator first, ForwardIterator last, utf8) BOOST_NOEXCEPT
+  BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
+    utf8_first_ill_formed_branchy(ForwardIterator first, ForwardIterator last)
+    BOOST_NOEXCEPT
   {
-    ForwardIterator first_code_unit;
+    ForwardIterator first_code_unit = first;
 
     for (; first != last;) // each code point
     {
@@ -1132,7 +1876,10 @@ namespace unicode
       unsigned octet = static_cast<unsigned char>(*first++);
       
       if (octet <= 0x7Fu)
+      {
+        first = skip_ascii(first, last);
         continue;  // 7-bit ASCII so nothing further to do
+      }
 
       //  The sequence 'a', 0xE0, 'b' must treat 0xE0 as having a missing continuation
       //  octet (i.e. error range [1, 2)) rather than treating 'b' as an invalid
@@ -1195,6 +1942,269 @@ namespace unicode
     return std::make_pair(last, last);  // success
   }
 
+  template <class ForwardIterator>
+  inline BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
+    first_ill_formed(ForwardIterator first, ForwardIterator last, utf8) BOOST_NOEXCEPT
+  {
+#  if defined(BOOST_UNICODE_UTF8_DFA)
+    return utf8_dfa_first_ill_formed(first, last);
+#  else
+    return utf8_first_ill_formed_branchy(first, last);
+#  endif
+  }
+
+  //  UTF length queries  --------------------------------------------------------------//
+
+  //  Contiguous UTF-8 is processed as alternating well-formed runs, measured eight
+  //  octets at a time, and single ill-formed sequences, measured by utf8_decode() so
+  //  that each counts as exactly one U+FFFD just as utf8_to_char32_t() would emit.
+
+  inline std::size_t count_code_points(const char* first, const char* last,
+    utf8) BOOST_NOEXCEPT
+  {
+    std::size_t n = 0;
+    for (;;)
+    {
+      const char* err = first_ill_formed(first, last, utf8()).first;
+      n += swar_utf8_code_points(first, err);
+      if (err == last)
+        return n;
+      char32_t u32;
+      utf8_decode(err, last, u32);
+      ++n;
+      first = err;
+    }
+  }
+
+  template <class ForwardIterator>
+  std::size_t count_code_points(ForwardIterator first, ForwardIterator last,
+    utf16) BOOST_NOEXCEPT
+  {
+    std::size_t n = 0;
+    for (char32_t u32; first != last; ++n)
+      utf16_decode(first, last, u32);
+    return n;
+  }
+
+  template <class ForwardIterator>
+  std::size_t count_code_points(ForwardIterator first, ForwardIterator last,
+    utf32) BOOST_NOEXCEPT
+  {
+    return static_cast<std::size_t>(std::distance(first, last));
+  }
+
+  inline std::size_t utf16_length_of_utf8(const char* first, const char* last)
+    BOOST_NOEXCEPT
+  {
+    std::size_t n = 0;
+    for (;;)
+    {
+      const char* err = first_ill_formed(first, last, utf8()).first;
+      n += swar_utf8_utf16_length(first, err);
+      if (err == last)
+        return n;
+      char32_t u32;
+      n += (utf8_decode(err, last, u32) && u32 > 0xFFFFu) ? 2 : 1;
+      first = err;
+    }
+  }
+
+  //  Identity recoding  ---------------------------------------------------------------//
+
+  //  Contiguous input is copied through a well-formed run at a time, each run found by
+  //  first_ill_formed(). Each ill-formed sequence is then decoded and replaced exactly
+  //  as by utf8_to_char32_t(), utf16_to_char32_t(), or char32_t_to_utf32(), so the
+  //  output is the same as decoding and re-encoding every code point.
+
+  template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf8_to_utf8(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh)
+  {
+    // pass input sequence through UTF-32 conversion to ensure the
+    // output sequence is valid even if the input sequence isn't valid
+    return utf8_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+  }
+
+  template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf16_to_utf16(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh)
+  {
+    return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+  }
+
+  template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf32_to_utf32_scalar(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh)
+  {
+    for (; first != last; ++first)
+    {
+      BOOST_UNICODE_COUNT(bytes_in, 4);
+      result = char32_t_to_utf32<ToCharT>(static_cast<char32_t>(*first), result, eh);
+    }
+    return result;
+  }
+
+  template <class ToCharT, class InputIterator, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf32_to_utf32(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh)
+  {
+    return utf32_to_utf32_scalar<ToCharT>(first, last, result, eh);
+  }
+
+  template <class ToCharT, class CharT, class OutputIterator>
+  inline OutputIterator copy_well_formed(const CharT* first, const CharT* last,
+    OutputIterator result)
+  {
+    using from_tag = typename utf_encoding<CharT>::tag;
+    BOOST_UNICODE_COUNT(bytes_in, (last - first) * sizeof(CharT));
+    BOOST_UNICODE_COUNT(bytes_out, (last - first) * sizeof(ToCharT));
+    BOOST_UNICODE_COUNT(code_points, count_code_points(first, last, from_tag()));
+    return copy_code_units<ToCharT>(first, last, result);
+  }
+
+  template <class ToCharT, class OutputIterator, class Error>
+  inline OutputIterator utf8_copy_to_utf8(const char* first, const char* last,
+    OutputIterator result, Error eh)
+  {
+    for (;;)
+    {
+      const char* err = first_ill_formed(first, last, utf8()).first;
+      result = copy_well_formed<ToCharT>(first, err, result);
+      if (err == last)
+        return result;
+      char32_t u32 = 0;
+      bool well_formed = utf8_decode(err, last, u32);
+      result = decoded_outputer<ToCharT>(well_formed, u32, result,
+        u32_err_pass_thru(), eh);
+      first = err;
+    }
+  }
+
+  template <class ToCharT, class U16CharT, class OutputIterator, class Error>
+  inline OutputIterator utf16_copy_to_utf16(const U16CharT* first, const U16CharT* last,
+    OutputIterator result, Error eh)
+  {
+    for (;;)
+    {
+      const U16CharT* err = first_ill_formed(first, last, utf16()).first;
+      result = copy_well_formed<ToCharT>(first, err, result);
+      if (err == last)
+        return result;
+      char32_t u32 = 0;
+      bool well_formed = utf16_decode(err, last, u32);
+      result = decoded_outputer<ToCharT>(well_formed, u32, result,
+        u32_err_pass_thru(), eh);
+      first = err;
+    }
+  }
+
+  template <class ToCharT, class U32CharT, class OutputIterator, class Error>
+  inline OutputIterator utf32_copy_to_utf32(const U32CharT* first, const U32CharT* last,
+    OutputIterator result, Error eh)
+  {
+    for (;;)
+    {
+      const U32CharT* err = first_ill_formed(first, last, utf32()).first;
+      result = copy_well_formed<ToCharT>(first, err, result);
+      if (err == last)
+        return result;
+      BOOST_UNICODE_COUNT(bytes_in, 4);
+      result = char32_t_to_utf32<ToCharT>(static_cast<char32_t>(*err), result, eh);
+      first = err + 1;
+    }
+  }
+
+  template <class ToCharT, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf8_to_utf8(const char* first, const char* last,
+    OutputIterator result, Error eh)
+  {
+    if (in_constant_evaluation())
+      return utf8_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    return utf8_copy_to_utf8<ToCharT>(first, last, result, eh);
+  }
+
+  template <class ToCharT, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf16_to_utf16(const char16_t* first, const char16_t* last,
+    OutputIterator result, Error eh)
+  {
+    if (in_constant_evaluation())
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    return utf16_copy_to_utf16<ToCharT>(first, last, result, eh);
+  }
+
+  template <class ToCharT, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf32_to_utf32(const char32_t* first, const char32_t* last,
+    OutputIterator result, Error eh)
+  {
+    if (in_constant_evaluation())
+      return utf32_to_utf32_scalar<ToCharT>(first, last, result, eh);
+    return utf32_copy_to_utf32<ToCharT>(first, last, result, eh);
+  }
+
+# if WCHAR_MAX >= 0x1FFFFFFFu
+  template <class ToCharT, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf32_to_utf32(const wchar_t* first, const wchar_t* last,
+    OutputIterator result, Error eh)
+  {
+    if (in_constant_evaluation())
+      return utf32_to_utf32_scalar<ToCharT>(first, last, result, eh);
+    return utf32_copy_to_utf32<ToCharT>(first, last, result, eh);
+  }
+# elif WCHAR_MAX >= 0x1FFFu
+  template <class ToCharT, class OutputIterator, class Error>
+  inline BOOST_CXX14_CONSTEXPR
+  OutputIterator utf16_to_utf16(const wchar_t* first, const wchar_t* last,
+    OutputIterator result, Error eh)
+  {
+    if (in_constant_evaluation())
+      return utf16_to_char32_t<ToCharT>(first, last, result, u32_err_pass_thru(), eh);
+    return utf16_copy_to_utf16<ToCharT>(first, last, result, eh);
+  }
+# endif
+
+  //  codecvt_well_formed_to_narrow
+  //
+  //  Input already of the codecvt's intern_type needs no intermediary string. Each
+  //  well-formed run goes straight to the codecvt; each ill-formed code unit is replaced
+  //  by eh, as the codecvt would have replaced the pass through value put in its place.
+
+  //  where conversion resumes after the ill-formed range err; for UTF-16 that range
+  //  includes the code unit after an unpaired surrogate, but utf16_decode() does not
+  template <class CharT, class Tag>
+  inline const CharT* ill_formed_end(std::pair<const CharT*, const CharT*> err, Tag)
+    { return err.second; }
+  template <class CharT>
+  inline const CharT* ill_formed_end(std::pair<const CharT*, const CharT*> err, utf16)
+    { return err.first + 1; }
+
+  template <class FromCharT, class OutputIterator, class Error> inline
+  OutputIterator codecvt_well_formed_to_narrow(const FromCharT* first,
+    const FromCharT* last, OutputIterator result,
+    const std::codecvt<FromCharT, char, std::mbstate_t>& ccvt, Error eh)
+  {
+    using from_tag = typename utf_encoding<FromCharT>::tag;
+    for (;;)
+    {
+      std::pair<const FromCharT*, const FromCharT*> err
+        = first_ill_formed(first, last, from_tag());
+      result = codecvt_utf_to_narrow(first, err.first, result, ccvt, eh);
+      if (err.first == last)
+        return result;
+      BOOST_UNICODE_COUNT(invalid, 1);
+      for (auto it = eh(); *it != '\0'; ++it)
+        *result++ = *it;
+      first = ill_formed_end(err, from_tag());
+    }
+  }
+
 } // namespace detail
 
   template <> struct ufffd<char>
@@ -1217,8 +2227,8 @@ namespace unicode
     constexpr const wchar_t* operator()() const noexcept { return L"\uFFFD"; }
   };
 
-  template <class ForwardIterator> inline
-  std::pair<ForwardIterator, ForwardIterator>
+  template <class ForwardIterator>
+  inline BOOST_CXX14_CONSTEXPR std::pair<ForwardIterator, ForwardIterator>
     first_ill_formed(ForwardIterator first, ForwardIterator last) BOOST_NOEXCEPT
   {
     static_assert(is_encoded_character
@@ -1229,22 +2239,45 @@ namespace unicode
         <typename std::iterator_traits<ForwardIterator>::value_type>::tag());
   }
 
-  inline bool is_well_formed(boost::string_view v) BOOST_NOEXCEPT
+  inline BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::string_view v) BOOST_NOEXCEPT
   {
     return first_ill_formed(v.cbegin(), v.cend()).first == v.end();
   }
-  inline bool is_well_formed(boost::u16string_view v) BOOST_NOEXCEPT
+  inline BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::u16string_view v) BOOST_NOEXCEPT
   {
     return first_ill_formed(v.cbegin(), v.cend()).first == v.end();
   }
-  inline bool is_well_formed(boost::u32string_view v) BOOST_NOEXCEPT
+  inline BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::u32string_view v) BOOST_NOEXCEPT
   {
     return first_ill_formed(v.cbegin(), v.cend()).first == v.end();
   }
-  inline bool is_well_formed(boost::wstring_view v) BOOST_NOEXCEPT
+  inline BOOST_CXX14_CONSTEXPR bool is_well_formed(boost::wstring_view v) BOOST_NOEXCEPT
   {
     return first_ill_formed(v.cbegin(), v.cend()).first == v.end();
   }
+
+  inline std::size_t count_code_points(boost::string_view v) BOOST_NOEXCEPT
+  {
+    return detail::count_code_points(v.data(), v.data() + v.size(), utf8());
+  }
+  inline std::size_t count_code_points(boost::u16string_view v) BOOST_NOEXCEPT
+  {
+    return detail::count_code_points(v.cbegin(), v.cend(), utf16());
+  }
+  inline std::size_t count_code_points(boost::u32string_view v) BOOST_NOEXCEPT
+  {
+    return v.size();
+  }
+  inline std::size_t count_code_points(boost::wstring_view v) BOOST_NOEXCEPT
+  {
+    return detail::count_code_points(v.cbegin(), v.cend(),
+      detail::utf_encoding<wchar_t>::tag());
+  }
+
+  inline std::size_t utf16_length_of_utf8(boost::string_view v) BOOST_NOEXCEPT
+  {
+    return detail::utf16_length_of_utf8(v.data(), v.data() + v.size());
+  }
 }  // namespace unicode
 }  // namespace boost
 
@@ -0,0 +1,172 @@
+﻿//  boost/unicode/trace.hpp  -----------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  Tracing hooks for recode(), to_string(), recode_batch(), and recoder::recode(). An  //
+//  installed conversion_observer is told when each call starts and ends, with the      //
+//  encoding pair, the sizes, and the elapsed time. Calls made internally by the        //
+//  library, such as the recode() performed by to_string() or the one per string        //
+//  performed by recode_batch(), are not reported separately.                           //
+//                                                                                      //
+//  With no observer installed, the cost of a call is one acquire atomic load, which    //
+//  is a plain load on x86, and a branch; the clock is not read.                        //
+//                                                                                      //
+//  See latency_histogram.hpp for an observer that keeps latency histograms.            //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_TRACE_HPP)
+#define BOOST_UNICODE_TRACE_HPP
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <boost/config.hpp>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  enum class conversion { recode, to_string, recoder, recode_batch };
+  constexpr std::size_t conversion_count = 4;
+
+  const char* conversion_name(conversion c) BOOST_NOEXCEPT;
+
+  constexpr std::size_t unknown_size = static_cast<std::size_t>(-1);
+
+  struct conversion_event
+  {
+    conversion   operation;
+    const char*  from;          // encoding names; iconv names for recoder
+    const char*  to;
+    std::size_t  input_bytes;   // unknown_size unless the input is random access
+    std::size_t  output_bytes;  // unknown_size at start, or unless the output is random
+                                //   access or a string
+  };
+
+  class conversion_observer
+  {
+  public:
+    virtual ~conversion_observer() {}
+
+    virtual void conversion_start(const conversion_event&) BOOST_NOEXCEPT {}
+    //  Not called if the conversion exits via an exception.
+    virtual void conversion_end(const conversion_event& event,
+      std::chrono::nanoseconds duration) BOOST_NOEXCEPT = 0;
+  };
+
+  //  Effects: installs observer, which may be null, for all threads.
+  //  Returns: the previously installed observer.
+  //  Remarks: an observer must remain valid until every conversion that may have seen it
+  //  has ended.
+  conversion_observer* set_conversion_observer(conversion_observer* observer)
+    BOOST_NOEXCEPT;
+  conversion_observer* get_conversion_observer() BOOST_NOEXCEPT;
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  inline const char* conversion_name(conversion c) BOOST_NOEXCEPT
+  {
+    static const char* const names[conversion_count]
+      = { "recode", "to_string", "recoder", "recode_batch" };
+    return names[static_cast<std::size_t>(c)];
+  }
+
+namespace detail
+{
+  //  constant initialized, so there is no guard on the fast path
+  inline std::atomic<conversion_observer*>& observer_slot() BOOST_NOEXCEPT
+  {
+    static std::atomic<conversion_observer*> observer(nullptr);
+    return observer;
+  }
+
+  //  times one conversion; construct only when an observer is installed
+  class trace_scope
+  {
+  public:
+    trace_scope(conversion_observer* observer, conversion operation, const char* from,
+      const char* to, std::size_t input_bytes) BOOST_NOEXCEPT
+      : observer_(observer), event_{operation, from, to, input_bytes, unknown_size}
+    {
+      observer_->conversion_start(event_);
+      start_ = std::chrono::steady_clock::now();
+    }
+
+    void finish(std::size_t output_bytes) BOOST_NOEXCEPT
+    {
+      auto duration = std::chrono::steady_clock::now() - start_;
+      event_.output_bytes = output_bytes;
+      observer_->conversion_end(event_,
+        std::chrono::duration_cast<std::chrono::nanoseconds>(duration));
+    }
+
+  private:
+    conversion_observer*                   observer_;
+    conversion_event                       event_;
+    std::chrono::steady_clock::time_point  start_;
+  };
+
+  //  is_random_access is false for iterators without iterator_traits, such as many
+  //  user supplied output iterators
+  template <class Iterator, class = void>
+  struct is_random_access : std::false_type {};
+  template <class Iterator>
+  struct is_random_access<Iterator, typename std::enable_if<std::is_base_of<
+    std::random_access_iterator_tag,
+    typename std::iterator_traits<Iterator>::iterator_category>::value>::type>
+    : std::true_type {};
+
+  template <class CharT, class Iterator>
+  inline std::size_t byte_distance(Iterator first, Iterator last, std::true_type)
+  {
+    return static_cast<std::size_t>(last - first) * sizeof(CharT);
+  }
+  template <class CharT, class Iterator>
+  inline std::size_t byte_distance(Iterator, Iterator, std::false_type)
+  {
+    return unknown_size;
+  }
+
+  //  returns: size of [first, last) in bytes, or unknown_size if that cannot be
+  //  determined without traversing the sequence
+  template <class CharT, class Iterator>
+  inline std::size_t byte_distance(Iterator first, Iterator last)
+  {
+    return byte_distance<CharT>(first, last, is_random_access<Iterator>());
+  }
+}  // namespace detail
+
+  inline conversion_observer* set_conversion_observer(conversion_observer* observer)
+    BOOST_NOEXCEPT
+  {
+    return detail::observer_slot().exchange(observer, std::memory_order_acq_rel);
+  }
+
+  inline conversion_observer* get_conversion_observer() BOOST_NOEXCEPT
+  {
+    return detail::observer_slot().load(std::memory_order_acquire);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_TRACE_HPP
@@ -0,0 +1,373 @@
+﻿//  boost/unicode/utf8_codecvt.hpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  utf8_codecvt<InternT> is a codecvt facet between UTF-8 and UTF-16 (char16_t, or     //
+//  wchar_t where it is 16 bits) or UTF-32 (char32_t, or wchar_t where it is 32 bits),  //
+//  for use with this library's narrow conversions, std::wstring_convert, and file      //
+//  streams.                                                                            //
+//                                                                                      //
+//  do_in() and do_out() convert a chunk at a time, the largest chunk that cannot       //
+//  overflow the output. do_in() passes ASCII runs to the same kernels as recode(), so  //
+//  ASCII is skipped a word or an SSE2 block at a time, and decodes other sequences in  //
+//  the same pass that validates them. do_out() validates the chunk with                //
+//  first_ill_formed() and converts it with the kernels. Only a sequence at the end of  //
+//  the output that it cannot take whole is converted by itself.                        //
+//                                                                                      //
+//  The facet keeps no state in mbstate_t. A sequence is never split: one cut short by  //
+//  the end of the input or of the output is left for the next call, and partial is     //
+//  returned. Ill-formed input returns error, with from_next at the start of the        //
+//  maximal subpart that recode() would replace.                                        //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_UTF8_CODECVT_HPP)
+#define BOOST_UNICODE_UTF8_CODECVT_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <cwchar>
+#include <locale>
+#include <type_traits>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+  template <class InternT>
+  class utf8_codecvt : public std::codecvt<InternT, char, std::mbstate_t>
+  {
+    static_assert(std::is_same<InternT, char16_t>::value
+      || std::is_same<InternT, char32_t>::value || std::is_same<InternT, wchar_t>::value,
+      "InternT must be char16_t, char32_t, or wchar_t");
+  public:
+    using intern_type = InternT;
+    using extern_type = char;
+    using state_type = std::mbstate_t;
+    using result = std::codecvt_base::result;
+
+    explicit utf8_codecvt(std::size_t refs = 0)
+      : std::codecvt<InternT, char, std::mbstate_t>(refs) {}
+
+  protected:
+    result do_in(state_type& state, const char* from, const char* from_end,
+      const char*& from_next, InternT* to, InternT* to_end, InternT*& to_next)
+      const override;
+    result do_out(state_type& state, const InternT* from, const InternT* from_end,
+      const InternT*& from_next, char* to, char* to_end, char*& to_next)
+      const override;
+    result do_unshift(state_type&, char* to, char*, char*& to_next) const override
+    {
+      to_next = to;
+      return std::codecvt_base::noconv;
+    }
+
+    int do_encoding() const BOOST_NOEXCEPT_OR_NOTHROW override { return 0; }
+    bool do_always_noconv() const BOOST_NOEXCEPT_OR_NOTHROW override { return false; }
+
+    //  Returns: the number of octets do_in() would consume given room for max code
+    //  units; a surrogate pair is two
+    int do_length(state_type&, const char* from, const char* from_end,
+      std::size_t max) const override;
+
+    //  four octets are the most needed for one code point, or for a surrogate pair
+    int do_max_length() const BOOST_NOEXCEPT_OR_NOTHROW override { return 4; }
+  };
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  //  returns: the number of octets in the sequence led by octet, or 0 if octet cannot
+  //  lead a well-formed sequence
+  inline std::size_t utf8_sequence_length(char octet) BOOST_NOEXCEPT
+  {
+    unsigned char c = static_cast<unsigned char>(octet);
+    return c < 0x80u ? 1 : c < 0xC2u ? 0 : c < 0xE0u ? 2 : c < 0xF0u ? 3 : c < 0xF5u ? 4
+      : 0;
+  }
+
+  //  returns: true if [first, last) is a proper prefix of a well-formed sequence, so
+  //  the input ends within the sequence rather than it being ill-formed
+  inline bool utf8_truncated(const char* first, const char* last) BOOST_NOEXCEPT
+  {
+    const char* next = first;
+    char32_t u32;
+    return !utf8_decode(next, last, u32) && next == last
+      && utf8_sequence_length(*first) > static_cast<std::size_t>(last - first);
+  }
+
+  //  [first, last) is ASCII, and out has room for it
+  template <class U16CharT>
+  U16CharT* utf8_codecvt_ascii(const char* first, const char* last, U16CharT* out,
+    utf16)
+  {
+    for (; first != last; ++first)
+      *out++ = static_cast<U16CharT>(*first);
+    return out;
+  }
+
+  template <class U32CharT>
+  U32CharT* utf8_codecvt_ascii(const char* first, const char* last, U32CharT* out,
+    utf32)
+  {
+    return utf8_to_utf32<U32CharT>(first, last, out, ufffd<U32CharT>());
+  }
+
+  //  [first, last) is well-formed, and out has room for its UTF-8 octets
+  template <class U16CharT>
+  char* utf8_codecvt_out(const U16CharT* first, const U16CharT* last, char* out, utf16)
+  {
+    return utf16_to_char32_t<char>(first, last, out, u32_err_pass_thru(), ufffd<char>());
+  }
+
+  template <class U32CharT>
+  char* utf8_codecvt_out(const U32CharT* first, const U32CharT* last, char* out, utf32)
+  {
+    return utf32_to_utf8<char>(first, last, out, ufffd<char>());
+  }
+
+  //  u32 is a code point, so needs no further checks
+  template <class U16CharT>
+  U16CharT* utf8_codecvt_put(char32_t u32, U16CharT* out, utf16)
+  {
+    if (u32 <= 0xFFFFu)
+      *out++ = static_cast<U16CharT>(u32);
+    else
+    {
+      u32 -= 0x10000u;
+      *out++ = static_cast<U16CharT>(0xD800u + (u32 >> 10));
+      *out++ = static_cast<U16CharT>(0xDC00u + (u32 & 0x3FFu));
+    }
+    return out;
+  }
+  template <class U32CharT>
+  U32CharT* utf8_codecvt_put(char32_t u32, U32CharT* out, utf32)
+  {
+    *out++ = static_cast<U32CharT>(u32);
+    return out;
+  }
+
+  //  converts [first, last), which ends where a sequence starts, to out, which has
+  //  room for a code unit per octet; ASCII runs go to the kernels, and each other
+  //  sequence is decoded in the same pass that validates it
+  //  returns: false at the first ill-formed sequence, with first and out updated
+  template <class InternT, class Tag>
+  bool utf8_codecvt_in(const char*& first, const char* last, const char* input_end,
+    InternT*& out, Tag)
+  {
+    const char* from = first;
+    InternT* to = out;
+    bool well_formed = true;
+    while (from != last && well_formed)
+    {
+      const char* ascii = ascii_end(from, last);
+      to = utf8_codecvt_ascii(from, ascii, to, Tag());
+      from = ascii;
+      while (from != last && (static_cast<unsigned char>(*from) & 0x80u))
+      {
+        const char* next = from;
+        char32_t u32 = 0;
+        if (!utf8_decode(next, input_end, u32))
+        {
+          well_formed = false;
+          break;
+        }
+        to = utf8_codecvt_put(u32, to, Tag());
+        from = next;
+      }
+    }
+    first = from;
+    out = to;
+    return well_formed;
+  }
+
+  //  code units needed for u32
+  inline std::size_t utf8_codecvt_units(char32_t u32, utf16) BOOST_NOEXCEPT
+    { return u32 > 0xFFFFu ? 2 : 1; }
+  inline std::size_t utf8_codecvt_units(char32_t, utf32) BOOST_NOEXCEPT { return 1; }
+
+  //  decodes the code point at first; returns: true if it is well-formed
+  template <class U16CharT>
+  bool utf8_codecvt_get(const U16CharT*& first, const U16CharT* last, char32_t& u32,
+    utf16)
+  {
+    return utf16_decode(first, last, u32);
+  }
+  template <class U32CharT>
+  bool utf8_codecvt_get(const U32CharT*& first, const U32CharT*, char32_t& u32, utf32)
+  {
+    u32 = static_cast<char32_t>(*first++);
+    return u32 < 0xD800u || (u32 > 0xDFFFu && u32 <= 0x10FFFFu);
+  }
+
+  //  returns: true if [first, last) is a high surrogate alone, so the input ends within
+  //  a surrogate pair rather than it being ill-formed
+  template <class U16CharT>
+  bool utf8_codecvt_truncated(const U16CharT* first, const U16CharT* last, utf16)
+  {
+    return last - first == 1 && (static_cast<char32_t>(*first) & 0xFC00u) == 0xD800u;
+  }
+  template <class U32CharT>
+  bool utf8_codecvt_truncated(const U32CharT*, const U32CharT*, utf32) { return false; }
+
+  //  octets per code unit that a chunk of input may need
+  constexpr std::size_t utf8_codecvt_expansion(utf16) { return 3; }
+  constexpr std::size_t utf8_codecvt_expansion(utf32) { return 4; }
+}  // namespace detail
+
+  //  utf8_codecvt  --------------------------------------------------------------------//
+
+  template <class InternT>
+  std::codecvt_base::result utf8_codecvt<InternT>::do_in(state_type&,
+    const char* from, const char* from_end, const char*& from_next,
+    InternT* to, InternT* to_end, InternT*& to_next) const
+  {
+    using tag = typename detail::utf_encoding<InternT>::tag;
+    result res = std::codecvt_base::ok;
+    while (from != from_end)
+    {
+      //  no sequence has more code units than octets, so the room is a safe chunk size,
+      //  once the chunk is trimmed back to the start of a sequence
+      std::size_t room = static_cast<std::size_t>(to_end - to);
+      const char* chunk_end
+        = from + (std::min)(room, static_cast<std::size_t>(from_end - from));
+      for (int i = 0; i < 3 && chunk_end != from_end && chunk_end != from
+        && (static_cast<unsigned char>(*chunk_end) & 0xC0u) == 0x80u; ++i)
+        --chunk_end;
+
+      if (chunk_end == from)  // the next sequence, if the output can take it whole
+      {
+        const char* next = from;
+        char32_t u32 = 0;
+        if (!detail::utf8_decode(next, from_end, u32))
+        {
+          res = detail::utf8_truncated(from, from_end)
+            ? std::codecvt_base::partial : std::codecvt_base::error;
+          break;
+        }
+        if (detail::utf8_codecvt_units(u32, tag()) > room)
+        {
+          res = std::codecvt_base::partial;
+          break;
+        }
+        to = detail::utf8_codecvt_put(u32, to, tag());
+        from = next;
+        continue;
+      }
+
+      if (!detail::utf8_codecvt_in(from, chunk_end, from_end, to, tag()))
+      {
+        res = detail::utf8_truncated(from, from_end)
+          ? std::codecvt_base::partial : std::codecvt_base::error;
+        break;
+      }
+    }
+    from_next = from;
+    to_next = to;
+    return res;
+  }
+
+  template <class InternT>
+  std::codecvt_base::result utf8_codecvt<InternT>::do_out(state_type&,
+    const InternT* from, const InternT* from_end, const InternT*& from_next,
+    char* to, char* to_end, char*& to_next) const
+  {
+    using tag = typename detail::utf_encoding<InternT>::tag;
+    result res = std::codecvt_base::ok;
+    while (from != from_end)
+    {
+      std::size_t room = static_cast<std::size_t>(to_end - to);
+      const InternT* chunk_end = from + (std::min)(
+        room / detail::utf8_codecvt_expansion(tag()),
+        static_cast<std::size_t>(from_end - from));
+      if (std::is_same<tag, utf16>::value && chunk_end != from_end && chunk_end != from
+        && (static_cast<char32_t>(chunk_end[-1]) & 0xFC00u) == 0xD800u)
+        --chunk_end;  // keep a surrogate pair together
+
+      if (chunk_end == from)  // the next code point, if the output can take it whole
+      {
+        const InternT* next = from;
+        char32_t u32 = 0;
+        if (!detail::utf8_codecvt_get(next, from_end, u32, tag()))
+        {
+          res = detail::utf8_codecvt_truncated(from, from_end, tag())
+            ? std::codecvt_base::partial : std::codecvt_base::error;
+          break;
+        }
+        char octets[4];
+        std::size_t n = static_cast<std::size_t>(
+          detail::char32_t_to_utf8<char>(u32, octets, ufffd<char>()) - octets);
+        if (n > room)
+        {
+          res = std::codecvt_base::partial;
+          break;
+        }
+        to = std::copy(octets, octets + n, to);
+        from = next;
+        continue;
+      }
+
+      const InternT* err = detail::first_ill_formed(from, chunk_end, tag()).first;
+      to = detail::utf8_codecvt_out(from, err, to, tag());
+      from = err;
+      if (err != chunk_end)
+      {
+        res = detail::utf8_codecvt_truncated(err, from_end, tag())
+          ? std::codecvt_base::partial : std::codecvt_base::error;
+        break;
+      }
+    }
+    from_next = from;
+    to_next = to;
+    return res;
+  }
+
+  template <class InternT>
+  int utf8_codecvt<InternT>::do_length(state_type&, const char* from,
+    const char* from_end, std::size_t max) const
+  {
+    using tag = typename detail::utf_encoding<InternT>::tag;
+    const char* first = from;
+    std::size_t count = 0;
+    while (from != from_end && count < max)
+    {
+      const char* ascii = detail::ascii_end(from,
+        from + (std::min)(max - count, static_cast<std::size_t>(from_end - from)));
+      count += static_cast<std::size_t>(ascii - from);
+      from = ascii;
+      if (from == from_end || count == max)
+        break;
+      const char* next = from;
+      char32_t u32 = 0;
+      if (!detail::utf8_decode(next, from_end, u32))
+        break;
+      count += detail::utf8_codecvt_units(u32, tag());
+      if (count > max)
+        break;
+      from = next;
+    }
+    return static_cast<int>(from - first);
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_UTF8_CODECVT_HPP
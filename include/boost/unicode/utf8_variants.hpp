@@ -0,0 +1,460 @@
+﻿//  boost/unicode/utf8_variants.hpp  ---------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  wtf8, cesu8, and mutf8 are encodings for recode() and to_string() that extend       //
+//  UTF-8 to surrogate code points, so that UTF-16 with unpaired surrogates, such as    //
+//  Windows file names and Java strings, round trips without loss:                      //
+//                                                                                      //
+//    std::string name = to_string<wtf8>(u16s);          // any UTF-16                  //
+//    recode<wtf8, utf16>(first, last, std::back_inserter(u16s));  // the same UTF-16   //
+//                                                                                      //
+//    wtf8   WTF-8: a surrogate code point not part of a pair is three octets, ED A0    //
+//           80 to ED BF BF; all else is UTF-8.                                         //
+//    cesu8  CESU-8: as wtf8, but a supplementary code point is its UTF-16 surrogate    //
+//           pair, six octets.                                                          //
+//    mutf8  Modified UTF-8, as Java's DataInput and JNI use it: as cesu8, but U+0000   //
+//           is C0 80, so that the encoding has no zero octet.                          //
+//                                                                                      //
+//  Each decodes all of UTF-8 too, and the two surrogates of a pair, in separate        //
+//  sequences, decode to two surrogate code points. Output to UTF-16, UTF-32, and wide  //
+//  keeps surrogate code points as they are, so that decoding to UTF-16 rejoins the     //
+//  pairs; output to UTF-8, which cannot represent them, passes them to the error       //
+//  handler. Likewise unpaired surrogates of UTF-16, UTF-32, and wide input are         //
+//  encoded; ill-formed UTF-8 input is replaced as recode() from UTF-8 replaces it.     //
+//                                                                                      //
+//  Contiguous input is converted a run at a time: the runs the encoding shares with    //
+//  UTF-8, found by first_ill_formed() or by the SWAR and SSE2 scans of detail/, go to  //
+//  the UTF-to-UTF conversions, and only the sequences between them are decoded here.   //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_UTF8_VARIANTS_HPP)
+#define BOOST_UNICODE_UTF8_VARIANTS_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/detail/sse2.hpp>
+#include <boost/unicode/detail/swar.hpp>
+#include <cstddef>
+#include <type_traits>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+
+namespace boost
+{
+namespace unicode
+{
+  namespace detail { struct utf8_variant {}; }
+
+  //  [uni.utf8_variants] encodings
+  struct wtf8  : detail::utf8_variant { using value_type = char; };  // WTF-8
+  struct cesu8 : detail::utf8_variant { using value_type = char; };  // CESU-8
+  struct mutf8 : detail::utf8_variant { using value_type = char; };  // Modified UTF-8
+
+  template<> struct is_encoding<wtf8>  : std::true_type {};
+  template<> struct is_encoding<cesu8> : std::true_type {};
+  template<> struct is_encoding<mutf8> : std::true_type {};
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  inline const char* encoding_name(wtf8) BOOST_NOEXCEPT  { return "wtf8"; }
+  inline const char* encoding_name(cesu8) BOOST_NOEXCEPT { return "cesu8"; }
+  inline const char* encoding_name(mutf8) BOOST_NOEXCEPT { return "mutf8"; }
+
+  //  pairs: supplementary code points are surrogate pairs
+  //  nul: U+0000 is C0 80
+  template <class Encoding> struct variant_traits;
+  template<> struct variant_traits<wtf8>
+  {
+    static constexpr bool pairs = false;
+    static constexpr bool nul = false;
+  };
+  template<> struct variant_traits<cesu8>
+  {
+    static constexpr bool pairs = true;
+    static constexpr bool nul = false;
+  };
+  template<> struct variant_traits<mutf8>
+  {
+    static constexpr bool pairs = true;
+    static constexpr bool nul = true;
+  };
+
+  inline bool is_surrogate(char32_t u32) BOOST_NOEXCEPT
+  {
+    return u32 >= 0xD800u && u32 <= 0xDFFFu;
+  }
+
+  //  surrogate_decode
+  //
+  //  If the three octets at first are a surrogate, ED A0 80 to ED BF BF, advances first
+  //  past them and returns true with the surrogate in u32. Otherwise returns false.
+
+  template <class InputIterator>
+  inline bool surrogate_decode(InputIterator& first, InputIterator last, char32_t& u32)
+  {
+    InputIterator it = first;
+    if (it == last || static_cast<unsigned char>(*it) != 0xEDu || ++it == last)
+      return false;
+    const unsigned char c1 = static_cast<unsigned char>(*it);
+    if ((c1 & 0xE0u) != 0xA0u || ++it == last)
+      return false;
+    const unsigned char c2 = static_cast<unsigned char>(*it);
+    if ((c2 & 0xC0u) != 0x80u)
+      return false;
+    BOOST_UNICODE_COUNT(bytes_in, 3);
+    u32 = 0xD000u | ((c1 & 0x3Fu) << 6) | (c2 & 0x3Fu);
+    first = ++it;
+    return true;
+  }
+
+  //  variant_decode
+  //
+  //  Decodes the sequence at first, advancing first past it, as utf8_decode() does, but
+  //  for Encoding.
+
+  template <class Encoding, class InputIterator>
+  inline bool variant_decode(InputIterator& first, InputIterator last, char32_t& u32)
+  {
+    if (surrogate_decode(first, last, u32))
+    {
+      InputIterator it = first;
+      char32_t low = 0;
+      if (variant_traits<Encoding>::pairs && u32 < 0xDC00u
+        && surrogate_decode(it, last, low) && low >= 0xDC00u)
+      {
+        u32 = (u32 << 10) + low - 0x35FDC00u;
+        first = it;
+      }
+      return true;
+    }
+    if (variant_traits<Encoding>::nul && static_cast<unsigned char>(*first) == 0xC0u)
+    {
+      InputIterator it = first;
+      if (++it != last && static_cast<unsigned char>(*it) == 0x80u)
+      {
+        BOOST_UNICODE_COUNT(bytes_in, 2);
+        u32 = 0;
+        first = ++it;
+        return true;
+      }
+    }
+    return utf8_decode(first, last, u32);
+  }
+
+  //  variant_outputer
+  //
+  //  As u32_outputer(), except that a surrogate code point is output as itself to
+  //  UTF-16 and UTF-32, which can hold one.
+
+  template <class ToCharT, class OutputIterator, class Error>
+  inline OutputIterator variant_outputer(utf8, char32_t u32, OutputIterator result,
+    Error eh)
+  {
+    return u32_outputer<ToCharT>(utf8(), u32, result, eh);
+  }
+  template <class ToCharT, class Tag, class OutputIterator, class Error>
+  inline OutputIterator variant_outputer(Tag, char32_t u32, OutputIterator result,
+    Error eh)
+  {
+    if (!is_surrogate(u32))
+      return u32_outputer<ToCharT>(Tag(), u32, result, eh);
+    *result++ = static_cast<ToCharT>(u32);
+    count_encoded<ToCharT>(1);
+    return result;
+  }
+
+  //  UTF input, decoded as the UTF-to-UTF conversions decode it, except that an
+  //  unpaired surrogate is its own code point
+
+  template <class InputIterator>
+  inline bool variant_utf_decode(utf8, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    return utf8_decode(first, last, u32);
+  }
+  template <class InputIterator>
+  inline bool variant_utf_decode(utf16, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    //  utf16_decode() fails only on an unpaired surrogate, and consumes just it
+    InputIterator unit = first;
+    if (!utf16_decode(first, last, u32))
+      u32 = static_cast<char16_t>(*unit);
+    return true;
+  }
+  template <class InputIterator>
+  inline bool variant_utf_decode(utf32, InputIterator& first, InputIterator,
+    char32_t& u32)
+  {
+    BOOST_UNICODE_COUNT(bytes_in, 4);
+    u32 = static_cast<char32_t>(*first++);
+    return u32 <= 0x10FFFFu;
+  }
+  template <class InputIterator>
+  inline bool variant_utf_decode(wide, InputIterator& first, InputIterator last,
+    char32_t& u32)
+  {
+    return variant_utf_decode(BOOST_UNICODE_WIDE_UTF(), first, last, u32);
+  }
+
+  //  variant_encode
+  //
+  //  Outputs u32 in Encoding, or the error handler's string if it is not a code point.
+
+  template <class OutputIterator>
+  inline OutputIterator surrogate_encode(char32_t u32, OutputIterator result)
+  {
+    *result++ = static_cast<char>(0xEDu);
+    *result++ = static_cast<char>(0x80u + ((u32 >> 6) & 0x3Fu));
+    *result++ = static_cast<char>(0x80u + (u32 & 0x3Fu));
+    return result;
+  }
+
+  template <class Encoding, class OutputIterator, class Error>
+  inline OutputIterator variant_encode(char32_t u32, OutputIterator result, Error eh)
+  {
+    if (is_surrogate(u32))
+    {
+      count_encoded<char>(3);
+      return surrogate_encode(u32, result);
+    }
+    if (variant_traits<Encoding>::pairs && u32 >= 0x10000u && u32 <= 0x10FFFFu)
+    {
+      count_encoded<char>(6);
+      result = surrogate_encode(high_surrogate_base + (u32 >> 10), result);
+      return surrogate_encode(low_surrogate_base + (u32 & ten_bit_mask), result);
+    }
+    if (variant_traits<Encoding>::nul && u32 == 0)
+    {
+      count_encoded<char>(2);
+      *result++ = static_cast<char>(0xC0u);
+      *result++ = static_cast<char>(0x80u);
+      return result;
+    }
+    return char32_t_to_utf8<char>(u32, result, eh);
+  }
+
+  //  variant_run
+  //
+  //  returns: the end of the run at the start of [first, last) that Encoding encodes as
+  //  UTF-8 does: up to the first ill-formed sequence of UTF-8 input, or the first
+  //  surrogate of UTF-16 input, or the first code point of either that Encoding encodes
+  //  otherwise.
+
+  template <class Encoding>
+  inline const char* variant_run(const char* first, const char* last)
+  {
+    last = first_ill_formed(first, last, utf8()).first;
+    if (!variant_traits<Encoding>::pairs)
+      return last;
+    for (; static_cast<std::size_t>(last - first) >= swar_size; first += swar_size)
+    {
+      swar_word w = swar_load(first);
+      if (swar_four_octet_lead_bits(w)
+        || (variant_traits<Encoding>::nul && swar_zero_bits(w)))
+        break;
+    }
+    for (; first != last; ++first)
+    {
+      const unsigned char c = static_cast<unsigned char>(*first);
+      if (c >= 0xF0u || (variant_traits<Encoding>::nul && c == 0))
+        break;
+    }
+    return first;
+  }
+
+  template <class Encoding, class U16CharT>
+  inline const U16CharT* variant_run(const U16CharT* first, const U16CharT* last)
+  {
+# if defined(BOOST_UNICODE_SSE2)
+    for (; static_cast<std::size_t>(last - first) >= sse2_block_size;
+      first += sse2_block_size)
+    {
+      if (sse2_utf16_surrogate_bits(first, variant_traits<Encoding>::nul))
+        break;
+    }
+# endif
+    for (; first != last; ++first)
+    {
+      const char16_t c = static_cast<char16_t>(*first);
+      if (is_surrogate(c) || (variant_traits<Encoding>::nul && c == 0))
+        break;
+    }
+    return first;
+  }
+
+  //  the conversions  ---------------------------------------------------------------//
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = ufffd<typename ToEncoding::value_type>>
+  inline OutputIterator variant_to_utf(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    using to_char = typename ToEncoding::value_type;
+    using to_tag = typename utf_encoding<to_char>::tag;
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!variant_decode<FromEncoding>(first, last, u32))
+        u32 = 0x110000u;  // passes the error to eh, as u32_err_pass_thru does
+      result = variant_outputer<to_char>(to_tag(), u32, result, eh);
+    }
+    return result;
+  }
+
+  template <class FromEncoding, class ToEncoding, class OutputIterator,
+    class Error = ufffd<typename ToEncoding::value_type>>
+  inline OutputIterator variant_to_utf(const char* first, const char* last,
+    OutputIterator result, Error eh = Error())
+  {
+    using to_char = typename ToEncoding::value_type;
+    using to_tag = typename utf_encoding<to_char>::tag;
+    for (;;)
+    {
+      const char* err = first_ill_formed(first, last, utf8()).first;
+      result = recode_utf_to_utf(utf8(), ToEncoding(), first, err, result, eh);
+      if (err == last)
+        return result;
+      char32_t u32 = 0;
+      if (!variant_decode<FromEncoding>(err, last, u32))
+        u32 = 0x110000u;
+      result = variant_outputer<to_char>(to_tag(), u32, result, eh);
+      first = err;
+    }
+  }
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = ufffd<char>>
+  inline OutputIterator utf_to_variant(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!variant_utf_decode(FromEncoding(), first, last, u32))
+        u32 = 0x110000u;
+      result = variant_encode<ToEncoding>(u32, result, eh);
+    }
+    return result;
+  }
+
+  template <class FromEncoding, class ToEncoding, class CharT, class OutputIterator,
+    class Error>
+  inline OutputIterator utf_runs_to_variant(const CharT* first, const CharT* last,
+    OutputIterator result, Error eh)
+  {
+    using from_tag = typename utf_encoding<CharT>::tag;
+    for (;;)
+    {
+      const CharT* stop = variant_run<ToEncoding>(first, last);
+      result = recode_utf_to_utf(from_tag(), utf8(), first, stop, result, eh);
+      if (stop == last)
+        return result;
+      char32_t u32 = 0;
+      if (!variant_utf_decode(from_tag(), stop, last, u32))
+        u32 = 0x110000u;
+      result = variant_encode<ToEncoding>(u32, result, eh);
+      first = stop;
+    }
+  }
+
+  template <class FromEncoding, class ToEncoding, class OutputIterator,
+    class Error = ufffd<char>>
+  inline OutputIterator utf_to_variant(const char* first, const char* last,
+    OutputIterator result, Error eh = Error())
+  {
+    return utf_runs_to_variant<FromEncoding, ToEncoding>(first, last, result, eh);
+  }
+
+  template <class FromEncoding, class ToEncoding, class OutputIterator,
+    class Error = ufffd<char>>
+  inline OutputIterator utf_to_variant(const char16_t* first, const char16_t* last,
+    OutputIterator result, Error eh = Error())
+  {
+    return utf_runs_to_variant<FromEncoding, ToEncoding>(first, last, result, eh);
+  }
+
+# if WCHAR_MAX >= 0x1FFFu && WCHAR_MAX < 0x1FFFFFFFu
+  template <class FromEncoding, class ToEncoding, class OutputIterator,
+    class Error = ufffd<char>>
+  inline OutputIterator utf_to_variant(const wchar_t* first, const wchar_t* last,
+    OutputIterator result, Error eh = Error())
+  {
+    return utf_runs_to_variant<FromEncoding, ToEncoding>(first, last, result, eh);
+  }
+# endif
+
+  template <class FromEncoding, class ToEncoding, class InputIterator,
+    class OutputIterator, class Error = ufffd<char>>
+  inline OutputIterator variant_to_variant(InputIterator first, InputIterator last,
+    OutputIterator result, Error eh = Error())
+  {
+    while (first != last)
+    {
+      char32_t u32 = 0;
+      if (!variant_decode<FromEncoding>(first, last, u32))
+        u32 = 0x110000u;
+      result = variant_encode<ToEncoding>(u32, result, eh);
+    }
+    return result;
+  }
+
+  //  recode_dispatch overloads, found by argument dependent lookup  -----------------//
+
+  struct utf8_variant_tag {};
+
+  template<> struct dispatch<wtf8>  { using tag = utf8_variant_tag; };
+  template<> struct dispatch<cesu8> { using tag = utf8_variant_tag; };
+  template<> struct dispatch<mutf8> { using tag = utf8_variant_tag; };
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(utf8_variant_tag, utf_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return variant_to_utf<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(utf_tag, utf8_variant_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return utf_to_variant<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+  template <class FromEncoding, class ToEncoding,
+    class InputIterator, class OutputIterator, class ... T> inline
+  OutputIterator recode_dispatch(utf8_variant_tag, utf8_variant_tag, InputIterator first,
+      InputIterator last, OutputIterator result, const T& ... args)
+  {
+    static_assert(sizeof...(args) <= 1, "too many arguments");
+    return variant_to_variant<FromEncoding, ToEncoding>(first, last, result, args ...);
+  }
+
+}  // namespace detail
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_UTF8_VARIANTS_HPP
@@ -0,0 +1,390 @@
+﻿//  boost/unicode/validated_view.hpp  --------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//--------------------------------------------------------------------------------------//
+//                                                                                      //
+//  validated_view<Encoding> is a string view known to be well-formed in Encoding,      //
+//  either because validate() checked it, or because the caller says so, as for a       //
+//  buffer that has already been through a validating parser:                           //
+//                                                                                      //
+//    validated_view<utf8> v = validate(s);               // the well-formed prefix     //
+//    validated_view<utf8> w(s, assume_valid);            // unchecked, but asserted    //
+//                                                                                      //
+//  to_string() of a validated_view neither checks nor replaces anything. The length    //
+//  of the result is computed first, by the SWAR length queries where there are any,    //
+//  so the string is allocated once at its exact size and written through a pointer;    //
+//  runs of ASCII are widened or narrowed a code unit at a time without decoding, and   //
+//  other code points decoded without the checks well-formed input cannot fail. When    //
+//  the encodings have the same code unit size, such as utf32 and a 32-bit wide, the    //
+//  conversion is a copy.                                                               //
+//                                                                                      //
+//  to_view() is the identity conversion: it returns the view itself rather than a      //
+//  copy, for code generic over the encoding that would otherwise call to_string().     //
+//                                                                                      //
+//--------------------------------------------------------------------------------------//
+
+#if !defined(BOOST_UNICODE_VALIDATED_VIEW_HPP)
+#define BOOST_UNICODE_VALIDATED_VIEW_HPP
+
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/trace.hpp>
+#include <boost/unicode/detail/swar.hpp>
+#include <boost/utility/string_view.hpp>
+#include <boost/assert.hpp>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+//--------------------------------------------------------------------------------------//
+//                                    Synopsis                                          //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+
+  struct assume_valid_t { explicit assume_valid_t() = default; };
+  constexpr assume_valid_t assume_valid{};
+
+  template <class Encoding>
+  class validated_view
+  {
+    static_assert(std::is_same<Encoding, utf8>::value
+      || std::is_same<Encoding, utf16>::value || std::is_same<Encoding, utf32>::value
+      || std::is_same<Encoding, wide>::value,
+      "Encoding must be utf8, utf16, utf32, or wide");
+  public:
+    using encoding_type = Encoding;
+    using value_type = typename Encoding::value_type;
+    using view_type = boost::basic_string_view<value_type>;
+    using const_iterator = const value_type*;
+
+    constexpr validated_view() noexcept {}
+
+    //  Requires: v is well-formed in Encoding. Checked only by BOOST_ASSERT.
+    validated_view(view_type v, assume_valid_t) noexcept;
+
+    view_type         view() const noexcept  { return v_; }
+    const value_type* data() const noexcept  { return v_.data(); }
+    std::size_t       size() const noexcept  { return v_.size(); }
+    bool              empty() const noexcept { return v_.empty(); }
+    const_iterator    begin() const noexcept { return v_.data(); }
+    const_iterator    end() const noexcept   { return v_.data() + v_.size(); }
+
+  private:  // exposition only
+    view_type v_;
+  };
+
+  //  Returns: a validated_view of the longest well-formed prefix of v, so that v is
+  //    well-formed if its size() is v.size()
+  validated_view<utf8>  validate(boost::string_view v) BOOST_NOEXCEPT;
+  validated_view<utf16> validate(boost::u16string_view v) BOOST_NOEXCEPT;
+  validated_view<utf32> validate(boost::u32string_view v) BOOST_NOEXCEPT;
+  validated_view<wide>  validate(boost::wstring_view v) BOOST_NOEXCEPT;
+
+  //  Returns: v in ToEncoding, which must be utf8, utf16, utf32, or wide
+  template <class ToEncoding, class FromEncoding>
+  std::basic_string<typename ToEncoding::value_type>
+    to_string(const validated_view<FromEncoding>& v);
+
+  //  Requires: ToEncoding is FromEncoding
+  //  Returns: v
+  template <class ToEncoding, class FromEncoding>
+  validated_view<ToEncoding>
+    to_view(const validated_view<FromEncoding>& v) BOOST_NOEXCEPT;
+
+}  // namespace unicode
+}  // namespace boost
+
+//--------------------------------------------------------------------------------------//
+//                                 Implementation                                       //
+//--------------------------------------------------------------------------------------//
+namespace boost
+{
+namespace unicode
+{
+namespace detail
+{
+  template <class CharT>
+  inline bool is_ascii(CharT c) BOOST_NOEXCEPT
+  {
+    return static_cast<typename std::make_unsigned<CharT>::type>(c) < 0x80u;
+  }
+
+  //  valid_decode
+  //
+  //  Returns the code point at p, advancing p past it. Requires: a well-formed sequence
+  //  at p, so no check is made.
+
+  template <class CharT>
+  inline char32_t valid_decode(utf8, const CharT*& p) BOOST_NOEXCEPT
+  {
+    const char32_t c = static_cast<unsigned char>(*p++);
+    if (c < 0x80u)
+      return c;
+    if (c < 0xE0u)
+      return ((c & 0x1Fu) << 6) | (static_cast<unsigned char>(*p++) & 0x3Fu);
+    if (c < 0xF0u)
+    {
+      const char32_t u32 = ((c & 0x0Fu) << 12)
+        | ((static_cast<unsigned char>(p[0]) & 0x3Fu) << 6)
+        | (static_cast<unsigned char>(p[1]) & 0x3Fu);
+      p += 2;
+      return u32;
+    }
+    const char32_t u32 = ((c & 0x07u) << 18)
+      | ((static_cast<unsigned char>(p[0]) & 0x3Fu) << 12)
+      | ((static_cast<unsigned char>(p[1]) & 0x3Fu) << 6)
+      | (static_cast<unsigned char>(p[2]) & 0x3Fu);
+    p += 3;
+    return u32;
+  }
+  template <class CharT>
+  inline char32_t valid_decode(utf16, const CharT*& p) BOOST_NOEXCEPT
+  {
+    const char32_t c = static_cast<char16_t>(*p++);
+    if ((c & 0xFC00u) != 0xD800u)
+      return c;
+    return (c << 10) + static_cast<char16_t>(*p++) - 0x35FDC00u;
+  }
+  template <class CharT>
+  inline char32_t valid_decode(utf32, const CharT*& p) BOOST_NOEXCEPT
+  {
+    return static_cast<char32_t>(*p++);
+  }
+
+  //  valid_encode
+  //
+  //  Writes the code point u32 at out. Requires: u32 is a scalar value.
+
+  template <class ToCharT>
+  inline ToCharT* valid_encode(utf8, char32_t u32, ToCharT* out) BOOST_NOEXCEPT
+  {
+    if (u32 < 0x80u)
+      *out++ = static_cast<ToCharT>(u32);
+    else if (u32 < 0x800u)
+    {
+      *out++ = static_cast<ToCharT>(0xC0u + (u32 >> 6));
+      *out++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+    }
+    else if (u32 < 0x10000u)
+    {
+      *out++ = static_cast<ToCharT>(0xE0u + (u32 >> 12));
+      *out++ = static_cast<ToCharT>(0x80u + ((u32 >> 6) & 0x3Fu));
+      *out++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+    }
+    else
+    {
+      *out++ = static_cast<ToCharT>(0xF0u + (u32 >> 18));
+      *out++ = static_cast<ToCharT>(0x80u + ((u32 >> 12) & 0x3Fu));
+      *out++ = static_cast<ToCharT>(0x80u + ((u32 >> 6) & 0x3Fu));
+      *out++ = static_cast<ToCharT>(0x80u + (u32 & 0x3Fu));
+    }
+    return out;
+  }
+  template <class ToCharT>
+  inline ToCharT* valid_encode(utf16, char32_t u32, ToCharT* out) BOOST_NOEXCEPT
+  {
+    if (u32 < 0x10000u)
+      *out++ = static_cast<ToCharT>(u32);
+    else
+    {
+      *out++ = static_cast<ToCharT>(high_surrogate_base + (u32 >> 10));
+      *out++ = static_cast<ToCharT>(low_surrogate_base + (u32 & ten_bit_mask));
+    }
+    return out;
+  }
+  template <class ToCharT>
+  inline ToCharT* valid_encode(utf32, char32_t u32, ToCharT* out) BOOST_NOEXCEPT
+  {
+    *out++ = static_cast<ToCharT>(u32);
+    return out;
+  }
+
+  inline std::size_t valid_units(utf8, char32_t u32) BOOST_NOEXCEPT
+  {
+    return u32 < 0x80u ? 1 : u32 < 0x800u ? 2 : u32 < 0x10000u ? 3 : 4;
+  }
+  inline std::size_t valid_units(utf16, char32_t u32) BOOST_NOEXCEPT
+  {
+    return u32 < 0x10000u ? 1 : 2;
+  }
+  inline std::size_t valid_units(utf32, char32_t) BOOST_NOEXCEPT { return 1; }
+
+  //  valid_length
+  //
+  //  Returns the number of ToTag code units in the well-formed [first, last).
+
+  template <class FromTag, class ToTag, class CharT>
+  inline std::size_t valid_length(FromTag, ToTag, const CharT* first, const CharT* last)
+    BOOST_NOEXCEPT
+  {
+    std::size_t n = 0;
+    while (first != last)
+      n += valid_units(ToTag(), valid_decode(FromTag(), first));
+    return n;
+  }
+  template <class Tag, class CharT>
+  inline std::size_t valid_length(Tag, Tag, const CharT* first, const CharT* last)
+    BOOST_NOEXCEPT
+  {
+    return static_cast<std::size_t>(last - first);
+  }
+  inline std::size_t valid_length(utf8, utf16, const char* first, const char* last)
+    BOOST_NOEXCEPT
+  {
+    return swar_utf8_utf16_length(first, last);
+  }
+  inline std::size_t valid_length(utf8, utf32, const char* first, const char* last)
+    BOOST_NOEXCEPT
+  {
+    return swar_utf8_code_points(first, last);
+  }
+
+  //  valid_ascii_end: the end of the run of ASCII at first
+
+  template <class CharT>
+  inline const CharT* valid_ascii_end(const CharT* first, const CharT* last)
+    BOOST_NOEXCEPT
+  {
+    while (first != last && is_ascii(*first))
+      ++first;
+    return first;
+  }
+  inline const char* valid_ascii_end(const char* first, const char* last)
+    BOOST_NOEXCEPT
+  {
+    return ascii_end(first, last);
+  }
+
+  //  valid_recode
+  //
+  //  Writes the well-formed [first, last) at out as ToTag. Returns: the end of the
+  //  output.
+
+  template <class FromTag, class ToTag, class CharT, class ToCharT>
+  inline ToCharT* valid_recode(FromTag, ToTag, const CharT* first, const CharT* last,
+    ToCharT* out) BOOST_NOEXCEPT
+  {
+    while (first != last)
+    {
+      for (const CharT* ascii = valid_ascii_end(first, last); first != ascii; ++first)
+        *out++ = static_cast<ToCharT>(*first);
+      while (first != last && !is_ascii(*first))
+        out = valid_encode(ToTag(), valid_decode(FromTag(), first), out);
+    }
+    return out;
+  }
+  template <class Tag, class CharT, class ToCharT>
+  inline ToCharT* valid_recode(Tag, Tag, const CharT* first, const CharT* last,
+    ToCharT* out) BOOST_NOEXCEPT
+  {
+    for (; first != last; ++first)
+      *out++ = static_cast<ToCharT>(*first);
+    return out;
+  }
+
+  //  the same code unit type is copied by the string's own constructor
+  template <class ToCharT, class CharT>
+  inline std::basic_string<ToCharT> validated_copy(std::true_type, const CharT* first,
+    const CharT* last)
+  {
+    return std::basic_string<ToCharT>(first, last);
+  }
+  template <class ToCharT, class CharT>
+  inline std::basic_string<ToCharT> validated_copy(std::false_type, const CharT* first,
+    const CharT* last)
+  {
+    using from_tag = typename utf_encoding<CharT>::tag;
+    using to_tag = typename utf_encoding<ToCharT>::tag;
+
+    std::basic_string<ToCharT> tmp;
+    tmp.resize(valid_length(from_tag(), to_tag(), first, last));
+    if (!tmp.empty())
+      valid_recode(from_tag(), to_tag(), first, last, &tmp[0]);
+    return tmp;
+  }
+
+  template <class ToEncoding, class FromEncoding>
+  inline std::basic_string<typename ToEncoding::value_type>
+    validated_to_string(const validated_view<FromEncoding>& v)
+  {
+    using to_char = typename ToEncoding::value_type;
+
+    std::basic_string<to_char> tmp = validated_copy<to_char>(
+      std::is_same<to_char, typename FromEncoding::value_type>(), v.begin(), v.end());
+    BOOST_UNICODE_COUNT(bytes_in, v.size() * sizeof(typename FromEncoding::value_type));
+    BOOST_UNICODE_COUNT(bytes_out, tmp.size() * sizeof(to_char));
+    return tmp;
+  }
+}  // namespace detail
+
+  template <class Encoding>
+  inline validated_view<Encoding>::validated_view(view_type v, assume_valid_t) noexcept
+    : v_(v)
+  {
+    BOOST_ASSERT(detail::first_ill_formed(v.cbegin(), v.cend(),
+      typename detail::utf_encoding<value_type>::tag()).first == v.cend());
+  }
+
+  inline validated_view<utf8> validate(boost::string_view v) BOOST_NOEXCEPT
+  {
+    const char* err = detail::first_ill_formed(v.cbegin(), v.cend(), utf8()).first;
+    return validated_view<utf8>(v.substr(0, err - v.cbegin()), assume_valid);
+  }
+  inline validated_view<utf16> validate(boost::u16string_view v) BOOST_NOEXCEPT
+  {
+    const char16_t* err = detail::first_ill_formed(v.cbegin(), v.cend(), utf16()).first;
+    return validated_view<utf16>(v.substr(0, err - v.cbegin()), assume_valid);
+  }
+  inline validated_view<utf32> validate(boost::u32string_view v) BOOST_NOEXCEPT
+  {
+    const char32_t* err = detail::first_ill_formed(v.cbegin(), v.cend(), utf32()).first;
+    return validated_view<utf32>(v.substr(0, err - v.cbegin()), assume_valid);
+  }
+  inline validated_view<wide> validate(boost::wstring_view v) BOOST_NOEXCEPT
+  {
+    const wchar_t* err = detail::first_ill_formed(v.cbegin(), v.cend(),
+      BOOST_UNICODE_WIDE_UTF()).first;
+    return validated_view<wide>(v.substr(0, err - v.cbegin()), assume_valid);
+  }
+
+  template <class ToEncoding, class FromEncoding>
+  inline std::basic_string<typename ToEncoding::value_type>
+    to_string(const validated_view<FromEncoding>& v)
+  {
+    static_assert(std::is_same<ToEncoding, utf8>::value
+      || std::is_same<ToEncoding, utf16>::value
+      || std::is_same<ToEncoding, utf32>::value
+      || std::is_same<ToEncoding, wide>::value,
+      "ToEncoding must be utf8, utf16, utf32, or wide");
+
+    if (conversion_observer* observer = get_conversion_observer())
+    {
+      detail::trace_scope trace(observer, conversion::to_string,
+        detail::encoding_name(FromEncoding()), detail::encoding_name(ToEncoding()),
+        v.size() * sizeof(typename FromEncoding::value_type));
+      auto tmp = detail::validated_to_string<ToEncoding>(v);
+      trace.finish(tmp.size() * sizeof(typename ToEncoding::value_type));
+      return tmp;
+    }
+    return detail::validated_to_string<ToEncoding>(v);
+  }
+
+  template <class ToEncoding, class FromEncoding>
+  inline validated_view<ToEncoding> to_view(const validated_view<FromEncoding>& v)
+    BOOST_NOEXCEPT
+  {
+    static_assert(std::is_same<ToEncoding, FromEncoding>::value,
+      "to_view() is the identity conversion; use to_string() to convert");
+    return v;
+  }
+
+}  // namespace unicode
+}  // namespace boost
+
+#endif  // BOOST_UNICODE_VALIDATED_VIEW_HPP
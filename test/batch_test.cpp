@@ -0,0 +1,116 @@
+﻿//  unicode/test/batch_test.cpp  -------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/batch.hpp>
+#include <boost/unicode/detail/utf8_codecvt_facet.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::wstring;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  struct err16 { const char16_t* operator()() const { return u"*ill*"; } };
+
+  //  a longer replacement each call, as a stateful handler might give
+  struct growing16
+  {
+    std::shared_ptr<u16string> s = std::make_shared<u16string>();
+    const char16_t* operator()() const { s->append(u"<>"); return s->c_str(); }
+  };
+
+  const std::vector<string> u8strs = { u8"$€𐐷𤭢", "", "abc", "a\xE2\x82" "b\xFF",
+    u8"ⅠⅡⅢⅣⅤⅥⅦⅧⅨⅩ", "\xED\xA0\x80" };
+
+  template <class View, class Batch>
+  void check_batch(const std::vector<View>& expected, const Batch& batch)
+  {
+    BOOST_TEST_EQ(batch.size(), expected.size());
+    BOOST_TEST_EQ(batch.offsets().size(), expected.size() + 1);
+    BOOST_TEST_EQ(batch.offsets().back(), batch.data().size());
+    for (std::size_t i = 0; i < expected.size() && i < batch.size(); ++i)
+      BOOST_TEST(batch[i] == expected[i]);
+  }
+
+  void utf_test()
+  {
+    cout << "utf_test" << endl;
+
+    std::vector<boost::string_view> views(u8strs.cbegin(), u8strs.cend());
+
+    std::vector<u16string> e16;
+    std::vector<u32string> e32;
+    std::vector<wstring> ew;
+    std::vector<u16string> e16_err;
+    for (auto& s : u8strs)
+    {
+      e16.push_back(to_string<utf16>(s));
+      e32.push_back(to_string<utf32>(s));
+      ew.push_back(to_string<wide>(s));
+      e16_err.push_back(to_string<utf16>(s, err16()));
+    }
+
+    check_batch(e16, recode_batch<utf8, utf16>(views.cbegin(), views.cend()));
+    check_batch(e32, recode_batch<utf8, utf32>(u8strs.cbegin(), u8strs.cend()));
+    check_batch(ew, recode_batch<utf8, wide>(views.cbegin(), views.cend()));
+    check_batch(e16_err,
+      recode_batch<utf8, utf16>(views.cbegin(), views.cend(), err16()));
+
+    //  called once per error, not again for sizing
+    growing16 grow;
+    auto g = recode_batch<utf8, utf16>(views.cbegin(), views.cend(), grow);
+    BOOST_TEST(g[3] == u"a<>b<><>");
+    BOOST_TEST(g[5] == u"<><><>");
+    BOOST_TEST_EQ(g.offsets().back(), g.data().size());
+
+    std::vector<string> e8;
+    for (auto& s : e32)
+      e8.push_back(to_string<utf8>(s));
+    check_batch(e8, recode_batch<utf32, utf8>(e32.cbegin(), e32.cend()));
+
+    auto empty = recode_batch<utf8, utf16>(views.cend(), views.cend());
+    BOOST_TEST(empty.empty());
+    BOOST_TEST(empty.data().empty());
+
+    cout << "  utf_test done" << endl;
+  }
+
+  void narrow_test()
+  {
+    cout << "narrow_test" << endl;
+
+    detail::utf8_codecvt_facet ccvt(0);
+    std::vector<string> valid = { u8"$€𐐷𤭢", "", u8"ⅠⅡⅢⅣⅤⅥⅦⅧⅨⅩ" };
+    std::vector<u16string> e16;
+    for (auto& s : valid)
+      e16.push_back(to_string<utf16>(s));
+
+    check_batch(e16, recode_batch<narrow, utf16>(valid.cbegin(), valid.cend(), ccvt));
+
+    cout << "  narrow_test done" << endl;
+  }
+
+}  // unnamed namespace
+
+int main()
+{
+  utf_test();
+  narrow_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,127 @@
+﻿//  unicode/test/boundary_test.cpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/boundary.hpp>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::wstring;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  const boost::string_view     u8str(u8"$€𐐷𤭢");  // 1 + 3 + 4 + 4 octets
+  const boost::u16string_view  u16str(u"$€𐐷𤭢"); // 1 + 1 + 2 + 2 code units
+  const boost::u32string_view  u32str(U"$€𐐷𤭢");
+
+  void utf8_test()
+  {
+    cout << "utf8_test" << endl;
+
+    const std::size_t floor8[] = {0, 1, 1, 1, 4, 4, 4, 4, 8, 8, 8, 8, 12, 12};
+    const std::size_t ceil8[]  = {0, 1, 4, 4, 4, 8, 8, 8, 8, 12, 12, 12, 12, 12};
+    for (std::size_t i = 0; i < 14; ++i)
+    {
+      BOOST_TEST_EQ(floor_boundary(u8str, i), floor8[i]);
+      BOOST_TEST_EQ(ceil_boundary(u8str, i), ceil8[i]);
+    }
+
+    BOOST_TEST(truncate_to_units(u8str, 7) == u8"$€");
+    BOOST_TEST(is_well_formed(truncate_to_units(u8str, 7)));
+    BOOST_TEST(truncate_to_units(u8str, 0).empty());
+    BOOST_TEST(truncate_to_units(u8str, 100) == u8str);
+
+    //  stray and truncated sequences
+    const boost::string_view stray("a\x80\x80\x80\x80\x80" "b");
+    for (std::size_t i = 0; i < stray.size(); ++i)
+      BOOST_TEST_EQ(floor_boundary(stray, i), i);
+    const boost::string_view truncated("a\xE2\x82" "b");
+    BOOST_TEST_EQ(floor_boundary(truncated, 2), 1u);
+    BOOST_TEST_EQ(ceil_boundary(truncated, 2), 3u);
+    BOOST_TEST_EQ(floor_boundary(truncated, 3), 3u);
+
+    cout << "  utf8_test done" << endl;
+  }
+
+  void utf16_utf32_test()
+  {
+    cout << "utf16_utf32_test" << endl;
+
+    const std::size_t floor16[] = {0, 1, 2, 2, 4, 4, 6};
+    const std::size_t ceil16[]  = {0, 1, 2, 4, 4, 6, 6};
+    for (std::size_t i = 0; i < 7; ++i)
+    {
+      BOOST_TEST_EQ(floor_boundary(u16str, i), floor16[i]);
+      BOOST_TEST_EQ(ceil_boundary(u16str, i), ceil16[i]);
+    }
+    BOOST_TEST(truncate_to_units(u16str, 5) == u"$€𐐷");
+
+    //  unpaired surrogates are not split from anything
+    const boost::u16string_view unpaired(u"a\xDC00" u"b");
+    BOOST_TEST_EQ(floor_boundary(unpaired, 1), 1u);
+
+    for (std::size_t i = 0; i < 5; ++i)
+      BOOST_TEST_EQ(floor_boundary(u32str, i), i);
+
+    cout << "  utf16_utf32_test done" << endl;
+  }
+
+  template <class View>
+  void check_chunks(View v, std::size_t target_size)
+  {
+    auto chunks = split_into_chunks(v, target_size);
+    std::basic_string<typename View::value_type> joined;
+    for (auto chunk : chunks)
+    {
+      BOOST_TEST(is_well_formed(chunk));
+      BOOST_TEST(!chunk.empty());
+      joined.append(chunk.data(), chunk.size());
+    }
+    BOOST_TEST(joined == v);
+  }
+
+  void split_test()
+  {
+    cout << "split_test" << endl;
+
+    string s;
+    for (int i = 0; i < 25; ++i)
+      s += u8"x€𐐷𤭢";
+    u16string s16 = to_string<utf16>(s);
+
+    for (std::size_t target : {1u, 2u, 3u, 5u, 16u, 1000u})
+    {
+      check_chunks(boost::string_view(s), target);
+      check_chunks(boost::u16string_view(s16), target);
+    }
+
+    auto chunks = split_into_chunks(boost::string_view(s), 16);
+    for (std::size_t i = 0; i + 1 < chunks.size(); ++i)
+      BOOST_TEST(chunks[i].size() <= 16 && chunks[i].size() > 12);
+    BOOST_TEST(split_into_chunks(boost::string_view(), 8).empty());
+
+    cout << "  split_test done" << endl;
+  }
+
+}  // unnamed namespace
+
+int main()
+{
+  utf8_test();
+  utf16_utf32_test();
+  split_test();
+
+  return boost::report_errors();
+}
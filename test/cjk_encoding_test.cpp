@@ -0,0 +1,272 @@
+﻿//  unicode/test/cjk_encoding_test.cpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/cjk_encoding.hpp>
+#include <boost/unicode/iconv_codecvt.hpp>
+#include <boost/unicode/trace.hpp>
+#include <iterator>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  const string    u8s(u8"a日本語中文");
+  const u16string u16s(u"a日本語中文");
+  const u32string u32s(U"a日本語中文");
+  const wstring     ws(L"a日本語中文");
+
+  template <class Encoding>
+  u32string decode(const string& s)
+  {
+    u32string u;
+    recode<Encoding, utf32>(s.cbegin(), s.cend(), std::back_inserter(u));
+    return u;
+  }
+
+  template <class Encoding>
+  string encode(const u32string& u)
+  {
+    string s;
+    recode<utf32, Encoding>(u.cbegin(), u.cend(), std::back_inserter(s));
+    return s;
+  }
+
+  template <class Encoding>
+  void encoding_test(const string& octets)
+  {
+    BOOST_TEST(decode<Encoding>(octets) == u32s);
+    BOOST_TEST_EQ(encode<Encoding>(u32s), octets);
+
+    BOOST_TEST_EQ(to_string<Encoding>(u8s), octets);
+    BOOST_TEST_EQ(to_string<Encoding>(u16s), octets);
+    BOOST_TEST_EQ(to_string<Encoding>(u32s), octets);
+    BOOST_TEST_EQ(to_string<Encoding>(ws), octets);
+
+    string s8;
+    recode<Encoding, utf8>(octets.cbegin(), octets.cend(), std::back_inserter(s8));
+    BOOST_TEST_EQ(s8, u8s);
+    u16string s16;
+    recode<Encoding, utf16>(octets.cbegin(), octets.cend(), std::back_inserter(s16));
+    BOOST_TEST(s16 == u16s);
+    wstring sw;
+    recode<Encoding, wide>(octets.cbegin(), octets.cend(), std::back_inserter(sw));
+    BOOST_TEST(sw == ws);
+  }
+
+  void encoding_test()
+  {
+    cout << "encoding_test" << endl;
+
+    encoding_test<shift_jis>("a\x93\xFA\x96\x7B\x8C\xEA\x92\x86\x95\xB6");
+    encoding_test<gb18030>("a\xC8\xD5\xB1\xBE\xD5\x5A\xD6\xD0\xCE\xC4");
+    encoding_test<big5>("a\xA4\xE9\xA5\xBB\xBB\x79\xA4\xA4\xA4\xE5");
+    encoding_test<euc_kr>("a\xEC\xED\xDC\xE2\xE5\xDE\xF1\xE9\xD9\xFE");
+
+    //  GB18030 four-octet sequences, in and beyond the BMP
+    BOOST_TEST(decode<gb18030>("\x81\x30\x81\x30" "\x94\x39\xFC\x36")
+      == U"\u0080\U0001F600");
+    BOOST_TEST_EQ(encode<gb18030>(U"\u0080\U0001F600�"),
+      "\x81\x30\x81\x30" "\x94\x39\xFC\x36" "\x84\x31\xA4\x37");
+
+    //  from one to another
+    string sjis;
+    const string gb("a\xC8\xD5\xB1\xBE\xD5\x5A\xD6\xD0\xCE\xC4");
+    recode<gb18030, shift_jis>(gb.cbegin(), gb.cend(), std::back_inserter(sjis));
+    BOOST_TEST_EQ(sjis, "a\x93\xFA\x96\x7B\x8C\xEA\x92\x86\x95\xB6");
+
+    //  traced by name
+    struct : conversion_observer
+    {
+      string from, to;
+      void conversion_end(const conversion_event& e, std::chrono::nanoseconds)
+        BOOST_NOEXCEPT override
+      {
+        from = e.from;
+        to = e.to;
+      }
+    } observer;
+    set_conversion_observer(&observer);
+    to_string<big5>(u16s);
+    set_conversion_observer(nullptr);
+    BOOST_TEST_EQ(observer.from, "utf16");
+    BOOST_TEST_EQ(observer.to, "big5");
+
+    cout << "  encoding_test done" << endl;
+  }
+
+  void error_test()
+  {
+    cout << "error_test" << endl;
+
+    //  an unmapped pair is one replacement; an ASCII trail is decoded by itself
+    BOOST_TEST(decode<shift_jis>("a\x85\x9Fz") == U"a�z");
+    BOOST_TEST(decode<shift_jis>("a\x85\x40z") == U"a�@z");
+    BOOST_TEST(decode<shift_jis>("a\x93") == U"a�");
+    BOOST_TEST(decode<big5>("\xA4") == U"�");
+    BOOST_TEST(decode<euc_kr>("\xB0\xA1\xB0") == U"가�");
+    BOOST_TEST(decode<gb18030>("\x80\xFF") == U"��");
+
+    //  a malformed four-octet sequence is the lead octet alone; a truncated one is
+    //  all that remains; an unmapped one is all four octets
+    BOOST_TEST(decode<gb18030>("\x81\x30z") == U"�0z");
+    BOOST_TEST(decode<gb18030>("\x81\x30\x81 ") == U"�0� ");
+    BOOST_TEST(decode<gb18030>("\x81\x30") == U"�");
+    BOOST_TEST(decode<gb18030>("\x81\x30\x81") == U"�");
+    BOOST_TEST(decode<gb18030>("\x84\x31\xA5\x30" "a") == U"�a");
+    BOOST_TEST(decode<gb18030>("\xE4\x30\x81\x30" "a") == U"�a");
+
+    //  the error handler of the output
+    u16string u16;
+    const string ill("a\x85\x9F");
+    recode<shift_jis, utf16>(ill.cbegin(), ill.cend(), std::back_inserter(u16),
+      []() { return u"<>"; });
+    BOOST_TEST(u16 == u"a<>");
+
+    //  not representable, or not a code point
+    BOOST_TEST_EQ(encode<shift_jis>(U"aÅb"), "a?b");
+    BOOST_TEST_EQ(encode<euc_kr>(U"\U0001F600"), "?");
+    BOOST_TEST_EQ(encode<big5>(u32string(1, char32_t(0xD800))), "?");
+    BOOST_TEST_EQ(encode<gb18030>(u32string(1, char32_t(0x110000))), "\x84\x31\xA4\x37");
+    BOOST_TEST_EQ(to_string<big5>(u16string(u"aÅ"), ufffd<char>()), "a\xEF\xBF\xBD");
+    BOOST_TEST_EQ(to_string<euc_kr>(string("a\xFF")), "a?");
+
+    string s;
+    const string gb("\xC8\xD5\x81\x30\x81\x30");
+    recode<gb18030, shift_jis>(gb.cbegin(), gb.cend(), std::back_inserter(s),
+      []() { return "*"; });
+    BOOST_TEST_EQ(s, "\x93\xFA*");
+
+    cout << "  error_test done" << endl;
+  }
+
+  //  iconv()'s decoding of s: its one code point, or 0xFFFFFFFF if none
+  char32_t iconv_decode(const iconv_codecvt<char32_t>& ccvt, const string& s)
+  {
+    std::mbstate_t state = std::mbstate_t();
+    const char* from_next;
+    char32_t buf[4];
+    char32_t* to_next;
+    if (ccvt.in(state, s.data(), s.data() + s.size(), from_next, buf, buf + 4, to_next)
+      != std::codecvt_base::ok || to_next - buf != 1)
+      return 0xFFFFFFFF;
+    return buf[0];
+  }
+
+  //  iconv()'s encoding of cp, or the empty string if it has none
+  string iconv_encode(const iconv_codecvt<char32_t>& ccvt, char32_t cp)
+  {
+    std::mbstate_t state = std::mbstate_t();
+    const char32_t* from_next;
+    char buf[8];
+    char* to_next;
+    if (ccvt.out(state, &cp, &cp + 1, from_next, buf, buf + 8, to_next)
+      != std::codecvt_base::ok)
+      return string();
+    return string(buf, to_next);
+  }
+
+  //  every one- and two-octet sequence, and every code point, against iconv()
+  template <class Encoding>
+  void iconv_test(const char* name, char32_t last_cp)
+  {
+    const iconv_codecvt<char32_t> ccvt(name);
+    int decode_errors = 0;
+    for (unsigned b = 0; b < 256; ++b)
+    {
+      for (unsigned t = 0; t < 256; ++t)
+      {
+        const string s = t == 0 ? string(1, char(b)) : string(1, char(b)) + char(t);
+        const char32_t expected = iconv_decode(ccvt, s);
+        if (expected == 0xFFFFFFFF)
+          continue;
+        const u32string u = decode<Encoding>(s);
+        if (u.size() != 1 || u[0] != expected)
+          ++decode_errors;
+      }
+    }
+    BOOST_TEST_EQ(decode_errors, 0);
+
+    int encode_errors = 0;
+    for (char32_t cp = 0; cp <= last_cp; ++cp)
+    {
+      if (cp >= 0xD800 && cp <= 0xDFFF)
+        continue;
+      string expected = iconv_encode(ccvt, cp);
+      string s;
+      recode<utf32, Encoding>(&cp, &cp + 1, std::back_inserter(s),
+        []() { return ""; });
+      if (s != expected)
+        ++encode_errors;
+    }
+    BOOST_TEST_EQ(encode_errors, 0);
+  }
+
+  void iconv_test()
+  {
+    cout << "iconv_test" << endl;
+
+    iconv_test<shift_jis>("CP932", 0x1FFFF);
+    iconv_test<big5>("BIG5", 0x1FFFF);
+    iconv_test<euc_kr>("EUC-KR", 0x1FFFF);
+    iconv_test<gb18030>("GB18030", 0x10FFFF);
+
+    //  every GB18030 four-octet sequence below the supplementary planes
+    const iconv_codecvt<char32_t> ccvt("GB18030");
+    int errors = 0;
+    for (unsigned b1 = 0x81; b1 <= 0x8F; ++b1)
+      for (unsigned b2 = 0x30; b2 <= 0x39; ++b2)
+        for (unsigned b3 = 0x81; b3 <= 0xFE; ++b3)
+          for (unsigned b4 = 0x30; b4 <= 0x39; ++b4)
+          {
+            const string s{ char(b1), char(b2), char(b3), char(b4) };
+            const char32_t expected = iconv_decode(ccvt, s);
+            const u32string u = decode<gb18030>(s);
+            if (expected == 0xFFFFFFFF ? u != U"�" : u != u32string(1, expected))
+              ++errors;
+          }
+    BOOST_TEST_EQ(errors, 0);
+
+    cout << "  iconv_test done" << endl;
+  }
+
+  void round_trip_test()
+  {
+    cout << "round_trip_test" << endl;
+
+    //  GB18030 encodes every code point
+    for (int m = 0; m < static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      const string gb = to_string<gb18030>(c.utf8);
+      BOOST_TEST(decode<gb18030>(gb) == c.utf32);
+      BOOST_TEST_EQ(to_string<gb18030>(c.utf16), gb);
+    }
+
+    cout << "  round_trip_test done" << endl;
+  }
+}
+
+int main()
+{
+  encoding_test();
+  error_test();
+  iconv_test();
+  round_trip_test();
+
+  return boost::report_errors();
+}
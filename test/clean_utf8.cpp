@@ -8,7 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include "../include/boost/unicode/string_encoding.hpp"
+#include "../include/boost/unicode/sanitize.hpp"
 #include <boost/detail/lightweight_main.hpp>
 
 using std::cout;
@@ -16,7 +16,6 @@ using std::cerr;
 using std::endl;
 using std::string;
 using std::getline;
-using boost::unicode::utf8;
 
 namespace
 {
@@ -47,8 +46,8 @@ int cpp_main(int argc, char* argv[])
   while (in.good())
   {
     getline(in, line);
-    string cleaned_line = boost::unicode::to_string<utf8, utf8>(line);
-    cout << cleaned_line << '\n';
+    boost::unicode::sanitize_in_place(line);
+    cout << line << '\n';
   }
 
   if (!in.eof())
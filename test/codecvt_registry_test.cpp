@@ -0,0 +1,128 @@
+﻿//  unicode/test/codecvt_registry_test.cpp  --------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/codecvt_registry.hpp>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  //  the first UTF-8 locale installed, or null
+  const char* utf8_locale_name()
+  {
+    for (const char* name : {"C.UTF-8", "C.utf8", "en_US.UTF-8"})
+    {
+      try { std::locale loc(name); return name; }
+      catch (const std::runtime_error&) {}
+    }
+    return nullptr;
+  }
+
+  void lookup_test()
+  {
+    cout << "lookup_test" << endl;
+
+    codecvt_registry registry;
+    BOOST_TEST_EQ(registry.size(), 0u);
+    const std::locale& loc = registry.locale("C");
+    BOOST_TEST_EQ(loc.name(), "C");
+    BOOST_TEST_EQ(&registry.locale("C"), &loc);
+    BOOST_TEST_EQ(&registry.locale(string("C")), &loc);
+    BOOST_TEST_EQ(&registry.wide_codecvt("C"),
+      &std::use_facet<codecvt_registry::wide_codecvt_type>(loc));
+    BOOST_TEST_EQ(registry.size(), 1u);
+
+    BOOST_TEST_THROWS(registry.locale("no such locale"), std::runtime_error);
+    BOOST_TEST_THROWS(registry.wide_codecvt("no such locale"), std::runtime_error);
+    BOOST_TEST_EQ(registry.size(), 1u);
+
+    cout << "  lookup_test done" << endl;
+  }
+
+  void thread_test()
+  {
+    cout << "thread_test" << endl;
+
+    //  every thread must see the one entry, whichever thread constructed it
+    codecvt_registry registry;
+    const char* const names[] = { "C", "POSIX", utf8_locale_name() };
+    const codecvt_registry::wide_codecvt_type* seen[4][3] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&, t]()
+      {
+        for (int i = 0; i < 1000; ++i)
+          for (int n = 0; n < 3; ++n)
+            if (names[n])
+              seen[t][n] = &registry.wide_codecvt(names[n]);
+      });
+    for (auto& t : threads)
+      t.join();
+
+    for (int n = 0; n < 3; ++n)
+      for (int t = 0; t < 4; ++t)
+        BOOST_TEST_EQ(seen[t][n], seen[0][n]);
+    BOOST_TEST_EQ(registry.size(), names[2] ? 3u : 2u);
+
+    cout << "  thread_test done" << endl;
+  }
+
+  void to_string_test()
+  {
+    cout << "to_string_test" << endl;
+
+    BOOST_TEST_EQ(to_string<narrow>(wstring(L"abc"), "C"), "abc");
+    BOOST_TEST(to_string<wide>(boost::string_view("abc"), "C") == L"abc");
+    BOOST_TEST_EQ(to_string<narrow>(boost::string_view("abc"), "C", "C"), "abc");
+
+    if (const char* name = utf8_locale_name())
+    {
+      const string     u8s(u8"$€Ꭶ❄");
+      const u16string u16s(u"$€Ꭶ❄");
+      const u32string u32s(U"$€Ꭶ❄");
+      const wstring     ws(L"$€Ꭶ❄");
+      const codecvt_registry::wide_codecvt_type& ccvt
+        = codecvt_registry::global().wide_codecvt(name);
+
+      BOOST_TEST_EQ(to_string<narrow>(ws, name), to_string<narrow>(ws, ccvt));
+      BOOST_TEST_EQ(to_string<narrow>(u16s, name), u8s);
+      BOOST_TEST_EQ(to_string<narrow>(u32s, name, ufffd<char>()), u8s);
+      BOOST_TEST(to_string<wide>(boost::string_view(u8s), name) == ws);
+      BOOST_TEST(to_string<utf16>(boost::string_view(u8s), name) == u16s);
+      BOOST_TEST_EQ(to_string<narrow>(boost::string_view(u8s), name, name), u8s);
+    }
+    else
+      cout << "  no UTF-8 locale installed; skipping UTF-8 locale tests" << endl;
+
+    BOOST_TEST_THROWS(to_string<narrow>(wstring(L"abc"), "no such locale"),
+      std::runtime_error);
+
+    cout << "  to_string_test done" << endl;
+  }
+}
+
+int main()
+{
+  lookup_test();
+  thread_test();
+  to_string_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,124 @@
+﻿//  unicode/test/corpus_test.cpp  ------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  The benchmark corpus generator is exercised here because tests use it too: every
+//  encoding of a corpus must decode to the same code points, with one U+FFFD per error.
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <algorithm>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::u32string;
+
+namespace
+{
+  void check_corpus(const bench::corpus& c)
+  {
+    u32string expected = to_string<utf32>(c.utf32);
+    BOOST_TEST_EQ(expected.size(), c.code_points);
+    BOOST_TEST_EQ(static_cast<std::size_t>(
+      std::count(expected.begin(), expected.end(), U'�')), c.errors);
+
+    BOOST_TEST(to_string<utf32>(c.utf8) == expected);
+    BOOST_TEST(to_string<utf32>(c.utf16) == expected);
+    BOOST_TEST(to_string<utf32>(c.wide) == expected);
+
+    BOOST_TEST_EQ(count_code_points(c.utf8), c.code_points);
+    BOOST_TEST_EQ(count_code_points(c.utf16), c.code_points);
+    BOOST_TEST_EQ(count_code_points(c.utf32), c.code_points);
+    BOOST_TEST_EQ(is_well_formed(c.utf8), c.errors == 0);
+    BOOST_TEST_EQ(is_well_formed(c.utf16), c.errors == 0);
+  }
+
+  void determinism_test()
+  {
+    cout << "determinism_test" << endl;
+
+    bench::corpus_spec spec = bench::preset(bench::mix::errors, 5000);
+    bench::corpus a = bench::generate(spec);
+    bench::corpus b = bench::generate(spec);
+    BOOST_TEST(a.utf8 == b.utf8);
+    BOOST_TEST(a.utf16 == b.utf16);
+    BOOST_TEST(a.utf32 == b.utf32);
+    BOOST_TEST(a.wide == b.wide);
+    BOOST_TEST_EQ(a.errors, b.errors);
+
+    ++spec.seed;
+    BOOST_TEST(bench::generate(spec).utf32 != a.utf32);
+
+    cout << "  determinism_test done" << endl;
+  }
+
+  void script_test()
+  {
+    cout << "script_test" << endl;
+
+    const std::size_t octets[] = { 1, 2, 2, 3, 4 };
+    for (std::size_t i = 0; i < bench::script_count; ++i)
+    {
+      bench::corpus_spec spec;
+      spec.code_points = 1000;
+      spec.script_weights.fill(0);
+      spec.script_weights[i] = 1;
+      bench::corpus c = bench::generate(spec);
+      BOOST_TEST_EQ(c.utf8.size(), octets[i] * spec.code_points);
+      BOOST_TEST_EQ(c.errors, 0u);
+      check_corpus(c);
+    }
+
+    cout << "  script_test done" << endl;
+  }
+
+  void error_kind_test()
+  {
+    cout << "error_kind_test" << endl;
+
+    for (std::size_t k = 0; k < bench::error_kind_count; ++k)
+    {
+      bench::corpus_spec spec;
+      spec.code_points = 2000;
+      spec.script_weights = {{4, 1, 1, 1, 1}};
+      spec.min_run = 1;
+      spec.max_run = 8;
+      spec.error_rate = 0.2;
+      spec.error_weights.fill(0);
+      spec.error_weights[k] = 1;
+      bench::corpus c = bench::generate(spec);
+      BOOST_TEST(c.errors > 0u);
+      check_corpus(c);
+    }
+
+    cout << "  error_kind_test done" << endl;
+  }
+
+  void preset_test()
+  {
+    cout << "preset_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+      check_corpus(bench::make_corpus(static_cast<bench::mix>(m), 4096));
+
+    cout << "  preset_test done" << endl;
+  }
+}
+
+int main()
+{
+  determinism_test();
+  script_test();
+  error_kind_test();
+  preset_test();
+
+  return boost::report_errors();
+}
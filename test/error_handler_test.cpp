@@ -151,6 +151,26 @@ namespace
     BOOST_TEST((to_string<utf16>("\xed\xa0\x80", err16()) == u"*ill*"));
     BOOST_TEST((to_string<utf16>("\xed\xa0\x80", err16nul()) == u""));
 
+    //  overlong sequences, each replaced once, and the shortest form on either side
+    BOOST_TEST((to_string<utf32>("\xC0\x80") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xC1\xBF") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xC2\x80") == U"\u0080"));
+    BOOST_TEST((to_string<utf32>("\xE0\x80\x80") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xE0\x9F\xBF") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xE0\xA0\x80") == U"\u0800"));
+    BOOST_TEST((to_string<utf32>("\xF0\x80\x80\x80") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xF0\x8F\xBF\xBF") == U"\uFFFD"));
+    BOOST_TEST((to_string<utf32>("\xF0\x90\x80\x80") == U"\U00010000"));
+    BOOST_TEST((to_string<utf16>("$\xE0\x80\xAF$", err16()) == u"$*ill*$"));
+    BOOST_TEST((to_string<utf8>("$\xC0\xAF$", err8nul()) == u8"$$"));
+    {
+      const char overlong[] = "\xE0\x81\x81";
+      const char* first = overlong;
+      char32_t u32;
+      BOOST_TEST(!boost::unicode::detail::utf8_decode_branchy(first, overlong + 3, u32));
+      BOOST_TEST(first == overlong + 3);
+    }
+
     BOOST_TEST((to_string<wide>(ill_u8str, errwnul()) == wstr));
     BOOST_TEST((to_string<utf8>(ill_u8str, err8nul()) == u8str));
     //cout << hex_string(u8str) << endl;
@@ -55,6 +55,7 @@ namespace
       first_code_unit = first;
       bool error = false;
       unsigned octet = static_cast<unsigned char>(*first++);
+      const unsigned first_octet = octet;
       
       if (octet <= 0x7Fu)
         continue;  // 7-bit ASCII so nothing further to do
@@ -140,10 +141,11 @@ namespace
           }
         }
       }
-      else if (octet >= 0xF1u && octet <= 0xF4u)  // four octets case two
+      else if (octet >= 0xF1u && octet <= 0xF4u)  // four octets cases two and three
       {
         if (first == last  // octet two is invalid
-            || (octet = static_cast<unsigned char>(*first)) < 0x80u || octet > 0xBFu)
+            || (octet = static_cast<unsigned char>(*first)) < 0x80u
+            || octet > (first_octet == 0xF4u ? 0x8Fu : 0xBFu))
           error = true;  // octet two is invalid
         else
         {
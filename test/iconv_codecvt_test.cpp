@@ -0,0 +1,255 @@
+﻿//  unicode/test/iconv_codecvt_test.cpp  -----------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/iconv_codecvt.hpp>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  using result = std::codecvt_base::result;
+
+  const u16string u16s(u"a日本語中文");
+  const u32string u32s(U"a日本語中文");
+  const wstring     ws(L"a日本語中文");
+
+  void encoding_test()
+  {
+    cout << "encoding_test" << endl;
+
+    struct { const char* name; string octets; } const encodings[] =
+    {
+      { "SJIS",    "a\x93\xFA\x96\x7B\x8C\xEA\x92\x86\x95\xB6" },
+      { "GB18030", "a\xC8\xD5\xB1\xBE\xD5\x5A\xD6\xD0\xCE\xC4" },
+      { "BIG5",    "a\xA4\xE9\xA5\xBB\xBB\x79\xA4\xA4\xA4\xE5" },
+      { "EUC-KR",  "a\xEC\xED\xDC\xE2\xE5\xDE\xF1\xE9\xD9\xFE" },
+    };
+    for (const auto& e : encodings)
+    {
+      iconv_codecvt<char32_t> ccvt32(e.name);
+      iconv_codecvt<wchar_t> wccvt(e.name);
+      BOOST_TEST_EQ(ccvt32.name(), e.name);
+      BOOST_TEST_EQ(to_string<narrow>(u16s, wccvt), e.octets);
+      BOOST_TEST_EQ(to_string<narrow>(u32s, ccvt32), e.octets);
+      BOOST_TEST_EQ(to_string<narrow>(ws, wccvt), e.octets);
+      BOOST_TEST(to_string<utf16>(boost::string_view(e.octets), ccvt32) == u16s);
+      BOOST_TEST(to_string<utf32>(boost::string_view(e.octets), ccvt32) == u32s);
+      BOOST_TEST(to_string<wide>(boost::string_view(e.octets), wccvt) == ws);
+      BOOST_TEST_EQ(to_string<utf8>(boost::string_view(e.octets), wccvt),
+        to_string<utf8>(u16s));
+    }
+
+    //  a supplementary character, one UTF-16 surrogate pair
+    iconv_codecvt<char16_t> gb18030("GB18030");
+    std::mbstate_t state = std::mbstate_t();
+    const char gb[] = "\x94\x39\xFC\x36";
+    const char16_t pair[] = u"\U0001F600";
+    const char* from_next;
+    char16_t u16buf[2];
+    char16_t* u16_next;
+    BOOST_TEST_EQ(gb18030.in(state, gb, gb + 4, from_next, u16buf, u16buf + 2, u16_next),
+      std::codecvt_base::ok);
+    BOOST_TEST(u16string(u16buf, u16_next) == pair);
+    BOOST_TEST_EQ(gb18030.in(state, gb, gb + 4, from_next, u16buf, u16buf + 1, u16_next),
+      std::codecvt_base::partial);
+    BOOST_TEST_EQ(u16_next - u16buf, 0);
+    const char16_t* pair_next;
+    char octets[4];
+    char* octets_next;
+    BOOST_TEST_EQ(gb18030.out(state, pair, pair + 2, pair_next, octets, octets + 4,
+      octets_next), std::codecvt_base::ok);
+    BOOST_TEST_EQ(string(octets, octets_next), gb);
+
+    BOOST_TEST_THROWS(iconv_codecvt<wchar_t>("no such encoding"), std::system_error);
+
+    cout << "  encoding_test done" << endl;
+  }
+
+  void error_test()
+  {
+    cout << "error_test" << endl;
+
+    iconv_codecvt<char16_t> ccvt("SJIS");
+    std::mbstate_t state = std::mbstate_t();
+    char16_t buf[16];
+    const char* from_next;
+    char16_t* to_next;
+
+    const string ill_formed("ab\x85\x40z");  // 0x8540 is unassigned
+    BOOST_TEST_EQ(ccvt.in(state, ill_formed.data(), ill_formed.data() + 5, from_next,
+      buf, buf + 16, to_next), std::codecvt_base::error);
+    BOOST_TEST_EQ(from_next - ill_formed.data(), 2);
+    BOOST_TEST_EQ(to_next - buf, 2);
+
+    const string truncated("ab\x93");
+    BOOST_TEST_EQ(ccvt.in(state, truncated.data(), truncated.data() + 3, from_next,
+      buf, buf + 16, to_next), std::codecvt_base::partial);
+    BOOST_TEST_EQ(from_next - truncated.data(), 2);
+    BOOST_TEST_EQ(to_next - buf, 2);
+
+    iconv_codecvt<wchar_t> wccvt("SJIS");
+    BOOST_TEST(to_string<utf16>(boost::string_view(truncated), wccvt, ufffd<char16_t>())
+      == u"ab�");
+
+    //  not representable in Shift-JIS
+    BOOST_TEST_EQ(to_string<narrow>(u16string(u"aÅb"), wccvt, ufffd<char>()),
+      "a\xEF\xBF\xBD" "b");
+
+    cout << "  error_test done" << endl;
+  }
+
+  //  converts all of s with in(), given room for at most room code units per call
+  u32string in_chunks(const iconv_codecvt<char32_t>& ccvt, const string& s,
+    std::size_t room)
+  {
+    u32string out;
+    std::mbstate_t state = std::mbstate_t();
+    const char* from = s.data();
+    const char* from_end = s.data() + s.size();
+    while (from != from_end)
+    {
+      char32_t buf[16];
+      const char* from_next;
+      char32_t* to_next;
+      result r = ccvt.in(state, from, from_end, from_next, buf, buf + room, to_next);
+      out.append(buf, to_next);
+      if (r == std::codecvt_base::error || (r == std::codecvt_base::partial
+        && from_next == from && to_next == buf))
+        break;
+      from = from_next;
+    }
+    return out;
+  }
+
+  //  converts all of s with out(), given room for at most room octets per call
+  string out_chunks(const iconv_codecvt<char32_t>& ccvt, const u32string& s,
+    std::size_t room)
+  {
+    string out;
+    std::mbstate_t state = std::mbstate_t();
+    const char32_t* from = s.data();
+    const char32_t* from_end = s.data() + s.size();
+    while (from != from_end)
+    {
+      char buf[16];
+      const char32_t* from_next;
+      char* to_next;
+      result r = ccvt.out(state, from, from_end, from_next, buf, buf + room, to_next);
+      out.append(buf, to_next);
+      if (r == std::codecvt_base::error || (r == std::codecvt_base::partial
+        && from_next == from && to_next == buf))
+        break;
+      from = from_next;
+    }
+    return out;
+  }
+
+  void chunk_test()
+  {
+    cout << "chunk_test" << endl;
+
+    //  GB18030 encodes every code point, so each corpus round trips
+    iconv_codecvt<char32_t> ccvt("GB18030");
+    for (int m = 0; m < static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 512);
+      const string gb = to_string<narrow>(c.utf32, ccvt);
+      BOOST_TEST(to_string<utf32>(boost::string_view(gb), ccvt) == c.utf32);
+      for (std::size_t room = 4; room <= 16; ++room)
+      {
+        BOOST_TEST(in_chunks(ccvt, gb, room) == c.utf32);
+        BOOST_TEST_EQ(out_chunks(ccvt, c.utf32, room), gb);
+      }
+    }
+
+    //  a stateful encoding: each out() call must end in the initial shift state
+    iconv_codecvt<char32_t> jis("ISO-2022-JP");
+    const u32string s(U"a日本語b中文c");
+    for (std::size_t room = 8; room <= 16; ++room)  // escape, kanji, escape
+    {
+      const string octets = out_chunks(jis, s, room);
+      BOOST_TEST(to_string<utf32>(boost::string_view(octets), jis) == s);
+    }
+
+    cout << "  chunk_test done" << endl;
+  }
+
+  void length_test()
+  {
+    cout << "length_test" << endl;
+
+    iconv_codecvt<char16_t> ccvt("GB18030");
+    const string s("a\xC8\xD5\x94\x39\xFC\x36" "b\x93");
+    for (std::size_t max = 0; max <= 16; ++max)
+    {
+      std::mbstate_t state = std::mbstate_t();
+      char16_t buf[16];
+      const char* from_next;
+      char16_t* to_next;
+      ccvt.in(state, s.data(), s.data() + s.size(), from_next, buf, buf + max, to_next);
+      state = std::mbstate_t();
+      BOOST_TEST_EQ(ccvt.length(state, s.data(), s.data() + s.size(), max),
+        from_next - s.data());
+    }
+
+    cout << "  length_test done" << endl;
+  }
+
+  void thread_test()
+  {
+    cout << "thread_test" << endl;
+
+    //  one facet, converting on several threads at once
+    iconv_codecvt<wchar_t> ccvt("GB18030");
+    const bench::corpus& c = bench::get_corpus(bench::mix::mixed, 4096);
+    const string expected = to_string<narrow>(c.wide, ccvt);
+    bool ok[4] = {};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+      threads.emplace_back([&, t]()
+      {
+        ok[t] = true;
+        for (int i = 0; i < 50; ++i)
+        {
+          string s = to_string<narrow>(c.wide, ccvt);
+          ok[t] = ok[t] && s == expected
+            && to_string<wide>(boost::string_view(s), ccvt) == c.wide;
+        }
+      });
+    for (auto& t : threads)
+      t.join();
+    for (int t = 0; t < 4; ++t)
+      BOOST_TEST(ok[t]);
+
+    cout << "  thread_test done" << endl;
+  }
+}
+
+int main()
+{
+  encoding_test();
+  error_test();
+  chunk_test();
+  length_test();
+  thread_test();
+
+  return boost::report_errors();
+}
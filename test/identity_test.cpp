@@ -0,0 +1,151 @@
+﻿//  unicode/test/identity_test.cpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Recoding contiguous input to its own encoding copies well-formed runs through; the
+//  result must be exactly that of decoding and re-encoding every code point, including
+//  where errors are replaced.
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <iterator>
+#include <list>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using namespace boost::unicode::detail;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  //  a user supplied error handler, to check that it is the one called
+  template <class CharT> struct question_mark;
+  template <> struct question_mark<char>
+    { const char* operator()() const { return "?"; } };
+  template <> struct question_mark<char16_t>
+    { const char16_t* operator()() const { return u"?"; } };
+  template <> struct question_mark<char32_t>
+    { const char32_t* operator()() const { return U"?"; } };
+
+  //  the identity path, via recode(), against the code point at a time path, via a
+  //  std::list, with both string and pointer output
+  template <class Encoding, class String>
+  bool same_recoding(const String& s)
+  {
+    using char_type = typename String::value_type;
+    std::list<char_type> list(s.cbegin(), s.cend());
+    String via_list;
+    recode<Encoding, Encoding>(list.cbegin(), list.cend(),
+      std::back_inserter(via_list), question_mark<char_type>());
+
+    String via_string;
+    recode<Encoding, Encoding>(s.data(), s.data() + s.size(),
+      std::back_inserter(via_string), question_mark<char_type>());
+
+    String via_pointer(via_list.size(), char_type());
+    char_type* end = recode<Encoding, Encoding>(s.data(), s.data() + s.size(),
+      &via_pointer[0], question_mark<char_type>());
+
+    return via_string == via_list && via_pointer == via_list
+      && end == via_pointer.data() + via_pointer.size();
+  }
+
+  void validator_test()
+  {
+    cout << "validator_test" << endl;
+
+    //  surrogates must pair high then low
+    u16string low_low(u"a\xDC00\xDC00");
+    BOOST_TEST(first_ill_formed(low_low.cbegin(), low_low.cend()).first
+      == low_low.cbegin() + 1);
+    u16string high_high(u"a\xD800\xD800");
+    BOOST_TEST(first_ill_formed(high_high.cbegin(), high_high.cend()).first
+      == high_high.cbegin() + 1);
+    u16string pair(u"a\xD800\xDC00");
+    BOOST_TEST(is_well_formed(pair));
+
+    cout << "  validator_test done" << endl;
+  }
+
+  void sequence_test()
+  {
+    cout << "sequence_test" << endl;
+
+    const string octets[] = { "\xC3\xA9", "\xE4\xB8\x96", "\xF0\x9F\x98\x80",
+      "\xC3", "\xE4\xB8", "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\x80",
+      "\xFF", "\xE0\x80\xAF" };
+    for (const string& seq : octets)
+      for (std::size_t offset = 0; offset < 20; ++offset)
+      {
+        string s(24, 'a');
+        s.replace(offset, seq.size(), seq);
+        BOOST_TEST(same_recoding<utf8>(s));
+      }
+
+    const u16string units[] = { u"\xD83D\xDE00", u"\xD83D", u"\xDE00",
+      u"\xDE00\xD83D", u"\xD83D\xD83D", u"\xDE00\xDE00", u"\xFFFF" };
+    for (const u16string& seq : units)
+      for (std::size_t offset = 0; offset < 20; ++offset)
+      {
+        u16string s(24, u'\x3B1');
+        s.replace(offset, seq.size(), seq);
+        BOOST_TEST(same_recoding<utf16>(s));
+      }
+
+    const u32string code_points[] = { U"\x1F600", U"\xD800", U"\xDFFF", U"\x110000",
+      U"\xD800\xDC00" };
+    for (const u32string& seq : code_points)
+      for (std::size_t offset = 0; offset < 20; ++offset)
+      {
+        u32string s(24, U'\x4E16');
+        s.replace(offset, seq.size(), seq);
+        BOOST_TEST(same_recoding<utf32>(s));
+      }
+
+    cout << "  sequence_test done" << endl;
+  }
+
+  void corpus_test()
+  {
+    cout << "corpus_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      BOOST_TEST(same_recoding<utf8>(c.utf8));
+      BOOST_TEST(same_recoding<utf16>(c.utf16));
+      BOOST_TEST(same_recoding<utf32>(c.utf32));
+      if (c.errors == 0)  // otherwise the corpus keeps the ill-formed sequences
+      {
+        BOOST_TEST(to_string<utf8>(c.utf8) == c.utf8);
+        BOOST_TEST(to_string<utf16>(c.utf16) == c.utf16);
+        BOOST_TEST(to_string<utf32>(c.utf32) == c.utf32);
+        BOOST_TEST(to_string<wide>(c.wide) == c.wide);
+      }
+      else
+        BOOST_TEST(to_string<wide>(c.wide) == to_string<wide>(c.utf32));
+    }
+
+    cout << "  corpus_test done" << endl;
+  }
+}
+
+int main()
+{
+  validator_test();
+  sequence_test();
+  corpus_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,170 @@
+﻿//  unicode/test/inline_string_test.cpp  -----------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/inline_string.hpp>
+#include <boost/unicode/cjk_encoding.hpp>
+#include <boost/unicode/utf8_variants.hpp>
+#include <string>
+#include <utility>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  void inline_string_test()
+  {
+    cout << "inline_string_test" << endl;
+
+    inline_u16string<4> s;
+    BOOST_TEST(s.empty());
+    BOOST_TEST(s.is_inline());
+    BOOST_TEST_EQ(s.capacity(), 4u);
+    BOOST_TEST(s.c_str()[0] == u'\0');
+
+    for (char16_t c : u"abcd")
+      if (c)
+        s.push_back(c);
+    BOOST_TEST(s.is_inline());
+    BOOST_TEST(s.view() == u"abcd");
+
+    s.push_back(u'e');  // spills
+    BOOST_TEST(!s.is_inline());
+    BOOST_TEST(s.capacity() >= 5u);
+    BOOST_TEST(s.str() == u"abcde");
+    BOOST_TEST(s.c_str()[5] == u'\0');
+
+    inline_u16string<4> t(s);
+    BOOST_TEST(t == s);
+    inline_u16string<4> m(std::move(s));
+    BOOST_TEST(m == t);
+    BOOST_TEST(!m.is_inline());
+    BOOST_TEST(s.empty());
+    BOOST_TEST(s.is_inline());
+
+    m.resize(2);
+    BOOST_TEST(m.view() == u"ab");
+    m.resize(3);
+    BOOST_TEST(m[2] == u'\0');
+    m.clear();
+    m.append(u"xyz", 3);
+    BOOST_TEST(m.view() == u"xyz");
+
+    inline_string<8> a(boost::string_view("abc"));
+    inline_string<8> b;
+    b = std::move(a);
+    BOOST_TEST(b.is_inline());
+    BOOST_TEST_EQ(b.view(), "abc");
+    BOOST_TEST(a.empty());
+    BOOST_TEST(a != b);
+
+    cout << "  inline_string_test done" << endl;
+  }
+
+  //  the same as recode() through a back_inserter
+  template <class From, class To, class View>
+  void to_inline_string_test(View in)
+  {
+    using to_char = typename To::value_type;
+    std::basic_string<to_char> expected;
+    recode<From, To>(in.cbegin(), in.cend(), std::back_inserter(expected));
+
+    auto s = to_inline_string<To, 24>(in);
+    BOOST_TEST(s.view() == expected);
+    BOOST_TEST_EQ(s.is_inline(), expected.size() <= 24);
+    BOOST_TEST(to_string<To>(in) == expected);
+  }
+
+  template <class From, class View>
+  void to_inline_string_test(View in)
+  {
+    to_inline_string_test<From, utf8>(in);
+    to_inline_string_test<From, utf16>(in);
+    to_inline_string_test<From, utf32>(in);
+    to_inline_string_test<From, wide>(in);
+  }
+
+  void to_inline_string_test()
+  {
+    cout << "to_inline_string_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      for (std::size_t n : { 0, 1, 5, 8, 23, 24, 25, 42, 127, 128, 129, 300, 4096 })
+      {
+        const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), n);
+        to_inline_string_test<utf8>(boost::string_view(c.utf8));
+        to_inline_string_test<utf16>(boost::u16string_view(c.utf16));
+        to_inline_string_test<utf32>(boost::u32string_view(c.utf32));
+        to_inline_string_test<wide>(boost::wstring_view(c.wide));
+      }
+    }
+
+    //  every code unit ill-formed, so each expands the most it can
+    for (std::size_t n : { 40, 255, 256, 257, 341, 342, 512, 513 })
+    {
+      const string ill(n, '\xFF');
+      to_inline_string_test<utf8>(boost::string_view(ill));
+      const u16string lone(n, char16_t(0xD800));
+      to_inline_string_test<utf16>(boost::u16string_view(lone));
+      const u32string big(n, char32_t(0x110000));
+      to_inline_string_test<utf32>(boost::u32string_view(big));
+    }
+
+    //  an error handler's replacement
+    inline_u16string<8> r = to_inline_string<utf16, 8>(string("a\xFF" "b"),
+      []() { return u"<?>"; });
+    BOOST_TEST(r.view() == u"a<?>b");
+    BOOST_TEST(r.is_inline());
+
+    cout << "  to_inline_string_test done" << endl;
+  }
+
+  //  to_string() to an encoding that is not UTF, which can expand more than UTF can
+  template <class From, class To, class Input>
+  void expanding_test(const Input& in)
+  {
+    std::basic_string<typename To::value_type> expected;
+    recode<From, To>(in.cbegin(), in.cend(), std::back_inserter(expected));
+    BOOST_TEST(to_string<To>(in) == expected);
+  }
+
+  void expanding_test()
+  {
+    cout << "expanding_test" << endl;
+
+    //  around the small string buffer and the stack buffer of to_string(), for input
+    //  of which each code unit expands to 4 octets in gb18030, and 6 in cesu8 and mutf8
+    for (std::size_t n : { 1, 2, 3, 4, 5, 6, 7, 8, 15, 16, 255, 256, 257, 340, 341, 342 })
+    {
+      expanding_test<utf16, gb18030>(u16string(n, u'\u0080'));
+      expanding_test<utf8, gb18030>(string(n, '\xFF'));
+      expanding_test<utf32, cesu8>(u32string(n, U'\U0001F600'));
+      expanding_test<utf32, mutf8>(u32string(n, U'\U0001F600'));
+      expanding_test<utf16, mutf8>(u16string(n, u'\0'));
+    }
+
+    cout << "  expanding_test done" << endl;
+  }
+}
+
+int main()
+{
+  inline_string_test();
+  to_inline_string_test();
+  expanding_test();
+
+  return boost::report_errors();
+}
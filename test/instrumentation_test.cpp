@@ -0,0 +1,165 @@
+﻿//  unicode/test/instrumentation_test.cpp  ---------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#define BOOST_UNICODE_INSTRUMENTATION
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/instrumentation.hpp>
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/recoder.hpp>
+#include <boost/unicode/detail/utf8_codecvt_facet.hpp>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  //  the hooks step aside during constant evaluation
+  constexpr const char overlong[] = "a\xC0\x80";
+  static_assert(first_ill_formed(overlong, overlong + 3).first == overlong + 1, "");
+
+  void check_zero(const counters_snapshot& s)
+  {
+    for (std::size_t i = 0; i < counter_count; ++i)
+      BOOST_TEST_EQ(s.values[i], 0u);
+  }
+
+  void conversion_test()
+  {
+    cout << "conversion_test" << endl;
+
+    BOOST_TEST(instrumentation_enabled());
+    BOOST_TEST_EQ(string(counter_name(counter::bytes_in)), "bytes_in");
+    BOOST_TEST_EQ(string(counter_name(counter::iconv_calls)), "iconv_calls");
+
+    reset_counters();
+    check_zero(snapshot_counters());
+
+    to_string<utf16>(boost::string_view(u8"a€𐐷"));
+    counters_snapshot s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::bytes_in], 8u);
+    BOOST_TEST_EQ(s[counter::bytes_out], 8u);
+    BOOST_TEST_EQ(s[counter::code_points], 3u);
+    BOOST_TEST_EQ(s.errors(), 0u);
+
+    reset_counters();
+    to_string<utf8>(u32string(U"a€𐐷"));
+    s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::bytes_in], 12u);
+    BOOST_TEST_EQ(s[counter::bytes_out], 8u);
+    BOOST_TEST_EQ(s[counter::code_points], 3u);
+
+    cout << "  conversion_test done" << endl;
+  }
+
+  void error_test()
+  {
+    cout << "error_test" << endl;
+
+    reset_counters();
+    to_string<utf32>(boost::string_view("\xE2\x82" "a\xC0\xAF\xE0\x80\xAF\xED\xA0\x80"
+      "\xF4\x90\x80\x80\x80"));
+    counters_snapshot s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::truncated], 1u);
+    BOOST_TEST_EQ(s[counter::overlong], 2u);
+    BOOST_TEST_EQ(s[counter::surrogate], 1u);
+    BOOST_TEST_EQ(s[counter::out_of_range], 1u);
+    BOOST_TEST_EQ(s[counter::invalid], 1u);
+    BOOST_TEST_EQ(s.errors(), 6u);
+    BOOST_TEST_EQ(s[counter::code_points], 1u);
+    BOOST_TEST_EQ(s[counter::bytes_in], 16u);
+    BOOST_TEST_EQ(s[counter::bytes_out], 7u * 4u);
+
+    reset_counters();
+    to_string<utf8>(u16string(u"\xD800" "a\xDC00"));
+    s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::truncated], 1u);
+    BOOST_TEST_EQ(s[counter::surrogate], 1u);
+    BOOST_TEST_EQ(s.errors(), 2u);
+
+    reset_counters();
+    u32string u32 = { 0xD800, U'a', 0x110001 };
+    to_string<utf16>(u32);
+    s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::surrogate], 1u);
+    BOOST_TEST_EQ(s[counter::out_of_range], 1u);
+    BOOST_TEST_EQ(s.errors(), 2u);
+
+    cout << "  error_test done" << endl;
+  }
+
+  void path_test()
+  {
+    cout << "path_test" << endl;
+
+    reset_counters();
+    BOOST_TEST(is_well_formed(string(64, 'a') + u8"€"));
+    counters_snapshot s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::fast_path_blocks], 7u);  // the first octet is scalar
+    BOOST_TEST_EQ(s[counter::slow_path_blocks], 1u);
+
+    reset_counters();
+    detail::utf8_codecvt_facet ccvt(1);
+    string out;
+    string in(u8"a€𐐷");
+    recode<utf8, narrow>(in.cbegin(), in.cend(), std::back_inserter(out), ccvt);
+    s = snapshot_counters();
+    BOOST_TEST(s[counter::codecvt_calls] > 0u);
+
+    reset_counters();
+    recoder<char, char16_t> rcdr("UTF-8", "UTF-16LE");
+    u16string u16;
+    rcdr.recode(in.data(), in.data() + in.size(), std::back_inserter(u16));
+    s = snapshot_counters();
+    BOOST_TEST_EQ(s[counter::iconv_calls], 1u);
+    BOOST_TEST_EQ(s[counter::bytes_in], 8u);
+    BOOST_TEST_EQ(s[counter::bytes_out], 8u);
+
+    cout << "  path_test done" << endl;
+  }
+
+  void thread_test()
+  {
+    cout << "thread_test" << endl;
+
+    reset_counters();
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 4; ++i)
+      threads.emplace_back([]()
+      {
+        for (int j = 0; j < 100; ++j)
+          to_string<utf16>(boost::string_view(u8"a€𐐷"));
+      });
+    for (auto& t : threads)
+      t.join();
+    counters_snapshot s = snapshot_counters();  // all four threads have exited
+    BOOST_TEST_EQ(s[counter::code_points], 4u * 100u * 3u);
+    BOOST_TEST_EQ(s[counter::bytes_in], 4u * 100u * 8u);
+
+    cout << "  thread_test done" << endl;
+  }
+}
+
+int main()
+{
+  conversion_test();
+  error_test();
+  path_test();
+  thread_test();
+
+  return boost::report_errors();
+}
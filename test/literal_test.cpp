@@ -0,0 +1,103 @@
+﻿//  unicode/test/literal_test.cpp  -----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/literal.hpp>
+#include <array>
+#include <stdexcept>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  //  compile-time queries  ------------------------------------------------------------//
+
+  static_assert(is_well_formed(u8"Grüße, 世界 𐐷"), "");
+  static_assert(!is_well_formed("abc\xC0\x80"), "");           // overlong
+  static_assert(!is_well_formed("\xED\xA0\x80"), "");          // surrogate
+  static_assert(is_well_formed(u"\xD801\xDC37"), "");
+  static_assert(!is_well_formed(u"a\xDC37"), "");              // unpaired low surrogate
+  static_assert(!is_well_formed(U"\x110000"), "");
+
+  constexpr const char ill_formed[] = "ab\xE0\x80z";
+  static_assert(first_ill_formed(ill_formed, ill_formed + 5).first == ill_formed + 2, "");
+  static_assert(first_ill_formed(ill_formed, ill_formed + 5).second == ill_formed + 4, "");
+
+  //  compile-time transcoding  --------------------------------------------------------//
+
+  constexpr auto greeting = transcode_literal<utf16>(u8"Grüße 𐐷");
+  static_assert(greeting.size() == sizeof(u8"Grüße 𐐷"), "one code unit per octet");
+  static_assert(greeting[0] == u'G' && greeting[2] == u'ü' && greeting[5] == u' ', "");
+  static_assert(greeting[6] == 0xD801 && greeting[7] == 0xDC37, "");
+  static_assert(greeting[8] == 0 && greeting[greeting.size() - 1] == 0, "null padded");
+
+  static_assert(transcoded_size<utf16>(u8"Grüße 𐐷") == 9, "");
+  static_assert(transcoded_size<utf8>(U"€") == 4, "");
+  static_assert(transcoded_size<utf8>("a\xFF") == 5, "U+FFFD is three octets");
+
+  constexpr auto exact = BOOST_UNICODE_LITERAL(utf8, u"€𐐷");
+  static_assert(exact.size() == 8, "");
+  static_assert(exact[0] == '\xE2' && exact[3] == '\xF0' && exact[7] == 0, "");
+
+  constexpr std::array<char16_t, 4> recoded()
+  {
+    std::array<char16_t, 4> a{};
+    const char s[] = u8"a€";
+    recode<utf8, utf16>(s, s + 4, a.begin());
+    return a;
+  }
+  static_assert(recoded()[0] == u'a' && recoded()[1] == u'€' && recoded()[2] == 0, "");
+
+  void transcode_test()
+  {
+    cout << "transcode_test" << endl;
+
+    BOOST_TEST(u16string(greeting.data()) == to_string<utf16>(u8"Grüße 𐐷"));
+    BOOST_TEST(u32string(BOOST_UNICODE_LITERAL(utf32, u8"a\xC0z").data())
+      == U"a�z");
+    BOOST_TEST(string(BOOST_UNICODE_LITERAL(utf8, u"a\xD800z").data())
+      == u8"a�z");
+    BOOST_TEST(std::wstring(BOOST_UNICODE_LITERAL(wide, u8"Grüße 𐐷").data())
+      == L"Grüße 𐐷");
+
+    constexpr auto widest = transcode_literal<utf8>(U"𐐷");
+    BOOST_TEST_EQ(widest.size(), 8u);
+    BOOST_TEST(string(widest.data()) == u8"𐐷");
+
+    cout << "  transcode_test done" << endl;
+  }
+
+  void size_test()
+  {
+    cout << "size_test" << endl;
+
+    //  at run time, too small a Size is reported by exception
+    BOOST_TEST_THROWS((transcode_literal<utf8, 4>(u"€𐐷")), std::length_error);
+    auto a = transcode_literal<utf8, 10>(u"€𐐷");
+    BOOST_TEST(string(a.data()) == u8"€𐐷");
+    BOOST_TEST_EQ(a[8], 0);
+    BOOST_TEST_EQ(a[9], 0);
+
+    cout << "  size_test done" << endl;
+  }
+}
+
+int main()
+{
+  transcode_test();
+  size_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,124 @@
+﻿//  unicode/test/offset_index_test.cpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/offset_index.hpp>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::wstring;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  const string     u8str(u8"$€𐐷𤭢");
+  const u16string  u16str(u"$€𐐷𤭢");
+  const u32string  u32str(U"$€𐐷𤭢");
+  const wstring    wstr(  L"$€𐐷𤭢");
+
+  const string     ill_u8str
+    = {0x24,char(0xE2),char(0x82),char(0xAC),char(0xF0),char(0x90),char(0x90),char(0xB7),
+    char(0xF0),char(0xA4),char(0xAD),char(0xA2),char(0xED),char(0xA0),char(0x80)};
+  const u16string  ill_u16str(u"$€𐐷𤭢\xD800");
+
+  void count_test()
+  {
+    cout << "count_test" << endl;
+
+    BOOST_TEST_EQ(count_code_points(string()), 0u);
+    BOOST_TEST_EQ(count_code_points(u8str), 4u);
+    BOOST_TEST_EQ(count_code_points(u16str), 4u);
+    BOOST_TEST_EQ(count_code_points(u32str), 4u);
+    BOOST_TEST_EQ(count_code_points(wstr), 4u);
+    BOOST_TEST_EQ(utf16_length_of_utf8(u8str), u16str.size());
+
+    //  long enough to exercise the eight-octets-at-a-time path
+    string long_u8;
+    for (int i = 0; i < 50; ++i)
+      long_u8 += u8"ab€cdé𐐷";
+    BOOST_TEST_EQ(count_code_points(long_u8), to_string<utf32>(long_u8).size());
+    BOOST_TEST_EQ(utf16_length_of_utf8(long_u8), to_string<utf16>(long_u8).size());
+
+    //  ill-formed sequences count as their replacement does
+    BOOST_TEST_EQ(count_code_points(ill_u8str), to_string<utf32>(ill_u8str).size());
+    BOOST_TEST_EQ(utf16_length_of_utf8(ill_u8str), to_string<utf16>(ill_u8str).size());
+    BOOST_TEST_EQ(count_code_points(ill_u16str), to_string<utf32>(ill_u16str).size());
+
+    const string garbage("a\xF0\x90\x80" "b\x80\x80\xFF" "c\xE0\x80");
+    BOOST_TEST_EQ(count_code_points(garbage), to_string<utf32>(garbage).size());
+    BOOST_TEST_EQ(utf16_length_of_utf8(garbage), to_string<utf16>(garbage).size());
+
+    cout << "  count_test done" << endl;
+  }
+
+  void offset_index_test()
+  {
+    cout << "offset_index_test" << endl;
+
+    string s;
+    for (int i = 0; i < 20; ++i)
+      s += u8"x€𐐷";  // 1 + 3 + 4 octets, 1 + 1 + 2 UTF-16 code units
+
+    for (std::size_t interval : {1u, 2u, 7u, 64u})
+    {
+      offset_index idx(s, interval);
+      BOOST_TEST_EQ(idx.end().utf8, s.size());
+      BOOST_TEST_EQ(idx.end().utf16, to_string<utf16>(s).size());
+      BOOST_TEST_EQ(idx.end().code_point, 60u);
+
+      for (std::size_t i = 0; i < 20; ++i)
+      {
+        //  code point boundaries
+        BOOST_TEST_EQ(idx.utf8_to_utf16(i * 8), i * 4);
+        BOOST_TEST_EQ(idx.utf8_to_utf16(i * 8 + 1), i * 4 + 1);
+        BOOST_TEST_EQ(idx.utf8_to_utf16(i * 8 + 4), i * 4 + 2);
+        BOOST_TEST_EQ(idx.utf16_to_utf8(i * 4 + 2), i * 8 + 4);
+        BOOST_TEST_EQ(idx.code_point_to_utf8(i * 3 + 2), i * 8 + 4);
+        BOOST_TEST_EQ(idx.code_point_to_utf16(i * 3 + 2), i * 4 + 2);
+        BOOST_TEST_EQ(idx.utf16_to_code_point(i * 4 + 2), i * 3 + 2);
+        BOOST_TEST_EQ(idx.utf8_to_code_point(i * 8 + 4), i * 3 + 2);
+
+        //  offsets inside a sequence move back to its start
+        BOOST_TEST_EQ(idx.utf8_to_utf16(i * 8 + 2), i * 4 + 1);
+        BOOST_TEST_EQ(idx.utf8_to_utf16(i * 8 + 7), i * 4 + 2);
+        BOOST_TEST_EQ(idx.utf16_to_utf8(i * 4 + 3), i * 8 + 4);
+      }
+
+      //  offsets past the end move back to the end
+      BOOST_TEST_EQ(idx.utf8_to_utf16(s.size() + 10), idx.end().utf16);
+      BOOST_TEST_EQ(idx.code_point_to_utf8(1000), s.size());
+    }
+
+    //  ill-formed sequences are a single code point and UTF-16 code unit
+    offset_index ill(ill_u8str, 2);
+    BOOST_TEST_EQ(ill.end().code_point, count_code_points(ill_u8str));
+    BOOST_TEST_EQ(ill.end().utf16, utf16_length_of_utf8(ill_u8str));
+
+    //  empty sequence
+    offset_index empty(boost::string_view(""));
+    BOOST_TEST_EQ(empty.from_utf8(5).utf16, 0u);
+    BOOST_TEST_EQ(empty.from_code_point(0).utf8, 0u);
+
+    cout << "  offset_index_test done" << endl;
+  }
+
+}  // unnamed namespace
+
+int main()
+{
+  count_test();
+  offset_index_test();
+
+  return boost::report_errors();
+}
@@ -1,5 +1,6 @@
 ﻿#include <iostream>
 #include <boost/unicode/recoder.hpp>
+#include <algorithm>
 #include <iterator>
 #include <system_error>
 #define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
@@ -80,6 +81,169 @@ namespace
     cout << "  test " << ++n << " complete" << endl;
     cout << "  ill_formed_utf8_source test done" << endl;
   }
+
+  //  feeds s to rcdr in chunks of chunk octets, then flushes
+  template <class FromCharT, class ToCharT, class Error = boost::unicode::ufffd<ToCharT>>
+  std::basic_string<ToCharT> feed_chunks(boost::unicode::recoder<FromCharT, ToCharT>& rcdr,
+    const std::basic_string<FromCharT>& s, std::size_t chunk, Error eh = Error())
+  {
+    std::basic_string<ToCharT> tmp;
+    for (std::size_t i = 0; i < s.size(); i += chunk)
+      rcdr.feed(s.data() + i, s.data() + (std::min)(i + chunk, s.size()),
+        std::back_inserter(tmp), eh);
+    rcdr.flush(std::back_inserter(tmp), eh);
+    BOOST_TEST_EQ(rcdr.pending(), 0u);
+    return tmp;
+  }
+
+  void streaming_test()
+  {
+    cout << "streaming_test" << endl;
+
+    //  every split of every sequence
+    for (std::size_t chunk = 1; chunk <= u8str.size(); ++chunk)
+      BOOST_TEST((feed_chunks(rcdr_8_32, u8str, chunk) == u32str));
+
+    //  an incomplete sequence is held over, not replaced
+    u32string tmp;
+    rcdr_8_32.feed(u8str.data(), u8str.data() + 3, std::back_inserter(tmp));
+    BOOST_TEST_EQ(rcdr_8_32.pending(), 2u);
+    BOOST_TEST((tmp == U"$"));
+
+    //  until the input ends, or the recoder is reset
+    rcdr_8_32.flush(std::back_inserter(tmp));
+    BOOST_TEST((tmp == U"$\uFFFD"));
+    rcdr_8_32.feed(u8str.data(), u8str.data() + 3, std::back_inserter(tmp));
+    rcdr_8_32.reset();
+    BOOST_TEST_EQ(rcdr_8_32.pending(), 0u);
+    BOOST_TEST((feed_chunks(rcdr_8_32, string("\x82\xAC"), 1, err32()) == U"*ill*"));
+
+    //  Shift-JIS double-byte characters split between reads
+    boost::unicode::recoder<char, char32_t> sjis("SJIS", "UTF-32LE");
+    const string sjis_str("a\x93\xFA\x96\x7B\x8C\xEA" "b");
+    for (std::size_t chunk = 1; chunk <= sjis_str.size(); ++chunk)
+      BOOST_TEST((feed_chunks(sjis, sjis_str, chunk) == U"a日本語b"));
+
+    //  ISO-2022-JP keeps its shift state across reads, escape sequences included
+    boost::unicode::recoder<char, char32_t> from_jis("ISO-2022-JP", "UTF-32LE");
+    const string jis_str("a\x1B$BF|K\\8l\x1B(Bb");
+    for (std::size_t chunk = 1; chunk <= jis_str.size(); ++chunk)
+      BOOST_TEST((feed_chunks(from_jis, jis_str, chunk) == U"a日本語b"));
+
+    //  flush() returns the output to the initial shift state
+    boost::unicode::recoder<char32_t, char> to_jis("UTF-32LE", "ISO-2022-JP");
+    BOOST_TEST_EQ(feed_chunks(to_jis, u32string(U"a日本語"), 1), "a\x1B$BF|K\\8l\x1B(B");
+    BOOST_TEST_EQ(feed_chunks(to_jis, u32string(U"日"), 1), "\x1B$BF|\x1B(B");
+    string one_shot;
+    const u32string kanji(U"日");
+    to_jis.recode(kanji.data(), kanji.data() + kanji.size(), std::back_inserter(one_shot));
+    BOOST_TEST_EQ(one_shot, "\x1B$BF|\x1B(B");
+
+    cout << "  streaming_test done" << endl;
+  }
+
+  //  true if feeding s split at any one point, or in chunks of any size, gives the
+  //  output of recode()
+  bool same_as_recode(boost::unicode::recoder<char, char32_t>& rcdr, const string& s)
+  {
+    u32string whole;
+    rcdr.recode(s.data(), s.data() + s.size(), std::back_inserter(whole), err32());
+    bool same = true;
+    for (std::size_t i = 0; i <= s.size(); ++i)
+    {
+      u32string split;
+      rcdr.feed(s.data(), s.data() + i, std::back_inserter(split), err32());
+      rcdr.feed(s.data() + i, s.data() + s.size(), std::back_inserter(split), err32());
+      rcdr.flush(std::back_inserter(split), err32());
+      same = same && split == whole;
+      if (i != 0)
+        same = same && feed_chunks(rcdr, s, i, err32()) == whole;
+    }
+    if (!same)
+      cout << "  feed() differs from recode() for " << hex_string(s) << endl;
+    return same;
+  }
+
+  void replacement_test()
+  {
+    cout << "replacement_test" << endl;
+
+    using boost::unicode::recoder;
+    using boost::unicode::recoder_replacement;
+
+    recoder<char, char32_t> per_unit("UTF-8", "UTF-32", recoder_replacement::per_unit);
+    BOOST_TEST(per_unit.replacement() == recoder_replacement::per_unit);
+    BOOST_TEST(rcdr_8_32.replacement() == recoder_replacement::per_run);
+    const string garbage("a\xFF\x80\xED\xA0\x80\xC0z\xF0\x9F");
+    u32string tmp;
+    per_unit.recode(garbage.data(), garbage.data() + garbage.size(),
+      std::back_inserter(tmp), err32nul());
+    BOOST_TEST((tmp == U"az"));
+    tmp.clear();
+    per_unit.recode(garbage.data(), garbage.data() + garbage.size(),
+      std::back_inserter(tmp));
+    BOOST_TEST((tmp == U"a\uFFFD\uFFFD\uFFFD\uFFFD\uFFFD\uFFFDz\uFFFD\uFFFD"));
+    BOOST_TEST((to_u32string(garbage) == U"a\uFFFDz\uFFFD"));
+
+    //  a well-formed sequence right after a run is kept
+    BOOST_TEST((to_u32string("\x80\x80\xE2\x82\xAC") == U"\uFFFD€"));
+
+    //  not UTF: the run is the octets no Shift-JIS character starts with
+    recoder<char, char32_t> sjis("SJIS", "UTF-32LE");
+    recoder<char, char32_t> sjis_per_unit("SJIS", "UTF-32LE",
+      recoder_replacement::per_unit);
+    const string sjis_garbage("a\xFD\xFE\xFF\x93\xFA" "b");
+    tmp.clear();
+    sjis.recode(sjis_garbage.data(), sjis_garbage.data() + sjis_garbage.size(),
+      std::back_inserter(tmp), err32());
+    BOOST_TEST((tmp == U"a*ill*日b"));
+    tmp.clear();
+    sjis_per_unit.recode(sjis_garbage.data(), sjis_garbage.data() + sjis_garbage.size(),
+      std::back_inserter(tmp), err32());
+    BOOST_TEST((tmp == U"a*ill**ill**ill*日b"));
+
+    //  a run ending the chunk, then completed by the next
+    tmp.clear();
+    rcdr_8_32.feed(garbage.data(), garbage.data() + 9, std::back_inserter(tmp));
+    rcdr_8_32.feed(garbage.data() + 9, garbage.data() + 10, std::back_inserter(tmp));
+    rcdr_8_32.flush(std::back_inserter(tmp));
+    BOOST_TEST((tmp == U"a\uFFFDz\uFFFD"));
+
+    //  runs of ill-formed input split between chunks, in both modes
+    for (auto mode : { recoder_replacement::per_run, recoder_replacement::per_unit })
+    {
+      recoder<char, char32_t> from_utf8("UTF-8", "UTF-32", mode);
+      BOOST_TEST(same_as_recode(from_utf8, "\xED\xBF"));
+      BOOST_TEST(same_as_recode(from_utf8, "\xFF\xE2\x82(\x80"));
+      BOOST_TEST(same_as_recode(from_utf8, garbage));
+      recoder<char, char32_t> from_jis("ISO-2022-JP", "UTF-32LE", mode);
+      BOOST_TEST(same_as_recode(from_jis, "\x80\x1B$"));
+      recoder<char, char32_t> from_gb("GB18030", "UTF-32LE", mode);
+      BOOST_TEST(same_as_recode(from_gb, "\x80\x80\xA9("));
+      recoder<char, char32_t> from_sjis("SJIS", "UTF-32LE", mode);
+      BOOST_TEST(same_as_recode(from_sjis, sjis_garbage));
+    }
+
+    //  an unpaired high surrogate is one code unit; what follows it is kept
+    recoder<char16_t, char> from_utf16("UTF-16LE", "UTF-8");
+    const u16string lone(u"a\xD800" u"b");
+    const u16string lone_then_pair(u"a\xD800\xD800\xDC00" u"b");
+    string out;
+    from_utf16.recode(lone.data(), lone.data() + lone.size(), std::back_inserter(out));
+    BOOST_TEST_EQ(out, u8"a\uFFFDb");
+    out.clear();
+    from_utf16.recode(lone_then_pair.data(), lone_then_pair.data() + lone_then_pair.size(),
+      std::back_inserter(out));
+    BOOST_TEST_EQ(out, u8"a\uFFFD\U00010000b");
+    for (std::size_t chunk = 1; chunk <= lone_then_pair.size(); ++chunk)
+    {
+      BOOST_TEST_EQ(feed_chunks(from_utf16, lone, chunk), u8"a\uFFFDb");
+      BOOST_TEST_EQ(feed_chunks(from_utf16, lone_then_pair, chunk),
+        u8"a\uFFFD\U00010000b");
+    }
+
+    cout << "  replacement_test done" << endl;
+  }
 }
 
 int main()
@@ -108,6 +272,8 @@ int main()
   std::cout << "expect:" << hex_string(u32str) << std::endl;
 
   ill_formed_utf8_source();
+  streaming_test();
+  replacement_test();
 
   return boost::report_errors();
 }
@@ -0,0 +1,103 @@
+﻿//  unicode/test/sanitize_test.cpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/sanitize.hpp>
+#include <boost/unicode/detail/hex_string.hpp>
+#include <string>
+#include <cstdlib>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using boost::unicode::detail::hex_string;
+using std::string;
+
+namespace
+{
+  const string     u8str(u8"$€𐐷𤭢");
+  const string     ill_u8str
+    = {0x24,char(0xE2),char(0x82),char(0xAC),char(0xF0),char(0x90),char(0x90),char(0xB7),
+    char(0xF0),char(0xA4),char(0xAD),char(0xA2),char(0xED),char(0xA0),char(0x80)};
+
+  void check(string s)
+  {
+    string expected = to_string<utf8>(s);
+    bool well_formed = is_well_formed(s);
+    BOOST_TEST_EQ(sanitize_in_place(s), well_formed);
+    if (s != expected)
+    {
+      cout << "result:" << hex_string(s) << endl;
+      cout << "expect:" << hex_string(expected) << endl;
+    }
+    BOOST_TEST(s == expected);
+  }
+
+  void well_formed_test()
+  {
+    cout << "well_formed_test" << endl;
+
+    string s(u8str);
+    for (int i = 0; i < 10; ++i)
+      s += s;
+    const char* data = s.data();
+    BOOST_TEST(sanitize_in_place(s));
+    BOOST_TEST(s.data() == data);  // no reallocation
+    check("");
+    check("abc");
+
+    cout << "  well_formed_test done" << endl;
+  }
+
+  void ill_formed_test()
+  {
+    cout << "ill_formed_test" << endl;
+
+    check(ill_u8str);
+    check("\xFF");
+    check("a\x80" "b");
+    check("\xE2\x82");
+    check("x\xED\xA0\x80y");
+    check("\xF4\x90\x80\x80");
+    check("\xC0\x80\xC1\xBF");
+
+    //  a four octet error shrinks to three octets, so compacts in place
+    string s(64, 'a');
+    s += "\xF0\x90\x90";
+    s += string(64, 'b');
+    std::size_t capacity = s.capacity();
+    const char* data = s.data();
+    BOOST_TEST(!sanitize_in_place(s));
+    BOOST_TEST(s.data() == data);
+    BOOST_TEST_EQ(s.capacity(), capacity);
+    BOOST_TEST_EQ(s.size(), 131u);
+
+    //  random octets, which grow, shrink, or both
+    std::srand(1);
+    for (int i = 0; i < 1000; ++i)
+    {
+      string r;
+      for (int j = std::rand() % 40; j > 0; --j)
+        r += static_cast<char>(std::rand() % 3 ? std::rand() % 0x100 : 'a');
+      check(r);
+    }
+
+    cout << "  ill_formed_test done" << endl;
+  }
+
+}  // unnamed namespace
+
+int main()
+{
+  well_formed_test();
+  ill_formed_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,178 @@
+﻿//  unicode/test/sink_test.cpp  --------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/sink.hpp>
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  //  the same as recode() through a back_inserter, for each corpus
+  template <class From, class To, class Input>
+  void container_test(const Input& in)
+  {
+    using to_char = typename To::value_type;
+    std::basic_string<to_char> expected;
+    recode<From, To>(in.cbegin(), in.cend(), std::back_inserter(expected));
+
+    std::basic_string<to_char> s(3, to_char('x'));  // appended to
+    auto ss = make_sink(s);
+    recode_to_sink<From, To>(in.data(), in.data() + in.size(), ss);
+    BOOST_TEST(s.substr(3) == expected);
+
+    std::vector<to_char> v;
+    auto vs = make_sink(v);
+    recode_to_sink<From, To>(in.cbegin(), in.cend(), vs);
+    BOOST_TEST(std::basic_string<to_char>(v.begin(), v.end()) == expected);
+  }
+
+  void container_test()
+  {
+    cout << "container_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      for (std::size_t n : { 0, 1, 63, 64, 65, 4096 })
+      {
+        const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), n);
+        container_test<utf8, utf8>(c.utf8);
+        container_test<utf8, utf16>(c.utf8);
+        container_test<utf8, utf32>(c.utf8);
+        container_test<utf16, utf8>(c.utf16);
+        container_test<utf16, utf16>(c.utf16);
+        container_test<utf32, utf8>(c.utf32);
+        container_test<wide, utf16>(c.wide);
+      }
+    }
+
+    //  the error handler's replacement goes to the sink too
+    const string ill("a\xFF" "b");
+    u16string s;
+    auto sink = make_sink(s);
+    recode_to_sink<utf8, utf16>(ill.cbegin(), ill.cend(), sink,
+      []() { return u"<?>"; });
+    BOOST_TEST(s == u"a<?>b");
+
+    cout << "  container_test done" << endl;
+  }
+
+  void buffer_test()
+  {
+    cout << "buffer_test" << endl;
+
+    const bench::corpus& c = bench::get_corpus(bench::mix::mixed, 4096);
+    const u16string expected = to_string<utf16>(c.utf8);
+
+    std::vector<char16_t> buf(expected.size());
+    auto fits = make_sink(buf.data(), buf.data() + buf.size());
+    recode_to_sink<utf8, utf16>(c.utf8.cbegin(), c.utf8.cend(), fits);
+    BOOST_TEST_EQ(fits.size(), expected.size());
+    BOOST_TEST_EQ(fits.overflow(), 0u);
+    BOOST_TEST(u16string(buf.begin(), buf.end()) == expected);
+
+    //  too small: what fits is kept, and the rest counted
+    for (std::size_t n : { std::size_t(0), std::size_t(1), std::size_t(100),
+      expected.size() - 1 })
+    {
+      std::vector<char16_t> small(n + 1, u'#');
+      auto sink = make_sink(small.data(), small.data() + n);
+      recode_to_sink<utf8, utf16>(c.utf8.cbegin(), c.utf8.cend(), sink);
+      BOOST_TEST_EQ(sink.size(), n);
+      BOOST_TEST_EQ(sink.size() + sink.overflow(), expected.size());
+      BOOST_TEST(u16string(small.begin(), small.begin() + n) == expected.substr(0, n));
+      BOOST_TEST(small[n] == u'#');
+    }
+
+    //  the identity recode's well-formed runs are written whole
+    string out(c.utf8.size() / 2, '\0');
+    auto half = make_sink(&out[0], &out[0] + out.size());
+    recode_to_sink<utf8, utf8>(c.utf8.data(), c.utf8.data() + c.utf8.size(), half);
+    BOOST_TEST_EQ(half.size() + half.overflow(), c.utf8.size());
+    BOOST_TEST_EQ(out, c.utf8.substr(0, out.size()));
+
+    cout << "  buffer_test done" << endl;
+  }
+
+  void streambuf_test()
+  {
+    cout << "streambuf_test" << endl;
+
+    const bench::corpus& c = bench::get_corpus(bench::mix::cjk, 4096);
+    std::stringbuf sb;
+    auto sink = make_sink(sb);
+    recode_to_sink<utf16, utf8>(c.utf16.cbegin(), c.utf16.cend(), sink);
+    BOOST_TEST(!sink.failed());
+    BOOST_TEST_EQ(sb.str(), c.utf8);
+
+    std::wstringbuf wsb;
+    auto wsink = make_sink(wsb);
+    recode_to_sink<utf8, wide>(c.utf8.cbegin(), c.utf8.cend(), wsink);
+    BOOST_TEST(wsb.str() == c.wide);
+
+    cout << "  streambuf_test done" << endl;
+  }
+
+  void fd_test()
+  {
+    cout << "fd_test" << endl;
+
+    const bench::corpus& c = bench::get_corpus(bench::mix::emoji, 4096);
+    std::FILE* f = std::tmpfile();
+    BOOST_TEST(f != nullptr);
+    if (!f)
+      return;
+    {
+      fd_sink<char16_t> sink(fileno(f));
+      recode_to_sink<utf8, utf16>(c.utf8.cbegin(), c.utf8.cend(), sink);
+      recode_to_sink<utf8, utf16>(c.utf8.cbegin(), c.utf8.cend(), sink);
+    }  // flushed by the destructor
+
+    u16string u16(2 * c.utf16.size() + 1, u'\0');
+    std::rewind(f);
+    std::size_t n = std::fread(&u16[0], sizeof(char16_t), u16.size(), f);
+    std::fclose(f);
+    BOOST_TEST_EQ(n, 2 * c.utf16.size());
+    u16.resize(n);
+    BOOST_TEST(u16 == c.utf16 + c.utf16);
+
+    //  a bad descriptor
+    bool thrown = false;
+    try
+    {
+      fd_sink<char> sink(-1);
+      sink.write("abc", 3);
+      sink.flush();
+    }
+    catch (const std::system_error&) { thrown = true; }
+    BOOST_TEST(thrown);
+
+    cout << "  fd_test done" << endl;
+  }
+}
+
+int main()
+{
+  container_test();
+  buffer_test();
+  streambuf_test();
+  fd_test();
+
+  return boost::report_errors();
+}
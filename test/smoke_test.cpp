@@ -24,6 +24,8 @@ using std::endl;
 #include <string>
 #include <sstream>
 #include <iterator>
+#include <locale>
+#include <vector>
 #define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
 #include <boost/core/lightweight_test.hpp>
 
@@ -339,6 +341,67 @@ namespace
     cout << "  all_codecvt_test done" << endl;
   }
 
+  void wide_to_narrow_test()
+  {
+    cout << "wide_to_narrow_test" << endl;
+
+    //  wide input goes straight to the codecvt, each ill-formed code unit replaced once
+    boost::unicode::detail::utf8_codecvt_facet ccvt(0);
+    BOOST_TEST_EQ(to_string<narrow>(wstring(L"\xDC00$€"), ccvt), u8"\uFFFD$€");
+    BOOST_TEST_EQ(to_string<narrow>(wstring(L"$€\xD800"), ccvt), u8"$€\uFFFD");
+    BOOST_TEST_EQ(to_string<narrow>(wstring(L"$\xD800\xD800€"), ccvt, ufffd<char>()),
+      u8"$\uFFFD\uFFFD€");
+
+    //  the UTF-16 path, taken where wchar_t is 16 bits; the code unit after an unpaired
+    //  surrogate is not lost
+    using u16ccvt_t = std::codecvt<char16_t, char, std::mbstate_t>;
+    const u16ccvt_t& u16ccvt = std::use_facet<u16ccvt_t>(std::locale::classic());
+    const std::u16string lone(u"a\xD800" u"b");
+    string narrow_out;
+    boost::unicode::detail::codecvt_well_formed_to_narrow(lone.data(),
+      lone.data() + lone.size(), std::back_inserter(narrow_out), u16ccvt, ufffd<char>());
+    BOOST_TEST_EQ(narrow_out, u8"a\uFFFDb");
+    const std::u16string before_pair(u"a\xD800\xD800\xDC00" u"b");
+    narrow_out.clear();
+    boost::unicode::detail::codecvt_well_formed_to_narrow(before_pair.data(),
+      before_pair.data() + before_pair.size(), std::back_inserter(narrow_out), u16ccvt,
+      ufffd<char>());
+    BOOST_TEST_EQ(narrow_out, u8"a\uFFFD\U00010000b");
+
+    cout << "  wide_to_narrow_test done" << endl;
+  }
+
+  void codecvt_driver_test()
+  {
+    cout << "codecvt_driver_test" << endl;
+
+    //  output to a string is converted in place, and to anything else through a buffer;
+    //  sequences of every length must survive both the room running out and the buffer
+    //  filling
+    boost::unicode::detail::utf8_codecvt_facet ccvt(0);
+    string u8s;
+    for (int i = 0; i < 100; ++i)
+      u8s += u8"a€Ꭶ❄éz";
+    const wstring ws = to_string<wide>(u8s);
+
+    BOOST_TEST_EQ(to_string<narrow>(ws, ccvt), u8s);
+    std::vector<char> chars;
+    recode<wide, narrow>(ws.data(), ws.data() + ws.size(), std::back_inserter(chars),
+      ccvt);
+    BOOST_TEST(string(chars.begin(), chars.end()) == u8s);
+
+    BOOST_TEST(to_string<wide>(boost::string_view(u8s), ccvt) == ws);
+    std::vector<wchar_t> wchars;
+    recode<narrow, wide>(u8s.data(), u8s.data() + u8s.size(),
+      std::back_inserter(wchars), ccvt);
+    BOOST_TEST(wstring(wchars.begin(), wchars.end()) == ws);
+
+    //  input ending within a sequence is replaced once
+    BOOST_TEST(to_string<wide>(boost::string_view("ab\xE2\x82"), ccvt) == L"ab\uFFFD");
+
+    cout << "  codecvt_driver_test done" << endl;
+  }
+
   //  Probe CharTraits template argument deduction
 
   template <class CharT, class CharTraits>
@@ -396,6 +459,8 @@ int main()
   to_u32string_test();
   all_utf_test();
   all_codecvt_test();
+  wide_to_narrow_test();
+  codecvt_driver_test();
   first_ill_formed_test();
   is_well_formed_test();
 
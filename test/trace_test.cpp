@@ -0,0 +1,221 @@
+﻿//  unicode/test/trace_test.cpp  -------------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/batch.hpp>
+#include <boost/unicode/latency_histogram.hpp>
+#include <boost/unicode/recoder.hpp>
+#include <boost/unicode/detail/utf8_codecvt_facet.hpp>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  struct recorded
+  {
+    conversion_event  event;
+    bool              ended;
+  };
+
+  class recording_observer : public conversion_observer
+  {
+  public:
+    std::vector<recorded> events;
+
+    void conversion_start(const conversion_event& e) noexcept override
+    {
+      events.push_back(recorded{e, false});
+    }
+    void conversion_end(const conversion_event& e, std::chrono::nanoseconds d)
+      noexcept override
+    {
+      BOOST_TEST(d.count() >= 0);
+      events.push_back(recorded{e, true});
+    }
+  };
+
+  void check_event(const recorded& r, bool ended, conversion op, const char* from,
+    const char* to, std::size_t in, std::size_t out)
+  {
+    BOOST_TEST_EQ(r.ended, ended);
+    BOOST_TEST(r.event.operation == op);
+    BOOST_TEST_EQ(string(r.event.from), from);
+    BOOST_TEST_EQ(string(r.event.to), to);
+    BOOST_TEST_EQ(r.event.input_bytes, in);
+    BOOST_TEST_EQ(r.event.output_bytes, out);
+  }
+
+  void observer_test()
+  {
+    cout << "observer_test" << endl;
+
+    recording_observer obs;
+    BOOST_TEST(set_conversion_observer(&obs) == nullptr);
+    BOOST_TEST(get_conversion_observer() == &obs);
+
+    //  to_string reports once, not once more for the recode it performs
+    u16string u16 = to_string<utf16>(boost::string_view(u8"a€𐐷"));
+    BOOST_TEST_EQ(obs.events.size(), 2u);
+    if (obs.events.size() == 2)
+    {
+      check_event(obs.events[0], false, conversion::to_string, "utf8", "utf16", 8,
+        unknown_size);
+      check_event(obs.events[1], true, conversion::to_string, "utf8", "utf16", 8, 8);
+    }
+
+    //  output size is known for pointers, but not for back_insert_iterator
+    obs.events.clear();
+    char32_t buf[8];
+    recode<utf16, utf32>(u16.data(), u16.data() + u16.size(), buf);
+    u32string u32;
+    recode<utf16, utf32>(u16.cbegin(), u16.cend(), std::back_inserter(u32));
+    BOOST_TEST_EQ(obs.events.size(), 4u);
+    if (obs.events.size() == 4)
+    {
+      check_event(obs.events[1], true, conversion::recode, "utf16", "utf32", 8, 12);
+      check_event(obs.events[3], true, conversion::recode, "utf16", "utf32", 8,
+        unknown_size);
+    }
+
+    //  a narrow conversion is still one event
+    obs.events.clear();
+    detail::utf8_codecvt_facet ccvt(1);
+    to_string<narrow>(u32, ccvt);
+    BOOST_TEST_EQ(obs.events.size(), 2u);
+    if (obs.events.size() == 2)
+      check_event(obs.events[1], true, conversion::to_string, "utf32", "narrow", 12, 8);
+
+    obs.events.clear();
+    recoder<char, char16_t> rcdr("UTF-8", "UTF-16LE");
+    string in(u8"a€𐐷");
+    u16.clear();
+    rcdr.recode(in.data(), in.data() + in.size(), std::back_inserter(u16));
+    BOOST_TEST_EQ(obs.events.size(), 2u);
+    if (obs.events.size() == 2)
+      check_event(obs.events[1], true, conversion::recoder, "UTF-8", "UTF-16LE", 8,
+        unknown_size);
+
+    //  a batch is one event, not one per string
+    obs.events.clear();
+    const std::vector<string> strings{ u8"a€", "", u8"𐐷", "\xFF" };
+    recode_batch<utf8, utf16>(strings.cbegin(), strings.cend());
+    BOOST_TEST_EQ(obs.events.size(), 2u);
+    if (obs.events.size() == 2)
+      check_event(obs.events[1], true, conversion::recode_batch, "utf8", "utf16", 9,
+        10);
+    obs.events.clear();
+    recode_batch<utf32, narrow>(&u32, &u32 + 1, ccvt);
+    BOOST_TEST_EQ(obs.events.size(), 2u);
+    if (obs.events.size() == 2)
+      check_event(obs.events[1], true, conversion::recode_batch, "utf32", "narrow", 12,
+        8);
+
+    BOOST_TEST(set_conversion_observer(nullptr) == &obs);
+    obs.events.clear();
+    to_string<utf16>(boost::string_view(u8"abc"));
+    BOOST_TEST(obs.events.empty());
+
+    cout << "  observer_test done" << endl;
+  }
+
+  void histogram_test()
+  {
+    cout << "histogram_test" << endl;
+
+    //  every value lies within its bucket, and buckets are contiguous
+    for (std::uint64_t v : {0ull, 1ull, 31ull, 32ull, 33ull, 63ull, 64ull, 1000ull,
+      123456789ull, ~0ull})
+    {
+      std::size_t i = latency_histogram::bucket_index(v);
+      BOOST_TEST(i < latency_histogram::bucket_count);
+      BOOST_TEST(latency_histogram::bucket_highest(i) >= v);
+      if (i > 0)
+        BOOST_TEST(latency_histogram::bucket_highest(i - 1) < v);
+    }
+    BOOST_TEST_EQ(latency_histogram::bucket_index(~0ull),
+      latency_histogram::bucket_count - 1);
+
+    latency_histogram h;
+    BOOST_TEST_EQ(h.percentile(50), 0u);
+    for (std::uint64_t v = 1; v <= 1000; ++v)
+      h.record(v);
+    BOOST_TEST_EQ(h.count(), 1000u);
+    BOOST_TEST_EQ(h.max(), 1000u);
+    BOOST_TEST_EQ(h.mean(), 500.5);
+    BOOST_TEST(h.percentile(50) >= 500 && h.percentile(50) <= 500 + 500 / 16);
+    BOOST_TEST(h.percentile(99) >= 990 && h.percentile(99) <= 990 + 990 / 16);
+    BOOST_TEST_EQ(h.percentile(100), 1000u);
+    h.reset();
+    BOOST_TEST_EQ(h.count(), 0u);
+
+    cout << "  histogram_test done" << endl;
+  }
+
+  void sink_test()
+  {
+    cout << "sink_test" << endl;
+
+    using sink_type = latency_histogram_sink;
+    BOOST_TEST_EQ(sink_type::size_bucket(0), 0u);
+    BOOST_TEST_EQ(sink_type::size_bucket(63), 0u);
+    BOOST_TEST_EQ(sink_type::size_bucket(64), 1u);
+    BOOST_TEST_EQ(sink_type::size_bucket(4 * 1024 * 1024), 5u);
+    BOOST_TEST_EQ(sink_type::size_bucket(~std::size_t(0) - 1), 5u);
+    BOOST_TEST_EQ(sink_type::size_bucket(unknown_size), 6u);
+
+    static sink_type sink;
+    set_conversion_observer(&sink);
+    for (int i = 0; i < 10; ++i)
+      to_string<utf16>(string(100, 'x'));
+    to_string<utf8>(u32string(10, U'x'));
+    set_conversion_observer(nullptr);
+
+    BOOST_TEST_EQ(sink.histogram(conversion::to_string, 1).count(), 10u);
+    BOOST_TEST_EQ(sink.histogram(conversion::to_string, 0).count(), 1u);
+    BOOST_TEST_EQ(sink.histogram(conversion::recode, 1).count(), 0u);
+
+    std::ostringstream text;
+    sink.write_text(text);
+    BOOST_TEST(text.str().find("to_string <1KiB count=10 ") != string::npos);
+    BOOST_TEST(text.str().find("to_string <64B count=1 ") != string::npos);
+
+    std::ostringstream json;
+    sink.write_json(json);
+    BOOST_TEST(json.str().find(
+      "{\"operation\":\"to_string\",\"input_size\":\"<1KiB\",\"count\":10,")
+      != string::npos);
+    cout << json.str();
+
+    sink.reset();
+    std::ostringstream empty;
+    sink.write_json(empty);
+    BOOST_TEST_EQ(empty.str(), "{\"unit\":\"ns\",\"histograms\":[]}\n");
+
+    cout << "  sink_test done" << endl;
+  }
+}
+
+int main()
+{
+  observer_test();
+  histogram_test();
+  sink_test();
+
+  return boost::report_errors();
+}
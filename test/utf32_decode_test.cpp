@@ -0,0 +1,124 @@
+﻿//  unicode/test/utf32_decode_test.cpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Contiguous UTF-8 and UTF-16 input is decoded to UTF-32 a block at a time; the result
+//  must be exactly that of the code unit at a time decoders, including where errors are
+//  replaced.
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/detail/hex_string.hpp>
+#include <iterator>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using namespace boost::unicode::detail;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  bool same_decoding(const string& s)
+  {
+    u32string blocks, scalar;
+    utf8_to_utf32<char32_t>(s.data(), s.data() + s.size(), std::back_inserter(blocks),
+      ufffd<char32_t>());
+    utf8_to_char32_t<char32_t>(s.data(), s.data() + s.size(),
+      std::back_inserter(scalar), u32_err_pass_thru(), ufffd<char32_t>());
+    if (blocks == scalar)
+      return true;
+    cout << "  mismatch for " << hex_string(s) << endl;
+    return false;
+  }
+
+  bool same_decoding(const u16string& s)
+  {
+    u32string blocks, scalar;
+    utf16_to_utf32<char32_t>(s.data(), s.data() + s.size(), std::back_inserter(blocks),
+      ufffd<char32_t>());
+    utf16_to_char32_t<char32_t>(s.data(), s.data() + s.size(),
+      std::back_inserter(scalar), u32_err_pass_thru(), ufffd<char32_t>());
+    return blocks == scalar;
+  }
+
+  void boundary_test()
+  {
+    cout << "boundary_test" << endl;
+
+    //  each sequence, valid or not, at every offset across two block boundaries
+    const string octets[] = { "\xC3\xA9", "\xE4\xB8\x96", "\xF0\x9F\x98\x80",
+      "\xC3", "\xE4\xB8", "\xC0\x80", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\x80",
+      "\xFF" };
+    for (const string& seq : octets)
+      for (std::size_t offset = 0; offset < 34; ++offset)
+      {
+        string s(40, 'a');
+        s.replace(offset, seq.size(), seq);
+        BOOST_TEST(same_decoding(s));
+      }
+
+    //  runs of two-octet sequences around half a block, after which the rest of the
+    //  input is decoded a code point at a time
+    for (std::size_t n = 3; n <= 6; ++n)
+      for (std::size_t offset = 0; offset < 34; ++offset)
+      {
+        string s(80, 'a');
+        for (std::size_t i = 0; i < n; ++i)
+          s.replace(offset + 2 * i, 2, "\xC3\xA9");
+        BOOST_TEST(same_decoding(s));
+        s[70] = '\xFF';
+        BOOST_TEST(same_decoding(s));
+      }
+
+    const u16string units[] = { u"\xD83D\xDE00", u"\xD83D", u"\xDE00", u"\xDE00\xD83D",
+      u"\xFFFF" };
+    for (const u16string& seq : units)
+      for (std::size_t offset = 0; offset < 34; ++offset)
+      {
+        u16string s(40, u'\x3B1');
+        s.replace(offset, seq.size(), seq);
+        BOOST_TEST(same_decoding(s));
+      }
+
+    cout << "  boundary_test done" << endl;
+  }
+
+  void corpus_test()
+  {
+    cout << "corpus_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      BOOST_TEST(same_decoding(c.utf8));
+      BOOST_TEST(same_decoding(c.utf16));
+      if (c.errors == 0)  // otherwise the corpus keeps the ill-formed sequences
+      {
+        BOOST_TEST(to_string<utf32>(c.utf8) == c.utf32);
+        BOOST_TEST(to_string<utf32>(c.utf16) == c.utf32);
+        BOOST_TEST(to_string<wide>(c.utf8) == c.wide);
+      }
+    }
+
+    cout << "  corpus_test done" << endl;
+  }
+}
+
+int main()
+{
+  boundary_test();
+  corpus_test();
+
+  return boost::report_errors();
+}
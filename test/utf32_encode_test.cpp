@@ -0,0 +1,103 @@
+﻿//  unicode/test/utf32_encode_test.cpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Contiguous UTF-32 input is encoded to UTF-16 a block at a time; the result must be
+//  exactly that of the code point at a time encoder, including where errors are
+//  replaced.
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <iterator>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using namespace boost::unicode::detail;
+using std::string;
+using std::u16string;
+using std::u32string;
+
+namespace
+{
+  template <class U32CharT>
+  bool same_encoding(const std::basic_string<U32CharT>& s)
+  {
+    const U32CharT* first = s.data();
+    const U32CharT* last = s.data() + s.size();
+
+    u16string blocks16, scalar16;
+    utf32_to_utf16<char16_t>(first, last, std::back_inserter(blocks16),
+      ufffd<char16_t>());
+    utf32_to_utf16_scalar<char16_t>(first, last, std::back_inserter(scalar16),
+      ufffd<char16_t>());
+
+    return blocks16 == scalar16;
+  }
+
+  void lane_test()
+  {
+    cout << "lane_test" << endl;
+
+    //  blocks of each width, with an ill-formed code point in each lane in turn; the
+    //  length covers three SSE2 blocks and a partial one
+    const char32_t widths[] = { U'a', U'\x3B1', U'\x4E16', U'\x1F600' };
+    const char32_t errors[] = { 0xD800, 0xDFFF, 0x110000, 0xFFFFFFFF };
+    for (char32_t w : widths)
+    {
+      u32string s(3 * 16 + 3, w);
+      BOOST_TEST(same_encoding(s));
+      for (char32_t e : errors)
+        for (std::size_t lane = 0; lane < s.size(); ++lane)
+        {
+          u32string bad(s);
+          bad[lane] = e;
+          BOOST_TEST(same_encoding(bad));
+        }
+    }
+
+    //  the boundaries of each length
+    u32string edges = { 0x7F, 0x80, 0x7FF, 0x800, 0xD7FF, 0xE000, 0xFFFF, 0x10000,
+      0x10FFFF, 0 };
+    BOOST_TEST(same_encoding(edges));
+    BOOST_TEST(same_encoding(edges + edges));
+
+    cout << "  lane_test done" << endl;
+  }
+
+  void corpus_test()
+  {
+    cout << "corpus_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      BOOST_TEST(same_encoding(c.utf32));
+#   if WCHAR_MAX >= 0x1FFFFFFFu
+      BOOST_TEST(same_encoding(c.wide));
+#   endif
+      if (c.errors == 0)  // otherwise the corpus keeps the ill-formed sequences
+      {
+        BOOST_TEST_EQ(to_string<utf8>(c.utf32), c.utf8);
+        BOOST_TEST(to_string<utf16>(c.utf32) == c.utf16);
+      }
+    }
+
+    cout << "  corpus_test done" << endl;
+  }
+}
+
+int main()
+{
+  lane_test();
+  corpus_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,206 @@
+﻿//  unicode/test/utf8_codecvt_test.cpp  ------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  utf8_codecvt must convert exactly as recode() does, whatever the sizes of the
+//  buffers it is given, and do_length() must agree with do_in().
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/utf8_codecvt.hpp>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  using result = std::codecvt_base::result;
+
+  template <class InternT>
+  const std::basic_string<InternT>& text(const bench::corpus& c);
+  template <> const u16string& text<char16_t>(const bench::corpus& c) { return c.utf16; }
+  template <> const u32string& text<char32_t>(const bench::corpus& c) { return c.utf32; }
+  template <> const wstring& text<wchar_t>(const bench::corpus& c) { return c.wide; }
+
+  //  converts all of s with in(), given room for at most room code units per call
+  template <class InternT>
+  std::basic_string<InternT> in_chunks(const utf8_codecvt<InternT>& ccvt,
+    const string& s, std::size_t room)
+  {
+    std::basic_string<InternT> out;
+    std::mbstate_t state = std::mbstate_t();
+    const char* from = s.data();
+    const char* from_end = s.data() + s.size();
+    while (from != from_end)
+    {
+      InternT buf[16];
+      const char* from_next;
+      InternT* to_next;
+      result r = ccvt.in(state, from, from_end, from_next, buf, buf + room, to_next);
+      out.append(buf, to_next);
+      if (r == std::codecvt_base::error || (r == std::codecvt_base::partial
+        && from_next == from && to_next == buf))
+        break;
+      from = from_next;
+    }
+    return out;
+  }
+
+  //  converts all of s with out(), given room for at most room octets per call
+  template <class InternT>
+  string out_chunks(const utf8_codecvt<InternT>& ccvt,
+    const std::basic_string<InternT>& s, std::size_t room)
+  {
+    string out;
+    std::mbstate_t state = std::mbstate_t();
+    const InternT* from = s.data();
+    const InternT* from_end = s.data() + s.size();
+    while (from != from_end)
+    {
+      char buf[16];
+      const InternT* from_next;
+      char* to_next;
+      result r = ccvt.out(state, from, from_end, from_next, buf, buf + room, to_next);
+      out.append(buf, to_next);
+      if (r == std::codecvt_base::error || (r == std::codecvt_base::partial
+        && from_next == from && to_next == buf))
+        break;
+      from = from_next;
+    }
+    return out;
+  }
+
+  template <class InternT>
+  void chunk_test()
+  {
+    cout << "chunk_test<" << sizeof(InternT) * 8 << ">" << endl;
+
+    utf8_codecvt<InternT> ccvt;
+    for (int m = 0; m < static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 512);
+      for (std::size_t room = 1; room <= 16; ++room)
+      {
+        BOOST_TEST(in_chunks(ccvt, c.utf8, room) == text<InternT>(c)
+          || (room == 1 && sizeof(InternT) == 2));  // a surrogate pair needs two
+        if (room >= 4)
+          BOOST_TEST(out_chunks(ccvt, text<InternT>(c), room) == c.utf8);
+      }
+    }
+
+    cout << "  chunk_test done" << endl;
+  }
+
+  template <class InternT>
+  void length_test()
+  {
+    cout << "length_test<" << sizeof(InternT) * 8 << ">" << endl;
+
+    utf8_codecvt<InternT> ccvt;
+    BOOST_TEST_EQ(ccvt.max_length(), 4);
+    BOOST_TEST_EQ(ccvt.encoding(), 0);
+    const string s(u8"a€\U0001F600b\U00010437c\xE4\xB8");
+    for (std::size_t max = 0; max <= 16; ++max)
+    {
+      std::mbstate_t state = std::mbstate_t();
+      InternT buf[16];
+      const char* from_next;
+      InternT* to_next;
+      ccvt.in(state, s.data(), s.data() + s.size(), from_next, buf, buf + max, to_next);
+      state = std::mbstate_t();
+      BOOST_TEST_EQ(ccvt.length(state, s.data(), s.data() + s.size(), max),
+        from_next - s.data());
+    }
+
+    cout << "  length_test done" << endl;
+  }
+
+  template <class InternT>
+  void error_test()
+  {
+    cout << "error_test<" << sizeof(InternT) * 8 << ">" << endl;
+
+    utf8_codecvt<InternT> ccvt;
+    std::mbstate_t state = std::mbstate_t();
+    InternT buf[16];
+    const char* from_next;
+    InternT* to_next;
+
+    const string ill_formed("ab\xC0\x80z");
+    BOOST_TEST_EQ(ccvt.in(state, ill_formed.data(), ill_formed.data() + 5, from_next,
+      buf, buf + 16, to_next), std::codecvt_base::error);
+    BOOST_TEST_EQ(from_next - ill_formed.data(), 2);
+    BOOST_TEST_EQ(to_next - buf, 2);
+
+    const string truncated("ab\xF0\x9F\x98");
+    BOOST_TEST_EQ(ccvt.in(state, truncated.data(), truncated.data() + 5, from_next,
+      buf, buf + 16, to_next), std::codecvt_base::partial);
+    BOOST_TEST_EQ(from_next - truncated.data(), 2);
+    BOOST_TEST_EQ(to_next - buf, 2);
+
+    char octets[16];
+    const InternT* ifrom_next;
+    char* oto_next;
+    const InternT surrogate[] = { InternT('a'), InternT(0xDC00), InternT('b') };
+    BOOST_TEST_EQ(ccvt.out(state, surrogate, surrogate + 3, ifrom_next, octets,
+      octets + 16, oto_next), std::codecvt_base::error);
+    BOOST_TEST_EQ(ifrom_next - surrogate, 1);
+    BOOST_TEST_EQ(oto_next - octets, 1);
+
+    //  a high surrogate at the end is partial for UTF-16, and ill-formed for UTF-32
+    const InternT high[] = { InternT('a'), InternT(0xD800) };
+    BOOST_TEST_EQ(ccvt.out(state, high, high + 2, ifrom_next, octets, octets + 16,
+      oto_next), sizeof(InternT) == 2 ? std::codecvt_base::partial
+        : std::codecvt_base::error);
+    BOOST_TEST_EQ(ifrom_next - high, 1);
+
+    cout << "  error_test done" << endl;
+  }
+
+  void recode_test()
+  {
+    cout << "recode_test" << endl;
+
+    //  the library's narrow conversions, with the facet in place of a locale's
+    utf8_codecvt<wchar_t> wccvt;
+    utf8_codecvt<char32_t> u32ccvt;
+    for (int m = 0; m < static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      BOOST_TEST_EQ(to_string<narrow>(c.wide, wccvt), c.utf8);
+      BOOST_TEST_EQ(to_string<narrow>(c.utf16, wccvt), c.utf8);
+      BOOST_TEST_EQ(to_string<narrow>(c.utf32, u32ccvt), c.utf8);
+      BOOST_TEST(to_string<wide>(boost::string_view(c.utf8), wccvt) == c.wide);
+      BOOST_TEST(to_string<utf16>(boost::string_view(c.utf8), u32ccvt) == c.utf16);
+    }
+
+    cout << "  recode_test done" << endl;
+  }
+}
+
+int main()
+{
+  chunk_test<char16_t>();
+  chunk_test<char32_t>();
+  chunk_test<wchar_t>();
+  length_test<char16_t>();
+  length_test<char32_t>();
+  length_test<wchar_t>();
+  error_test<char16_t>();
+  error_test<char32_t>();
+  error_test<wchar_t>();
+  recode_test();
+
+  return boost::report_errors();
+}
@@ -0,0 +1,137 @@
+﻿//  unicode/test/utf8_dfa_test.cpp  ----------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  The DFA backend must decode exactly as the branchy code does, and its validator must
+//  report exactly the error ranges the branchy one does. Both backends are always compiled,
+//  so they are compared directly here.
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/string_encoding.hpp>
+#include <boost/unicode/detail/hex_string.hpp>
+#include <iterator>
+#include <list>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using namespace boost::unicode::detail;
+using std::string;
+
+namespace
+{
+  static_assert(utf8_dfa_classes[0x7F] == dfa_ascii, "");
+  static_assert(utf8_dfa_classes[0xC1] == dfa_lead_c0, "");
+  static_assert(utf8_dfa_classes[0xEE] == dfa_lead_e1, "");
+  static_assert(utf8_dfa_classes[0xF8] == dfa_not_lead, "");
+  static_assert(utf8_dfa_next(dfa_row(dfa_after_ed), 0xA0)
+    == dfa_row(dfa_surrogate_1), "");
+  static_assert(utf8_dfa_next(dfa_row(dfa_need_2), 'a') == dfa_row(dfa_truncated), "");
+
+  constexpr const char overlong[] = "ab\xE0\x80\x80z";
+  static_assert(utf8_dfa_first_ill_formed(overlong, overlong + 6).first == overlong + 2,
+    "");
+  static_assert(utf8_dfa_first_ill_formed(overlong, overlong + 6).second == overlong + 5,
+    "");
+
+  //  decodes all of [first, last) with both backends, checking that every step agrees
+  template <class Iterator>
+  bool same_decoding(Iterator first, Iterator last)
+  {
+    Iterator branchy = first;
+    Iterator dfa = first;
+    while (branchy != last)
+    {
+      char32_t branchy_u32 = 0;
+      char32_t dfa_u32 = 0;
+      bool branchy_ok = utf8_decode_branchy(branchy, last, branchy_u32);
+      bool dfa_ok = utf8_dfa_decode(dfa, last, dfa_u32);
+      if (branchy_ok != dfa_ok || branchy != dfa || (dfa_ok && branchy_u32 != dfa_u32))
+        return false;
+    }
+    return dfa == last;
+  }
+
+  //  the DFA validator reports exactly the errors the branchy one does, and each begins
+  //  with a sequence the DFA decoder rejects
+  template <class Iterator>
+  bool same_errors(Iterator first, Iterator last)
+  {
+    for (;;)
+    {
+      auto dfa = utf8_dfa_first_ill_formed(first, last);
+      auto branchy = utf8_first_ill_formed_branchy(first, last);
+      if (dfa != branchy)
+        return false;
+      if (dfa.first == last)
+        return dfa.second == last;
+      Iterator end = dfa.first;
+      char32_t u32 = 0;
+      if (utf8_dfa_decode(end, last, u32))
+        return false;
+      first = dfa.second;
+    }
+  }
+
+  void exhaustive_test()
+  {
+    cout << "exhaustive_test" << endl;
+
+    //  every first octet, followed by octets from each class and class boundary
+    const unsigned char followers[] = { 0x00, 0x41, 0x7F, 0x80, 0x8F, 0x90, 0x9F, 0xA0,
+      0xBF, 0xC0, 0xC2, 0xE0, 0xED, 0xF0, 0xF4, 0xF5, 0xFF };
+    int failures = 0;
+    for (unsigned lead = 0; lead < 256; ++lead)
+      for (unsigned char b : followers)
+        for (unsigned char c : followers)
+          for (unsigned char d : followers)
+          {
+            const char s[] = { static_cast<char>(lead), static_cast<char>(b),
+              static_cast<char>(c), static_cast<char>(d) };
+            for (std::size_t n = 1; n <= 4; ++n)
+            {
+              if (same_decoding(s, s + n) && same_errors(s, s + n))
+                continue;
+              if (++failures <= 10)
+                cout << "  mismatch for " << hex_string(string(s, n)) << endl;
+            }
+          }
+    BOOST_TEST_EQ(failures, 0);
+
+    cout << "  exhaustive_test done" << endl;
+  }
+
+  void corpus_test()
+  {
+    cout << "corpus_test" << endl;
+
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      const string& s = bench::get_corpus(static_cast<bench::mix>(m), 4096).utf8;
+      BOOST_TEST(same_decoding(s.data(), s.data() + s.size()));
+      BOOST_TEST(same_errors(s.data(), s.data() + s.size()));
+
+      //  non-contiguous input does not take the SWAR path
+      std::list<char> list(s.cbegin(), s.cend());
+      BOOST_TEST(same_decoding(list.cbegin(), list.cend()));
+      BOOST_TEST(same_errors(list.cbegin(), list.cend()));
+    }
+
+    cout << "  corpus_test done" << endl;
+  }
+}
+
+int main()
+{
+  exhaustive_test();
+  corpus_test();
+
+  return boost::report_errors();
+}
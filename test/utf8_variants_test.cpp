@@ -0,0 +1,202 @@
+﻿//  unicode/test/utf8_variants_test.cpp  -----------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/utf8_variants.hpp>
+#include <iterator>
+#include <list>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  //  a NUL, an unpaired high and low surrogate, a pair, and the code points around them
+  const u16string u16s{ u'a', 0, 0xD800, u'b', 0xDFFF, 0xD83D, 0xDE00, 0xE000, 0xDBFF };
+  const u32string u32s{ U'a', 0, 0xD800, U'b', 0xDFFF, 0x1F600, 0xE000, 0xDBFF };
+  const string wtf8s("a\0\xED\xA0\x80" "b\xED\xBF\xBF\xF0\x9F\x98\x80\xEE\x80\x80"
+    "\xED\xAF\xBF", 19);
+  const string cesu8s("a\0\xED\xA0\x80" "b\xED\xBF\xBF\xED\xA0\xBD\xED\xB8\x80"
+    "\xEE\x80\x80\xED\xAF\xBF", 21);
+  const string mutf8s("a\xC0\x80\xED\xA0\x80" "b\xED\xBF\xBF\xED\xA0\xBD\xED\xB8\x80"
+    "\xEE\x80\x80\xED\xAF\xBF", 22);
+
+  template <class From, class To, class Input>
+  std::basic_string<typename To::value_type> recode_ptr(const Input& in)
+  {
+    std::basic_string<typename To::value_type> out;
+    recode<From, To>(in.data(), in.data() + in.size(), std::back_inserter(out));
+    return out;
+  }
+
+  template <class From, class To, class Input>
+  std::basic_string<typename To::value_type> recode_list(const Input& in)
+  {
+    std::list<typename Input::value_type> l(in.cbegin(), in.cend());
+    std::basic_string<typename To::value_type> out;
+    recode<From, To>(l.cbegin(), l.cend(), std::back_inserter(out));
+    return out;
+  }
+
+  template <class Encoding>
+  void encoding_test(const string& octets)
+  {
+    BOOST_TEST_EQ(to_string<Encoding>(u16s), octets);
+    BOOST_TEST_EQ(to_string<Encoding>(u32s), octets);
+    BOOST_TEST_EQ((recode_list<utf16, Encoding>(u16s)), octets);
+    BOOST_TEST_EQ((recode_list<utf32, Encoding>(u32s)), octets);
+
+    BOOST_TEST((recode_ptr<Encoding, utf16>(octets)) == u16s);
+    BOOST_TEST((recode_list<Encoding, utf16>(octets)) == u16s);
+    BOOST_TEST((recode_ptr<Encoding, utf32>(octets)) == u32s);
+    BOOST_TEST((recode_list<Encoding, utf32>(octets)) == u32s);
+
+    const wstring ws(u32s.cbegin(), u32s.cend());
+    if (sizeof(wchar_t) == 4)
+    {
+      BOOST_TEST_EQ(to_string<Encoding>(ws), octets);
+      BOOST_TEST((recode_ptr<Encoding, wide>(octets)) == ws);
+    }
+  }
+
+  void encoding_test()
+  {
+    cout << "encoding_test" << endl;
+
+    encoding_test<wtf8>(wtf8s);
+    encoding_test<cesu8>(cesu8s);
+    encoding_test<mutf8>(mutf8s);
+
+    //  from one to another
+    BOOST_TEST_EQ((recode_ptr<wtf8, cesu8>(wtf8s)), cesu8s);
+    BOOST_TEST_EQ((recode_ptr<cesu8, mutf8>(cesu8s)), mutf8s);
+    BOOST_TEST_EQ((recode_ptr<mutf8, wtf8>(mutf8s)), wtf8s);
+
+    //  UTF-8 is the same, but for what cesu8 and mutf8 encode otherwise
+    const string u8s(u8"a\0é日本\U0001F600z", 15);
+    BOOST_TEST_EQ(to_string<wtf8>(u8s), u8s);
+    BOOST_TEST_EQ(to_string<cesu8>(u8s),
+      string("a\0é日本\xED\xA0\xBD\xED\xB8\x80z", 17));
+    BOOST_TEST_EQ(to_string<mutf8>(u8s),
+      string("a\xC0\x80" "é日本\xED\xA0\xBD\xED\xB8\x80z", 18));
+    BOOST_TEST_EQ((recode_ptr<wtf8, utf8>(u8s)), u8s);
+    BOOST_TEST_EQ((recode_ptr<cesu8, utf8>(to_string<cesu8>(u8s))), u8s);
+    BOOST_TEST_EQ((recode_ptr<mutf8, utf8>(to_string<mutf8>(u8s))), u8s);
+
+    //  each decodes all of UTF-8, and a surrogate pair in separate sequences
+    BOOST_TEST((recode_ptr<cesu8, utf32>(u8s)) == u32string(U"a\0é日本\U0001F600z", 7));
+    const string halves("\xED\xA0\xBD\xED\xB8\x80");
+    BOOST_TEST((recode_ptr<wtf8, utf16>(halves)) == u"\U0001F600");
+    BOOST_TEST((recode_ptr<wtf8, utf32>(halves)) == u32string({ 0xD83D, 0xDE00 }));
+
+    cout << "  encoding_test done" << endl;
+  }
+
+  void error_test()
+  {
+    cout << "error_test" << endl;
+
+    //  ill-formed input is replaced as recode() from UTF-8 replaces it
+    BOOST_TEST((recode_ptr<wtf8, utf32>(string("a\xFF" "b"))) == U"a�b");
+    BOOST_TEST((recode_ptr<mutf8, utf32>(string("\xC0"))) == U"�");
+    BOOST_TEST((recode_ptr<cesu8, utf16>(string("\xED\xA0"))) == u"�");
+    BOOST_TEST((recode_list<mutf8, utf16>(string("\xC0\x81"))) == u"�");
+    BOOST_TEST_EQ(to_string<wtf8>(string("a\xFF")), "a\xEF\xBF\xBD");
+    BOOST_TEST_EQ(to_string<cesu8>(u32string(1, char32_t(0x110000))), "\xEF\xBF\xBD");
+
+    //  UTF-8 cannot represent a surrogate code point
+    BOOST_TEST_EQ((recode_ptr<wtf8, utf8>(wtf8s)),
+      string("a\0\xEF\xBF\xBD" "b\xEF\xBF\xBD\xF0\x9F\x98\x80\xEE\x80\x80"
+        "\xEF\xBF\xBD", 19));
+    string s;
+    recode<cesu8, utf8>(cesu8s.data(), cesu8s.data() + cesu8s.size(),
+      std::back_inserter(s), []() { return "?"; });
+    BOOST_TEST_EQ(s, string("a\0?b?\xF0\x9F\x98\x80\xEE\x80\x80?", 13));
+
+    cout << "  error_test done" << endl;
+  }
+
+  //  a pseudo-random mix of ASCII, NUL, BMP code points, pairs, and unpaired
+  //  surrogates
+  u16string random_utf16(std::size_t n, unsigned seed)
+  {
+    u16string s;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+      seed = seed * 1103515245u + 12345u;
+      const unsigned r = (seed >> 8) & 0xFFFFu;
+      switch (seed >> 28)
+      {
+      case 0: s += char16_t(0); break;
+      case 1: s += char16_t(0xD800u + (r & 0x7FFu)); break;
+      case 2: s += char16_t(0xD800u + (r & 0x3FFu)); s += char16_t(0xDC00u + (r >> 6));
+        break;
+      case 3: case 4: s += char16_t(r < 0xD800u || r >= 0xE000u ? r : 0xFFFDu); break;
+      default: s += char16_t(0x20u + (r & 0x5Fu));
+      }
+    }
+    return s;
+  }
+
+  template <class Encoding>
+  void round_trip_test(const u16string& u16)
+  {
+    const string octets = to_string<Encoding>(u16);
+    BOOST_TEST((recode_ptr<Encoding, utf16>(octets)) == u16);
+    BOOST_TEST_EQ((recode_list<utf16, Encoding>(u16)), octets);
+    BOOST_TEST((recode_list<Encoding, utf16>(octets)) == u16);
+    BOOST_TEST_EQ((recode_ptr<utf32, Encoding>(recode_ptr<Encoding, utf32>(octets))),
+      octets);
+    if (boost::unicode::detail::variant_traits<Encoding>::nul)
+      BOOST_TEST_EQ(octets.find('\0'), string::npos);
+  }
+
+  void round_trip_test()
+  {
+    cout << "round_trip_test" << endl;
+
+    for (unsigned seed = 1; seed <= 64; ++seed)
+    {
+      const u16string u16 = random_utf16(seed * 7, seed);
+      round_trip_test<wtf8>(u16);
+      round_trip_test<cesu8>(u16);
+      round_trip_test<mutf8>(u16);
+    }
+
+    //  well-formed text is UTF-8 in wtf8; the unpaired surrogates of the errors corpus
+    //  are kept
+    for (int m = 0; m <= static_cast<int>(bench::mix::errors); ++m)
+    {
+      const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), 4096);
+      if (m != static_cast<int>(bench::mix::errors))
+        BOOST_TEST_EQ(to_string<wtf8>(c.utf16), c.utf8);
+      round_trip_test<wtf8>(c.utf16);
+      round_trip_test<cesu8>(c.utf16);
+      round_trip_test<mutf8>(c.utf16);
+    }
+
+    cout << "  round_trip_test done" << endl;
+  }
+}
+
+int main()
+{
+  encoding_test();
+  error_test();
+  round_trip_test();
+
+  return boost::report_errors();
+}
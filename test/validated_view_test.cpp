@@ -0,0 +1,105 @@
+﻿//  unicode/test/validated_view_test.cpp  ----------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+#include <iostream>
+using std::cout;
+using std::endl;
+#include "../bench/corpus.hpp"
+#include <boost/unicode/validated_view.hpp>
+#include <string>
+#define BOOST_LIGHTWEIGHT_TEST_OSTREAM std::cout
+#include <boost/core/lightweight_test.hpp>
+
+using namespace boost::unicode;
+using std::string;
+using std::u16string;
+using std::u32string;
+using std::wstring;
+
+namespace
+{
+  void validate_test()
+  {
+    cout << "validate_test" << endl;
+
+    const string s(u8"a日本\U0001F600");
+    validated_view<utf8> v = validate(s);
+    BOOST_TEST_EQ(v.size(), s.size());
+    BOOST_TEST(v.data() == s.data());
+
+    //  the well-formed prefix
+    BOOST_TEST_EQ(validate(string("ab\xFF" "cd")).size(), 2u);
+    BOOST_TEST_EQ(validate(string("ab\xE6\x97")).size(), 2u);
+    BOOST_TEST_EQ(validate(u16string{ u'a', 0xD800 }).size(), 1u);
+    BOOST_TEST_EQ(validate(u16string{ u'a', 0xD83D, 0xDE00 }).size(), 3u);
+    BOOST_TEST_EQ(validate(u32string{ U'a', 0x110000 }).size(), 1u);
+    BOOST_TEST_EQ(validate(wstring(L"a日本")).size(), 3u);
+    BOOST_TEST(validate(string()).empty());
+
+    validated_view<utf16> w(u"abc", assume_valid);
+    BOOST_TEST_EQ(w.size(), 3u);
+    BOOST_TEST(validated_view<utf32>().empty());
+
+    cout << "  validate_test done" << endl;
+  }
+
+  //  the same as to_string() of the view, for every UTF pair
+  template <class From>
+  void to_string_test(const validated_view<From>& v)
+  {
+    BOOST_TEST(to_string<utf8>(v) == to_string<utf8>(v.view()));
+    BOOST_TEST(to_string<utf16>(v) == to_string<utf16>(v.view()));
+    BOOST_TEST(to_string<utf32>(v) == to_string<utf32>(v.view()));
+    BOOST_TEST(to_string<wide>(v) == to_string<wide>(v.view()));
+  }
+
+  void to_string_test()
+  {
+    cout << "to_string_test" << endl;
+
+    for (int m = 0; m < static_cast<int>(bench::mix::errors); ++m)
+    {
+      for (std::size_t n : { 0, 1, 7, 64, 4096 })
+      {
+        const bench::corpus& c = bench::get_corpus(static_cast<bench::mix>(m), n);
+        to_string_test(validate(c.utf8));
+        to_string_test(validate(c.utf16));
+        to_string_test(validate(c.utf32));
+        to_string_test(validate(c.wide));
+        BOOST_TEST_EQ(validate(c.utf8).size(), c.utf8.size());
+      }
+    }
+
+    //  the errors corpus, up to its first error
+    const bench::corpus& c = bench::get_corpus(bench::mix::errors, 4096);
+    to_string_test(validate(c.utf8));
+    to_string_test(validate(c.utf16));
+
+    cout << "  to_string_test done" << endl;
+  }
+
+  void to_view_test()
+  {
+    cout << "to_view_test" << endl;
+
+    const u16string s(u"a日本\U0001F600");
+    validated_view<utf16> v = to_view<utf16>(validate(s));
+    BOOST_TEST(v.data() == s.data());
+    BOOST_TEST_EQ(v.size(), s.size());
+
+    cout << "  to_view_test done" << endl;
+  }
+}
+
+int main()
+{
+  validate_test();
+  to_string_test();
+  to_view_test();
+
+  return boost::report_errors();
+}
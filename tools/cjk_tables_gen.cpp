@@ -0,0 +1,418 @@
+﻿//  unicode/tools/cjk_tables_gen.cpp  --------------------------------------------------//
+
+//  © Copyright Beman Dawes 2016
+
+//  Distributed under the Boost Software License, Version 1.0.
+//  See http://www.boost.org/LICENSE_1_0.txt
+
+//  Writes boost/unicode/detail/cjk_tables.hpp, the tables behind the gb18030,
+//  shift_jis, big5, and euc_kr encodings of cjk_encoding.hpp, by asking the iconv()
+//  of the machine it runs on how each octet sequence decodes and each code point
+//  encodes. Run with the path of the header to write; the generated tables match that
+//  iconv() exactly, and cjk_encoding_test checks the library against it.
+//
+//  For each encoding, the tables are:
+//
+//    single    the code point of each octet, cjk_more if it starts a longer sequence,
+//              or cjk_none
+//    row_of    for each lead octet, its row of rows, or 0xFF
+//    rows      the code point of each two-octet sequence, a row per lead octet and a
+//              column per trail octet in [trail_first, trail_last]; cjk_more if it is
+//              a supplementary code point, found in wide
+//    wide      the two-octet sequences for supplementary code points, each also the
+//              way that code point encodes
+//    overrides the BMP code points that encode other than as the first one- or
+//              two-octet sequence, in octet order, that decodes to them: to another
+//              such sequence, to cjk_none if to none of them, or to cjk_unmapped
+//    runs      for GB18030 only, the four-octet sequences up to the end of the BMP, as
+//              runs of consecutive code points at consecutive four-octet indexes, in
+//              index order, which GB 18030-2005's U+E7C7 puts out of code point order
+//
+//  The encoder is built from these when first used, so only the decoder is written out.
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <iconv.h>
+#include <boost/detail/lightweight_main.hpp>
+
+using std::cout;
+using std::cerr;
+using std::endl;
+using std::string;
+
+namespace
+{
+  //  outside Unicode, since U+FFFE and U+FFFF have four-octet GB18030 sequences;
+  //  written as cjk_more and cjk_none
+  const char32_t lead = 0x110000;
+  const char32_t none = 0x110001;
+
+  struct encoding
+  {
+    const char* name;   // the library's
+    const char* iconv;  // iconv()'s
+    bool        four;   // has GB18030 four-octet sequences
+  };
+
+  const encoding encodings[] =
+  {
+    { "gb18030",   "GB18030", true },
+    { "shift_jis", "CP932",   false },
+    { "big5",      "BIG5",    false },
+    { "euc_kr",    "EUC-KR",  false },
+  };
+
+  //  decodes s; returns the code point, lead if s is a valid start, or none
+  char32_t decode(iconv_t cd, const string& s)
+  {
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    char* in = const_cast<char*>(s.data());
+    std::size_t in_left = s.size();
+    char32_t out[4];
+    char* o = reinterpret_cast<char*>(out);
+    std::size_t o_left = sizeof(out);
+    std::size_t r = iconv(cd, &in, &in_left, &o, &o_left);
+    int err = errno;
+    std::size_t n = (sizeof(out) - o_left) / sizeof(char32_t);
+    if (r != std::size_t(-1) && in_left == 0 && n == 1)
+      return out[0];
+    if (r == std::size_t(-1) && err == EINVAL && n == 0)
+      return lead;
+    return none;
+  }
+
+  //  encodes cp; returns the octets, or an empty string if cp is not mapped
+  string encode(iconv_t cd, char32_t cp)
+  {
+    iconv(cd, nullptr, nullptr, nullptr, nullptr);
+    char* in = reinterpret_cast<char*>(&cp);
+    std::size_t in_left = sizeof(cp);
+    char out[16];
+    char* o = out;
+    std::size_t o_left = sizeof(out);
+    if (iconv(cd, &in, &in_left, &o, &o_left) == std::size_t(-1))
+      return string();
+    return string(out, o);
+  }
+
+  //  the four-octet sequence at GB18030 index i
+  string four_octets(std::uint32_t i)
+  {
+    string s(4, '\0');
+    s[3] = static_cast<char>(0x30 + i % 10);   i /= 10;
+    s[2] = static_cast<char>(0x81 + i % 126);  i /= 126;
+    s[1] = static_cast<char>(0x30 + i % 10);   i /= 10;
+    s[0] = static_cast<char>(0x81 + i);
+    return s;
+  }
+
+  //  a char16_t string literal of v, split into lines
+  string literal(const std::vector<char32_t>& v)
+  {
+    std::ostringstream os;
+    os << "\n      u\"";
+    std::size_t column = 9;
+    for (char32_t c : v)
+    {
+      c = c == lead ? 0xFFFE : c == none ? 0xFFFF : c;
+      if (column > 80)
+      {
+        os << "\"\n      u\"";
+        column = 9;
+      }
+      if (c < 0xA0 || c == 0xFEFF || c >= 0xFFF0 || (c >= 0xD800 && c < 0xE000)
+        || (c >= 0x2000 && c <= 0x206F) || (c >= 0xE000 && c < 0xF900))
+      {
+        //  controls, ASCII (to avoid trigraphs and escapes), invisible characters,
+        //  and the private use area, as universal character names
+        char buf[8];
+        std::snprintf(buf, sizeof(buf), "\\u%04X", static_cast<unsigned>(c));
+        os << buf;
+        column += 6;
+      }
+      else
+      {
+        //  anything else as itself, in UTF-8
+        if (c < 0x800)
+          os << char(0xC0 | (c >> 6)) << char(0x80 | (c & 0x3F));
+        else
+          os << char(0xE0 | (c >> 12)) << char(0x80 | ((c >> 6) & 0x3F))
+             << char(0x80 | (c & 0x3F));
+        column += 1;
+      }
+    }
+    os << "\"";
+    return os.str();
+  }
+
+  string hex(unsigned v, int digits)
+  {
+    char buf[16];
+    std::snprintf(buf, sizeof(buf), "0x%0*X", digits, v);
+    return buf;
+  }
+
+  bool generate(const encoding& e, std::ostream& os)
+  {
+    iconv_t dec = iconv_open("UTF-32LE", e.iconv);
+    iconv_t enc = iconv_open(e.iconv, "UTF-32LE");
+    if (dec == iconv_t(-1) || enc == iconv_t(-1))
+    {
+      cerr << "iconv() does not know " << e.iconv << endl;
+      return false;
+    }
+
+    //  decoder: single octets, then two-octet rows
+    std::vector<char32_t> single(256);
+    for (int b = 0; b < 256; ++b)
+    {
+      single[b] = decode(dec, string(1, char(b)));
+      if (single[b] >= 0xFFFE && single[b] < lead)
+      {
+        cerr << e.iconv << ": one octet outside the table" << endl;
+        return false;
+      }
+    }
+
+    std::map<int, std::vector<char32_t>> pairs;  // lead octet to its 256 trails
+    std::vector<std::pair<std::uint32_t, char32_t>> wide;
+    int trail_first = 0xFF, trail_last = 0;
+    for (int b = 0; b < 256; ++b)
+    {
+      if (single[b] != lead)
+        continue;
+      std::vector<char32_t> row(256, none);
+      bool any = false;
+      for (int t = 0; t < 256; ++t)
+      {
+        char32_t c = decode(dec, string(1, char(b)) + char(t));
+        if (c == lead)
+          continue;  // a four-octet sequence
+        if (c > 0xFFFF && c < lead)
+        {
+          const std::uint32_t code = static_cast<std::uint32_t>(b << 8 | t);
+          if (encode(enc, c) != string(1, char(b)) + char(t))
+          {
+            cerr << e.iconv << ": U+" << std::hex << c << " does not round trip" << endl;
+            return false;
+          }
+          wide.push_back(std::make_pair(code, c));
+          c = lead;
+        }
+        else if (c == 0xFFFE || c == 0xFFFF)
+        {
+          cerr << e.iconv << ": two octets decode to a noncharacter" << endl;
+          return false;
+        }
+        row[t] = c;
+        if (c != none)
+        {
+          any = true;
+          trail_first = t < trail_first ? t : trail_first;
+          trail_last = t > trail_last ? t : trail_last;
+        }
+      }
+      if (any)
+        pairs[b] = row;
+    }
+
+    //  GB18030 four-octet sequences up to the end of the BMP, as runs
+    struct run { std::uint32_t index; char32_t cp; std::uint32_t length; };
+    std::vector<run> runs;
+    if (e.four)
+    {
+      for (std::uint32_t i = 0; i < 39420; ++i)
+      {
+        char32_t c = decode(dec, four_octets(i));
+        if (c == none || c == lead)
+          continue;
+        if (!runs.empty() && runs.back().index + runs.back().length == i
+          && runs.back().cp + runs.back().length == c && runs.back().length < 0xFFFF)
+          ++runs.back().length;
+        else
+          runs.push_back(run{ i, c, 1 });
+      }
+    }
+
+    //  the encoder the library builds: the first sequence in octet order, then runs
+    std::vector<std::uint32_t> built(0x10000, 0xFFFFFFFF);
+    for (int b = 0; b < 256; ++b)
+      if (single[b] < lead && built[single[b]] == 0xFFFFFFFF)
+        built[single[b]] = static_cast<std::uint32_t>(b);
+    for (const auto& p : pairs)
+      for (int t = trail_first; t <= trail_last; ++t)
+        if (p.second[t] < lead && built[p.second[t]] == 0xFFFFFFFF)
+          built[p.second[t]] = static_cast<std::uint32_t>(p.first << 8 | t);
+
+    //  overrides, where iconv() encodes otherwise
+    std::vector<std::pair<char32_t, std::uint32_t>> overrides;
+    for (char32_t c = 0; c < 0x10000; ++c)
+    {
+      if (c >= 0xD800 && c < 0xE000)
+        continue;
+      string s = encode(enc, c);
+      std::uint32_t want = 0xFFFFFFFF;  // not mapped, or four octets
+      if (s.size() == 1)
+        want = static_cast<unsigned char>(s[0]);
+      else if (s.size() == 2)
+        want = static_cast<std::uint32_t>(static_cast<unsigned char>(s[0]) << 8
+          | static_cast<unsigned char>(s[1]));
+      else if (s.size() == 4 && e.four)
+      {
+        bool in_runs = false;
+        for (const run& r : runs)
+          if (c >= r.cp && c < r.cp + r.length
+            && four_octets(r.index + (c - r.cp)) == s)
+            in_runs = true;
+        if (!in_runs)
+        {
+          cerr << e.iconv << ": U+" << std::hex << c << " encodes to four octets"
+            " outside the runs" << endl;
+          return false;
+        }
+      }
+      else if (!s.empty())
+      {
+        cerr << e.iconv << ": unexpected encoding length" << endl;
+        return false;
+      }
+
+      bool in_runs = false;
+      if (e.four)
+        for (const run& r : runs)
+          if (c >= r.cp && c < r.cp + r.length)
+            in_runs = true;
+      if (want == 0xFFFFFFFF)
+        want = s.empty() && (in_runs || built[c] != 0xFFFFFFFF) ? 0xFFFE : 0xFFFF;
+      if (want != built[c] && !(want == 0xFFFF && built[c] == 0xFFFFFFFF))
+        overrides.push_back(std::make_pair(c, want));
+    }
+
+    //  write the table function
+    os << "\n  //  " << e.iconv << " as decoded and encoded by iconv(): "
+       << pairs.size() << " lead octets,\n  //  " << wide.size() << " supplementary, "
+       << overrides.size() << " overrides, " << runs.size() << " four-octet runs";
+    os << "\n\n  inline const cjk_table& " << e.name << "_table() BOOST_NOEXCEPT\n  {\n";
+
+    os << "    static constexpr char16_t single[] =" << literal(single) << ";\n\n";
+
+    os << "    static constexpr unsigned char row_of[] =\n    {";
+    int row = 0;
+    for (int b = 0; b < 256; ++b)
+    {
+      if (b % 16 == 0)
+        os << "\n      ";
+      os << (pairs.count(b) ? hex(static_cast<unsigned>(row++), 2) : string("0xFF"))
+         << (b != 255 ? "," : "");
+    }
+    os << "\n    };\n\n";
+
+    std::vector<char32_t> cells;
+    for (const auto& p : pairs)
+      for (int t = trail_first; t <= trail_last; ++t)
+        cells.push_back(p.second[t]);
+    os << "    static constexpr char16_t rows[] =" << literal(cells) << ";\n\n";
+
+    os << "    static constexpr cjk_pair wide[] =\n    {";
+    for (std::size_t i = 0; i < wide.size(); ++i)
+      os << (i % 4 == 0 ? "\n      " : " ") << "{ " << hex(wide[i].first, 4)
+         << ", " << hex(wide[i].second, 5) << " },";
+    if (wide.empty())
+      os << "\n      { 0xFFFF, 0xFFFF }";
+    os << "\n    };\n\n";
+
+    os << "    static constexpr cjk_pair overrides[] =\n    {";
+    for (std::size_t i = 0; i < overrides.size(); ++i)
+      os << (i % 4 == 0 ? "\n      " : " ") << "{ " << hex(overrides[i].second, 4)
+         << ", " << hex(overrides[i].first, 4) << " },";
+    if (overrides.empty())
+      os << "\n      { 0xFFFF, 0xFFFF }";
+    os << "\n    };\n\n";
+
+    os << "    static constexpr cjk_run runs[] =\n    {";
+    for (std::size_t i = 0; i < runs.size(); ++i)
+      os << (i % 3 == 0 ? "\n      " : " ") << "{ " << runs[i].index << ", "
+         << hex(runs[i].cp, 4) << ", " << runs[i].length << " },";
+    if (runs.empty())
+      os << "\n      { 0, 0xFFFF, 0 }";
+    os << "\n    };\n\n";
+
+    os << "    static constexpr cjk_table table =\n"
+       << "      { single, row_of, " << hex(static_cast<unsigned>(trail_first), 2) << ", "
+       << hex(static_cast<unsigned>(trail_last), 2) << ", rows,\n"
+       << "        wide, " << wide.size() << ", overrides, " << overrides.size()
+       << ", runs, " << runs.size() << " };\n    return table;\n  }\n";
+
+    cout << e.iconv << ": " << pairs.size() << " lead octets, trails "
+         << hex(static_cast<unsigned>(trail_first), 2) << "-"
+         << hex(static_cast<unsigned>(trail_last), 2) << ", " << overrides.size()
+         << " overrides, " << runs.size() << " runs" << endl;
+    iconv_close(dec);
+    iconv_close(enc);
+    return true;
+  }
+}
+
+int cpp_main(int argc, char* argv[])
+{
+  if (argc != 2)
+  {
+    cout << "Invoke: cjk_tables_gen <path of cjk_tables.hpp>" << endl;
+    return 1;
+  }
+
+  std::ostringstream os;
+  os << "\xEF\xBB\xBF//  boost/unicode/detail/cjk_tables.hpp  "
+        "-----------------------------------------------//\n\n"
+        "//  \xC2\xA9 Copyright Beman Dawes 2016\n\n"
+        "//  Distributed under the Boost Software License, Version 1.0.\n"
+        "//  See http://www.boost.org/LICENSE_1_0.txt\n\n"
+        "//  Generated by tools/cjk_tables_gen.cpp; do not edit.\n\n"
+        "#if !defined(BOOST_UNICODE_DETAIL_CJK_TABLES_HPP)\n"
+        "#define BOOST_UNICODE_DETAIL_CJK_TABLES_HPP\n\n"
+        "#include <boost/config.hpp>\n#include <cstddef>\n#include <cstdint>\n\n"
+        "namespace boost\n{\nnamespace unicode\n{\nnamespace detail\n{\n"
+        R"(  const char16_t cjk_more = 0xFFFE;      // see cjk_table
+  const char16_t cjk_none = 0xFFFF;      // not mapped
+  const char16_t cjk_unmapped = 0xFFFE;  // an override: not mapped at all
+
+  struct cjk_pair { char16_t code; char32_t cp; };
+  struct cjk_run { std::uint32_t index; char16_t cp; char16_t length; };
+
+  struct cjk_table
+  {
+    const char16_t*      single;          // each octet's code point, cjk_more if a lead
+    const unsigned char* row_of;          // each lead octet's row in rows, or 0xFF
+    unsigned char        trail_first;     // the columns of rows
+    unsigned char        trail_last;
+    const char16_t*      rows;            // code points, cjk_more if in wide, cjk_none
+    const cjk_pair*      wide;            // supplementary code points, sorted by code
+    std::size_t          wide_size;
+    const cjk_pair*      overrides;       // encodings other than the inverted decoder's,
+    std::size_t          overrides_size;  //   sorted by code point
+    const cjk_run*       runs;            // GB18030 four-octet sequences, by index
+    std::size_t          runs_size;
+  };
+)";
+  for (const encoding& e : encodings)
+    if (!generate(e, os))
+      return 1;
+  os << "\n}  // namespace detail\n}  // namespace unicode\n}  // namespace boost\n\n"
+        "#endif  // BOOST_UNICODE_DETAIL_CJK_TABLES_HPP\n";
+
+  std::ofstream out(argv[1], std::ios_base::binary);
+  out << os.str();
+  if (!out)
+  {
+    cerr << "Could not write " << argv[1] << endl;
+    return 1;
+  }
+  return 0;
+}